@@ -3,261 +3,505 @@
 #include <fbjni/fbjni.h>
 #include <ReactCommon/CallInvokerHolder.h>
 #include <ReactCommon/CallInvoker.h>
-#include <jsi/JSIDynamic.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "JSIPureStorageHostObject.h"
+#include "PureStorageEngine.h"
+#include "PureStorageTurboModule.h"
+#include "SharedEngine.h"
+#include "StorageBackend.h"
 
 using namespace facebook::jsi;
 using namespace facebook::react;
 using namespace facebook::jni;
 
-// Helper class for JSI hosting
-class JSIPureStorageHostObject : public HostObject {
+namespace {
+
+// Clears the Java exception left by the last JNI call, if any. Any further
+// call with one pending aborts the process, so the backend reports it as a
+// failed (false or empty) result instead.
+bool clearException(JNIEnv* env) {
+    if (!env->ExceptionCheck()) {
+        return false;
+    }
+    env->ExceptionClear();
+    return true;
+}
+
+std::string toStdString(JNIEnv* env, jstring string) {
+    if (string == nullptr) {
+        return std::string();
+    }
+
+    const char* chars = env->GetStringUTFChars(string, nullptr);
+    if (chars == nullptr) {
+        clearException(env);
+        return std::string();
+    }
+    std::string result(chars);
+    env->ReleaseStringUTFChars(string, chars);
+    return result;
+}
+
+// A number the Java side passes as a nullable string; null reads as `absent`
+int64_t longElement(JNIEnv* env, jobjectArray array, jsize index, int64_t absent) {
+    auto element = (jstring)env->GetObjectArrayElement(array, index);
+    if (element == nullptr) {
+        clearException(env);
+        return absent;
+    }
+    int64_t result = std::stoll(toStdString(env, element));
+    env->DeleteLocalRef(element);
+    return result;
+}
+
+// A string element of an array from the Java side; null reads as empty
+std::string stringElement(JNIEnv* env, jobjectArray array, jsize index) {
+    auto element = (jstring)env->GetObjectArrayElement(array, index);
+    if (element == nullptr) {
+        clearException(env);
+        return std::string();
+    }
+    std::string result = toStdString(env, element);
+    env->DeleteLocalRef(element);
+    return result;
+}
+
+// Storage backend that calls into the Java JSIPureStorageModule (SharedPreferences).
+// Called from the JS thread and from the engine worker, which is attached on first use.
+class AndroidStorageBackend : public pure_storage::StorageBackend {
 private:
     jni::global_ref<jobject> javaPureStorage_;
-    jni::alias_ref<jobject> callInvoker_;
-    jclass storageClass_;
-    JNIEnv *env_;
+    jmethodID setItemMethod_;
+    jmethodID getItemMethod_;
+    jmethodID statItemMethod_;
+    jmethodID removeItemMethod_;
+    jmethodID clearMethod_;
+    jmethodID getAllKeysMethod_;
+    jmethodID hasKeyMethod_;
+    jmethodID shredNamespaceMethod_;
+    jmethodID getKeyHashSecretMethod_;
+    jmethodID getStartupKeysMethod_;
+    jmethodID setStartupKeysMethod_;
+    jmethodID beginBatchMethod_;
+    jmethodID commitBatchMethod_;
 
 public:
-    JSIPureStorageHostObject(jni::alias_ref<jobject> javaPureStorage, jni::alias_ref<jobject> jsCallInvoker)
+    explicit AndroidStorageBackend(jni::alias_ref<jobject> javaPureStorage)
         : javaPureStorage_(jni::make_global(javaPureStorage)) {
-        callInvoker_ = jsCallInvoker;
-        env_ = jni::Environment::current();
-        storageClass_ = env_->GetObjectClass(javaPureStorage_.get());
+        // Method IDs stay valid on every thread, unlike the JNIEnv
+        JNIEnv* env = jni::Environment::current();
+        jclass storageClass = env->GetObjectClass(javaPureStorage_.get());
+        setItemMethod_ = env->GetMethodID(storageClass, "writeItemSync", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;ZLjava/lang/String;ZIJJJJLjava/lang/String;)Z");
+        getItemMethod_ = env->GetMethodID(storageClass, "getRawItemSync", "(Ljava/lang/String;)[Ljava/lang/String;");
+        statItemMethod_ = env->GetMethodID(storageClass, "statItemSync", "(Ljava/lang/String;)[Ljava/lang/String;");
+        removeItemMethod_ = env->GetMethodID(storageClass, "removeItemSync", "(Ljava/lang/String;)Z");
+        clearMethod_ = env->GetMethodID(storageClass, "clearSync", "()Z");
+        getAllKeysMethod_ = env->GetMethodID(storageClass, "getAllKeysSync", "()[Ljava/lang/String;");
+        hasKeyMethod_ = env->GetMethodID(storageClass, "hasKeySync", "(Ljava/lang/String;)Z");
+        shredNamespaceMethod_ = env->GetMethodID(storageClass, "shredNamespaceSync", "(Ljava/lang/String;)Z");
+        getKeyHashSecretMethod_ = env->GetMethodID(storageClass, "getKeyHashSecretSync", "(Ljava/lang/String;)[B");
+        getStartupKeysMethod_ = env->GetMethodID(storageClass, "getStartupKeysSync", "()[Ljava/lang/String;");
+        setStartupKeysMethod_ = env->GetMethodID(storageClass, "setStartupKeysSync", "([Ljava/lang/String;)V");
+        beginBatchMethod_ = env->GetMethodID(storageClass, "beginBatchSync", "()V");
+        commitBatchMethod_ = env->GetMethodID(storageClass, "commitBatchSync", "()Z");
+        env->DeleteLocalRef(storageClass);
     }
 
-    // Main JSI methods
-    Value get(Runtime& runtime, const PropNameID& propName) override {
-        std::string name = propName.utf8(runtime);
-        
-        // setItem
-        if (name == "setItemSync") {
-            return Function::createFromHostFunction(
-                runtime,
-                PropNameID::forAscii(runtime, "setItemSync"),
-                4,  // Key, type, value, encrypted
-                [this](Runtime& runtime, const Value& thisVal, const Value* args, size_t count) -> Value {
-                    if (count < 4) {
-                        return Value(false);
-                    }
-                    
-                    std::string key = args[0].asString(runtime).utf8(runtime);
-                    std::string type = args[1].asString(runtime).utf8(runtime);
-                    std::string value = args[2].asString(runtime).utf8(runtime);
-                    bool encrypted = args[3].getBool();
-                    
-                    jmethodID method = env_->GetMethodID(storageClass_, "setItemSync", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Z)Z");
-                    jstring jKey = env_->NewStringUTF(key.c_str());
-                    jstring jType = env_->NewStringUTF(type.c_str());
-                    jstring jValue = env_->NewStringUTF(value.c_str());
-                    
-                    jboolean result = env_->CallBooleanMethod(
-                        javaPureStorage_.get(),
-                        method,
-                        jKey,
-                        jType,
-                        jValue,
-                        encrypted
-                    );
-                    
-                    env_->DeleteLocalRef(jKey);
-                    env_->DeleteLocalRef(jType);
-                    env_->DeleteLocalRef(jValue);
-                    
-                    return Value(result == JNI_TRUE);
-                }
+    bool setItem(const std::string& key, const pure_storage::StoredItem& item, const pure_storage::WriteOptions& options) override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        // A string that can't be allocated leaves an OutOfMemoryError pending,
+        // so nothing else is allocated or called after one fails
+        jstring jKey = nullptr;
+        jstring jType = nullptr;
+        jstring jValue = nullptr;
+        jstring jKeyNamespace = nullptr;
+        jstring jAttributes = nullptr;
+        bool allocated = (jKey = env->NewStringUTF(key.c_str())) != nullptr &&
+                         (jType = env->NewStringUTF(item.type.c_str())) != nullptr &&
+                         (jValue = env->NewStringUTF(item.value.c_str())) != nullptr &&
+                         (!options.encrypted || (jKeyNamespace = env->NewStringUTF(options.keyNamespace.c_str())) != nullptr) &&
+                         (item.attributes.empty() || (jAttributes = env->NewStringUTF(item.attributes.c_str())) != nullptr);
+
+        jboolean result = JNI_FALSE;
+        if (!allocated) {
+            clearException(env);
+        } else {
+            result = env->CallBooleanMethod(
+                javaPureStorage_.get(),
+                setItemMethod_,
+                jKey,
+                jType,
+                jValue,
+                options.encrypted,
+                jKeyNamespace,
+                options.compressed,
+                static_cast<jint>(options.durability),
+                static_cast<jlong>(item.expiresAt),
+                static_cast<jlong>(item.createdAt),
+                static_cast<jlong>(item.modifiedAt),
+                static_cast<jlong>(item.size),
+                jAttributes
             );
+            if (clearException(env)) {
+                result = JNI_FALSE;
+            }
         }
-        
-        // getItem
-        else if (name == "getItemSync") {
-            return Function::createFromHostFunction(
-                runtime,
-                PropNameID::forAscii(runtime, "getItemSync"),
-                1,  // Key
-                [this](Runtime& runtime, const Value& thisVal, const Value* args, size_t count) -> Value {
-                    if (count < 1) {
-                        return Value::null();
-                    }
-                    
-                    std::string key = args[0].asString(runtime).utf8(runtime);
-                    
-                    jmethodID method = env_->GetMethodID(storageClass_, "getItemSync", "(Ljava/lang/String;)Lcom/facebook/react/bridge/ReadableMap;");
-                    jstring jKey = env_->NewStringUTF(key.c_str());
-                    
-                    jobject result = env_->CallObjectMethod(
-                        javaPureStorage_.get(),
-                        method,
-                        jKey
-                    );
-                    
-                    env_->DeleteLocalRef(jKey);
-                    
-                    if (result == nullptr) {
-                        return Value::null();
-                    }
-                    
-                    // Convert ReadableMap to JSI object
-                    auto resultObj = jni::adopt_local(result);
-                    auto resultMap = jni::static_ref_cast<facebook::react::ReadableMap::javaobject>(resultObj);
-                    auto dynamicFromValue = jni::static_ref_cast<facebook::react::DynamicFromValue::javaobject>(resultMap);
-                    
-                    auto jsiValueFromDynamic = dynamicFromValue->cthis()->getJSIValue(runtime);
-                    if (jsiValueFromDynamic.isObject()) {
-                        return jsiValueFromDynamic;
-                    }
-                    
-                    return Value::null();
-                }
-            );
+
+        if (jKey != nullptr) {
+            env->DeleteLocalRef(jKey);
         }
-        
-        // removeItem
-        else if (name == "removeItemSync") {
-            return Function::createFromHostFunction(
-                runtime,
-                PropNameID::forAscii(runtime, "removeItemSync"),
-                1,  // Key
-                [this](Runtime& runtime, const Value& thisVal, const Value* args, size_t count) -> Value {
-                    if (count < 1) {
-                        return Value(false);
-                    }
-                    
-                    std::string key = args[0].asString(runtime).utf8(runtime);
-                    
-                    jmethodID method = env_->GetMethodID(storageClass_, "removeItemSync", "(Ljava/lang/String;)Z");
-                    jstring jKey = env_->NewStringUTF(key.c_str());
-                    
-                    jboolean result = env_->CallBooleanMethod(
-                        javaPureStorage_.get(),
-                        method,
-                        jKey
-                    );
-                    
-                    env_->DeleteLocalRef(jKey);
-                    
-                    return Value(result == JNI_TRUE);
-                }
-            );
+        if (jType != nullptr) {
+            env->DeleteLocalRef(jType);
         }
-        
-        // clear
-        else if (name == "clearSync") {
-            return Function::createFromHostFunction(
-                runtime,
-                PropNameID::forAscii(runtime, "clearSync"),
-                0,
-                [this](Runtime& runtime, const Value& thisVal, const Value* args, size_t count) -> Value {
-                    jmethodID method = env_->GetMethodID(storageClass_, "clearSync", "()Z");
-                    
-                    jboolean result = env_->CallBooleanMethod(
-                        javaPureStorage_.get(),
-                        method
-                    );
-                    
-                    return Value(result == JNI_TRUE);
-                }
-            );
+        if (jValue != nullptr) {
+            env->DeleteLocalRef(jValue);
         }
-        
-        // getAllKeys
-        else if (name == "getAllKeysSync") {
-            return Function::createFromHostFunction(
-                runtime,
-                PropNameID::forAscii(runtime, "getAllKeysSync"),
-                0,
-                [this](Runtime& runtime, const Value& thisVal, const Value* args, size_t count) -> Value {
-                    jmethodID method = env_->GetMethodID(storageClass_, "getAllKeysSync", "()[Ljava/lang/String;");
-                    
-                    jobjectArray resultArray = (jobjectArray)env_->CallObjectMethod(
-                        javaPureStorage_.get(),
-                        method
-                    );
-                    
-                    if (resultArray == nullptr) {
-                        return Array::createWithElements(runtime);
-                    }
-                    
-                    jsize length = env_->GetArrayLength(resultArray);
-                    std::vector<Value> keys;
-                    keys.reserve(length);
-                    
-                    for (jsize i = 0; i < length; i++) {
-                        jstring jKey = (jstring)env_->GetObjectArrayElement(resultArray, i);
-                        const char* charKey = env_->GetStringUTFChars(jKey, 0);
-                        keys.push_back(String::createFromUtf8(runtime, charKey));
-                        env_->ReleaseStringUTFChars(jKey, charKey);
-                        env_->DeleteLocalRef(jKey);
-                    }
-                    
-                    env_->DeleteLocalRef(resultArray);
-                    
-                    return Array::createWithElements(runtime, keys);
-                }
-            );
+        if (jKeyNamespace != nullptr) {
+            env->DeleteLocalRef(jKeyNamespace);
         }
-        
-        // hasKey
-        else if (name == "hasKeySync") {
-            return Function::createFromHostFunction(
-                runtime,
-                PropNameID::forAscii(runtime, "hasKeySync"),
-                1,  // Key
-                [this](Runtime& runtime, const Value& thisVal, const Value* args, size_t count) -> Value {
-                    if (count < 1) {
-                        return Value(false);
-                    }
-                    
-                    std::string key = args[0].asString(runtime).utf8(runtime);
-                    
-                    jmethodID method = env_->GetMethodID(storageClass_, "hasKeySync", "(Ljava/lang/String;)Z");
-                    jstring jKey = env_->NewStringUTF(key.c_str());
-                    
-                    jboolean result = env_->CallBooleanMethod(
-                        javaPureStorage_.get(),
-                        method,
-                        jKey
-                    );
-                    
-                    env_->DeleteLocalRef(jKey);
-                    
-                    return Value(result == JNI_TRUE);
-                }
-            );
+        if (jAttributes != nullptr) {
+            env->DeleteLocalRef(jAttributes);
+        }
+
+        return result == JNI_TRUE;
+    }
+
+    bool getItem(const std::string& key, pure_storage::StoredItem& item) override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        jstring jKey = env->NewStringUTF(key.c_str());
+        if (jKey == nullptr) {
+            clearException(env);
+            return false;
         }
-        
-        // Return undefined for unknown properties
-        return Value::undefined();
+
+        auto resultArray = (jobjectArray)env->CallObjectMethod(
+            javaPureStorage_.get(),
+            getItemMethod_,
+            jKey
+        );
+
+        env->DeleteLocalRef(jKey);
+
+        if (clearException(env) || resultArray == nullptr) {
+            return false;
+        }
+
+        auto jType = (jstring)env->GetObjectArrayElement(resultArray, 0);
+        auto jValue = (jstring)env->GetObjectArrayElement(resultArray, 1);
+        item.type = toStdString(env, jType);
+        item.value = toStdString(env, jValue);
+        item.expiresAt = longElement(env, resultArray, 2, 0);
+        item.createdAt = longElement(env, resultArray, 3, 0);
+        item.modifiedAt = longElement(env, resultArray, 4, 0);
+        item.size = longElement(env, resultArray, 5, -1);
+        item.attributes = stringElement(env, resultArray, 6);
+
+        env->DeleteLocalRef(jType);
+        if (jValue != nullptr) {
+            env->DeleteLocalRef(jValue);
+        }
+        env->DeleteLocalRef(resultArray);
+
+        return true;
+    }
+
+    // Reads the record's fields in Java without decrypting or decoding its value;
+    // only the attributes are decrypted
+    bool statItem(const std::string& key, pure_storage::ItemStat& stat) override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        jstring jKey = env->NewStringUTF(key.c_str());
+        if (jKey == nullptr) {
+            clearException(env);
+            return false;
+        }
+
+        auto resultArray = (jobjectArray)env->CallObjectMethod(
+            javaPureStorage_.get(),
+            statItemMethod_,
+            jKey
+        );
+
+        env->DeleteLocalRef(jKey);
+
+        if (clearException(env) || resultArray == nullptr) {
+            return false;
+        }
+
+        auto jType = (jstring)env->GetObjectArrayElement(resultArray, 0);
+        stat.type = toStdString(env, jType);
+        stat.expiresAt = longElement(env, resultArray, 1, 0);
+        stat.createdAt = longElement(env, resultArray, 2, 0);
+        stat.modifiedAt = longElement(env, resultArray, 3, 0);
+        stat.size = longElement(env, resultArray, 4, -1);
+        stat.attributes = stringElement(env, resultArray, 5);
+
+        env->DeleteLocalRef(jType);
+        env->DeleteLocalRef(resultArray);
+
+        return true;
+    }
+
+    bool removeItem(const std::string& key) override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        jstring jKey = env->NewStringUTF(key.c_str());
+        if (jKey == nullptr) {
+            clearException(env);
+            return false;
+        }
+
+        jboolean result = env->CallBooleanMethod(
+            javaPureStorage_.get(),
+            removeItemMethod_,
+            jKey
+        );
+
+        env->DeleteLocalRef(jKey);
+
+        return !clearException(env) && result == JNI_TRUE;
+    }
+
+    bool shredNamespace(const std::string& name) override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        jstring jName = env->NewStringUTF(name.c_str());
+        if (jName == nullptr) {
+            clearException(env);
+            return false;
+        }
+
+        jboolean result = env->CallBooleanMethod(
+            javaPureStorage_.get(),
+            shredNamespaceMethod_,
+            jName
+        );
+
+        env->DeleteLocalRef(jName);
+
+        return !clearException(env) && result == JNI_TRUE;
+    }
+
+    std::string getKeyHashSecret(const std::string& name) override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        jstring jName = env->NewStringUTF(name.c_str());
+        if (jName == nullptr) {
+            clearException(env);
+            return std::string();
+        }
+
+        auto secret = (jbyteArray)env->CallObjectMethod(
+            javaPureStorage_.get(),
+            getKeyHashSecretMethod_,
+            jName
+        );
+
+        env->DeleteLocalRef(jName);
+
+        if (clearException(env) || secret == nullptr) {
+            return std::string();
+        }
+
+        std::string result(static_cast<size_t>(env->GetArrayLength(secret)), '\0');
+        env->GetByteArrayRegion(secret, 0, static_cast<jsize>(result.size()), reinterpret_cast<jbyte*>(&result[0]));
+        env->DeleteLocalRef(secret);
+
+        return result;
+    }
+
+    bool clear() override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        jboolean result = env->CallBooleanMethod(javaPureStorage_.get(), clearMethod_);
+        return !clearException(env) && result == JNI_TRUE;
+    }
+
+    std::vector<std::string> getAllKeys() override {
+        return callStringArrayMethod(getAllKeysMethod_);
+    }
+
+    bool hasKey(const std::string& key) override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        jstring jKey = env->NewStringUTF(key.c_str());
+        if (jKey == nullptr) {
+            clearException(env);
+            return false;
+        }
+
+        jboolean result = env->CallBooleanMethod(
+            javaPureStorage_.get(),
+            hasKeyMethod_,
+            jKey
+        );
+
+        env->DeleteLocalRef(jKey);
+
+        return !clearException(env) && result == JNI_TRUE;
+    }
+
+    void beginBatch() override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        env->CallVoidMethod(javaPureStorage_.get(), beginBatchMethod_);
+        clearException(env);
+    }
+
+    bool commitBatch() override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        jboolean result = env->CallBooleanMethod(javaPureStorage_.get(), commitBatchMethod_);
+        return !clearException(env) && result == JNI_TRUE;
+    }
+
+    std::vector<std::string> getStartupKeys() override {
+        return callStringArrayMethod(getStartupKeysMethod_);
+    }
+
+    void setStartupKeys(const std::vector<std::string>& keys) override {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        jclass stringClass = env->FindClass("java/lang/String");
+        if (stringClass == nullptr) {
+            clearException(env);
+            return;
+        }
+        jobjectArray jKeys = env->NewObjectArray(static_cast<jsize>(keys.size()), stringClass, nullptr);
+        env->DeleteLocalRef(stringClass);
+        if (jKeys == nullptr) {
+            clearException(env);
+            return;
+        }
+
+        for (size_t i = 0; i < keys.size(); i++) {
+            jstring jKey = env->NewStringUTF(keys[i].c_str());
+            if (jKey == nullptr) {
+                clearException(env);
+                env->DeleteLocalRef(jKeys);
+                return;
+            }
+            env->SetObjectArrayElement(jKeys, static_cast<jsize>(i), jKey);
+            env->DeleteLocalRef(jKey);
+        }
+
+        env->CallVoidMethod(javaPureStorage_.get(), setStartupKeysMethod_, jKeys);
+        clearException(env);
+
+        env->DeleteLocalRef(jKeys);
+    }
+
+private:
+    std::vector<std::string> callStringArrayMethod(jmethodID method) {
+        JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+        std::vector<std::string> strings;
+
+        auto resultArray = (jobjectArray)env->CallObjectMethod(javaPureStorage_.get(), method);
+
+        if (clearException(env) || resultArray == nullptr) {
+            return strings;
+        }
+
+        jsize length = env->GetArrayLength(resultArray);
+        strings.reserve(length);
+
+        for (jsize i = 0; i < length; i++) {
+            auto jString = (jstring)env->GetObjectArrayElement(resultArray, i);
+            if (clearException(env)) {
+                strings.clear();
+                break;
+            }
+            strings.push_back(toStdString(env, jString));
+            if (jString != nullptr) {
+                env->DeleteLocalRef(jString);
+            }
+        }
+
+        env->DeleteLocalRef(resultArray);
+
+        return strings;
     }
 };
 
-// JNI implementation
-extern "C" JNIEXPORT void JNICALL
-Java_com_purestorage_JSIPureStorageModule_nativeInstall(JNIEnv* env, jclass clazz, jobject context, jlong jsContextPtr) {
-    auto runtime = reinterpret_cast<facebook::jsi::Runtime*>(jsContextPtr);
-    auto reactContext = jni::adopt_local(context);
-    
-    // Get the ReactApplicationContext's JavaScriptContextHolder
-    jclass reactContextClass = env->FindClass("com/facebook/react/bridge/ReactApplicationContext");
-    jmethodID getJSModuleMethod = env->GetMethodID(reactContextClass, "getJSModule", 
-        "(Ljava/lang/Class;)Lcom/facebook/react/bridge/JavaScriptModule;");
-    
-    jclass jsCallInvokerHolderClass = env->FindClass("com/facebook/react/bridge/JSCallInvokerHolder");
-    jobject jsCallInvokerHolder = env->CallObjectMethod(context, getJSModuleMethod, jsCallInvokerHolderClass);
-    
-    // Create Java PureStorage module instance
+// Registers how the shared engine opens its backend: by creating the Java
+// module on the given ReactApplicationContext
+void registerBackendOpener(JNIEnv* env, jobject context) {
+    // The class is looked up here because FindClass on the worker thread
+    // only sees system classes
     jclass jsiPureStorageClass = env->FindClass("com/purestorage/JSIPureStorageModule");
     jmethodID constructor = env->GetMethodID(jsiPureStorageClass, "<init>", "(Lcom/facebook/react/bridge/ReactApplicationContext;)V");
-    jobject javaPureStorage = env->NewObject(jsiPureStorageClass, constructor, context);
-    
-    // Create the C++ host object and install it into the JS runtime
-    auto hostObject = std::make_shared<JSIPureStorageHostObject>(
-        jni::adopt_local(javaPureStorage),
-        jni::adopt_local(jsCallInvokerHolder)
-    );
-    
-    runtime->global().setProperty(
-        *runtime,
-        PropNameID::forAscii(*runtime, "JSIPureStorage"),
-        Object::createFromHostObject(*runtime, hostObject)
+    auto storageClass = jni::make_global(jni::wrap_alias(jsiPureStorageClass));
+    auto storageContext = jni::make_global(jni::wrap_alias(context));
+    env->DeleteLocalRef(jsiPureStorageClass);
+
+    // Creating the Java module loads SharedPreferences and the encryption key,
+    // so it happens on the engine worker instead of holding up JS startup
+    pure_storage::setSharedBackendOpener(
+        [storageClass, constructor, storageContext]() -> std::shared_ptr<pure_storage::StorageBackend> {
+            JNIEnv* env = jni::Environment::ensureCurrentThreadIsAttached();
+            jobject javaPureStorage = env->NewObject((jclass)storageClass.get(), constructor, storageContext.get());
+            if (javaPureStorage == nullptr) {
+                env->ExceptionClear();
+                return nullptr;
+            }
+
+            auto backend = std::make_shared<AndroidStorageBackend>(jni::wrap_alias(javaPureStorage));
+            env->DeleteLocalRef(javaPureStorage);
+            return backend;
+        }
     );
-} 
\ No newline at end of file
+}
+
+} // namespace
+
+// JNI implementation
+extern "C" JNIEXPORT void JNICALL
+Java_com_purestorage_JSIPureStorageModule_nativeInstall(JNIEnv* env, jclass clazz, jobject context, jlong jsContextPtr, jobject jsCallInvokerHolder) {
+    auto runtime = reinterpret_cast<facebook::jsi::Runtime*>(jsContextPtr);
+
+    // Get the JS thread CallInvoker used to deliver change callbacks
+    std::shared_ptr<CallInvoker> callInvoker;
+    if (jsCallInvokerHolder != nullptr) {
+        auto holder = jni::alias_ref<CallInvokerHolder::javaobject>{
+            reinterpret_cast<CallInvokerHolder::javaobject>(jsCallInvokerHolder)
+        };
+        callInvoker = holder->cthis()->getCallInvoker();
+    }
+
+    registerBackendOpener(env, context);
+    auto engine = pure_storage::sharedEngine();
+
+    // Start loading last launch's startup keys before JS asks for them
+    engine->prewarmStartupKeys();
+
+    pure_storage::installJSIPureStorage(*runtime, engine, callInvoker);
+
+    // The async API as a C++ TurboModule on the same engine. It's installed
+    // as a global rather than registered with the TurboModule manager, which
+    // would take an app-level C++ module provider, and works the same with
+    // or without the bridge.
+    if (callInvoker) {
+        auto turboModule = std::make_shared<pure_storage::PureStorageTurboModule>(engine, callInvoker);
+        runtime->global().setProperty(
+            *runtime,
+            PropNameID::forAscii(*runtime, pure_storage::PureStorageTurboModule::kModuleName),
+            Object::createFromHostObject(*runtime, turboModule)
+        );
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_purestorage_JSIPureStorageModule_nativeOnItemChanged(JNIEnv* env, jclass clazz, jstring key) {
+    if (auto engine = pure_storage::findSharedEngine()) {
+        engine->invalidate(toStdString(env, key));
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_purestorage_JSIPureStorageModule_nativeOnAppBackground(JNIEnv* env, jclass clazz) {
+    if (auto engine = pure_storage::findSharedEngine()) {
+        engine->onAppBackground();
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_purestorage_JSIPureStorageModule_nativePrepareNativeAccess(JNIEnv* env, jclass clazz, jobject context) {
+    // Only the opener; the engine is created by the first pure_storage_open()
+    registerBackendOpener(env, context);
+}
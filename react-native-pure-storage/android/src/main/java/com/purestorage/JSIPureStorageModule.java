@@ -23,6 +23,8 @@ import java.util.Map;
 import java.util.HashSet;
 import java.util.Set;
 
+import org.json.JSONArray;
+
 import javax.crypto.Cipher;
 import javax.crypto.spec.IvParameterSpec;
 import javax.crypto.spec.SecretKeySpec;
@@ -34,14 +36,25 @@ public class JSIPureStorageModule {
     private static final String STORAGE_NAME = "RNPureStorage";
     private static final String ENCRYPTION_KEY_NAME = "RNPureStorage_EncryptionKey";
     private static final String PREFIX = "RNPureStorage_";
+    private static final String STARTUP_STORAGE_NAME = "RNPureStorage_Startup";
+    private static final String STARTUP_KEYS_NAME = "keys";
+    
+    private static volatile boolean sInstalled = false;
     
     private final ReactApplicationContext mReactContext;
     private final SharedPreferences mSharedPreferences;
     private String mEncryptionKey;
+    // Derived from mEncryptionKey once rather than on every call
+    private SecretKeySpec mKeySpec;
+    private IvParameterSpec mIvSpec;
+    private final NamespaceKeyring mKeyring;
+    // Editor collecting the engine's group commit, per calling thread
+    private final ThreadLocal<SharedPreferences.Editor> mBatch = new ThreadLocal<>();
 
     public JSIPureStorageModule(ReactApplicationContext reactContext) {
         mReactContext = reactContext;
         mSharedPreferences = reactContext.getSharedPreferences(STORAGE_NAME, Context.MODE_PRIVATE);
+        mKeyring = NamespaceKeyring.get(reactContext);
         setupEncryptionKey();
     }
 
@@ -57,25 +70,21 @@ public class JSIPureStorageModule {
             // Save the encryption key
             mSharedPreferences.edit().putString(ENCRYPTION_KEY_NAME, mEncryptionKey).apply();
         }
+        
+        try {
+            byte[] keyData = Base64.decode(mEncryptionKey, Base64.DEFAULT);
+            mKeySpec = new SecretKeySpec(MessageDigest.getInstance("SHA-256").digest(keyData), "AES");
+            mIvSpec = new IvParameterSpec(MessageDigest.getInstance("MD5").digest(keyData));
+        } catch (Exception e) {
+            // Leaves legacy encryption unavailable; encrypt() and decrypt() return null
+        }
     }
     
     // Encryption helpers
     private String encrypt(String value) {
         try {
-            byte[] keyData = Base64.decode(mEncryptionKey, Base64.DEFAULT);
-            
-            // Derive key and IV using hashing
-            MessageDigest sha = MessageDigest.getInstance("SHA-256");
-            byte[] key = sha.digest(keyData);
-            
-            MessageDigest md5 = MessageDigest.getInstance("MD5");
-            byte[] iv = md5.digest(keyData);
-            
             Cipher cipher = Cipher.getInstance("AES/CBC/PKCS5Padding");
-            SecretKeySpec keySpec = new SecretKeySpec(key, "AES");
-            IvParameterSpec ivSpec = new IvParameterSpec(iv);
-            
-            cipher.init(Cipher.ENCRYPT_MODE, keySpec, ivSpec);
+            cipher.init(Cipher.ENCRYPT_MODE, mKeySpec, mIvSpec);
             byte[] encrypted = cipher.doFinal(value.getBytes(StandardCharsets.UTF_8));
             
             return Base64.encodeToString(encrypted, Base64.DEFAULT);
@@ -87,20 +96,8 @@ public class JSIPureStorageModule {
     private String decrypt(String encryptedValue) {
         try {
             byte[] encrypted = Base64.decode(encryptedValue, Base64.DEFAULT);
-            byte[] keyData = Base64.decode(mEncryptionKey, Base64.DEFAULT);
-            
-            // Derive the same key and IV
-            MessageDigest sha = MessageDigest.getInstance("SHA-256");
-            byte[] key = sha.digest(keyData);
-            
-            MessageDigest md5 = MessageDigest.getInstance("MD5");
-            byte[] iv = md5.digest(keyData);
-            
             Cipher cipher = Cipher.getInstance("AES/CBC/PKCS5Padding");
-            SecretKeySpec keySpec = new SecretKeySpec(key, "AES");
-            IvParameterSpec ivSpec = new IvParameterSpec(iv);
-            
-            cipher.init(Cipher.DECRYPT_MODE, keySpec, ivSpec);
+            cipher.init(Cipher.DECRYPT_MODE, mKeySpec, mIvSpec);
             byte[] decrypted = cipher.doFinal(encrypted);
             
             return new String(decrypted, StandardCharsets.UTF_8);
@@ -132,34 +129,88 @@ public class JSIPureStorageModule {
 
     // JSI SYNCHRONOUS METHODS
     
+    // Durability values passed by the native engine, matching pure_storage::Durability
+    private static final int DURABILITY_DEFAULT = 0;
+    private static final int DURABILITY_SYNC = 1;
+    private static final int DURABILITY_ASYNC = 2;
+    
     // Set an item synchronously
     public boolean setItemSync(String key, String type, String value, boolean encrypted) {
+        return writeItemSync(key, type, value, encrypted, null, false, DURABILITY_DEFAULT, 0,
+                             0, System.currentTimeMillis(), -1, null);
+    }
+    
+    // Set an item with the options of its namespace (used by the native engine).
+    // Encrypted values use the data key of keyNamespace, or the global key if it's null.
+    // The header fields (creation and modification times, the size the value
+    // reads as in JS) are kept with the record for statItemSync(), and so are
+    // the attributes, a JSON object encrypted along with the value.
+    public boolean writeItemSync(String key, String type, String value, boolean encrypted, String keyNamespace,
+                                 boolean compressed, int durability, long expiresAt,
+                                 long createdAt, long modifiedAt, long size, String attributes) {
         if (key == null || key.isEmpty()) {
             return false;
         }
         
         try {
             String storageKey = keyWithPrefix(key);
-            SharedPreferences.Editor editor = mSharedPreferences.edit();
+            SharedPreferences.Editor batch = mBatch.get();
+            SharedPreferences.Editor editor = batch != null ? batch : mSharedPreferences.edit();
+            
+            // Compress before encrypting; ciphertext doesn't compress
+            String valueToStore = value;
+            String compressedValue = compressed ? StoredRecord.compress(value) : null;
+            if (compressedValue != null) {
+                valueToStore = compressedValue;
+            }
             
-            if (encrypted && value != null) {
-                String encryptedValue = encrypt(value);
+            String encryptedWith = null;
+            if (encrypted && valueToStore != null && keyNamespace != null) {
+                // Never fall back to storing plaintext for an encrypted namespace
+                valueToStore = mKeyring.encrypt(keyNamespace, valueToStore);
+                if (valueToStore == null) {
+                    return false;
+                }
+                encryptedWith = keyNamespace;
+            } else if (encrypted && valueToStore != null) {
+                String encryptedValue = encrypt(valueToStore);
                 if (encryptedValue != null) {
-                    WritableMap item = serializeItem(type, encryptedValue);
-                    String serialized = Arguments.toJSONString(item);
-                    editor.putString(storageKey, serialized);
-                } else {
-                    WritableMap item = serializeItem(type, value);
-                    String serialized = Arguments.toJSONString(item);
-                    editor.putString(storageKey, serialized);
+                    valueToStore = encryptedValue;
+                }
+            }
+            
+            String attributesToStore = attributes;
+            if (attributes != null && encryptedWith != null) {
+                attributesToStore = mKeyring.encrypt(encryptedWith, attributes);
+                if (attributesToStore == null) {
+                    return false;
                 }
-            } else {
-                WritableMap item = serializeItem(type, value);
-                String serialized = Arguments.toJSONString(item);
-                editor.putString(storageKey, serialized);
+            } else if (attributes != null && encrypted) {
+                String encryptedAttributes = encrypt(attributes);
+                if (encryptedAttributes != null) {
+                    attributesToStore = encryptedAttributes;
+                }
+            }
+            
+            WritableMap item = serializeItem(type, valueToStore);
+            StoredRecord.putFields(item, compressedValue != null, expiresAt, encryptedWith);
+            StoredRecord.putHeader(item, createdAt, modifiedAt, size);
+            if (attributesToStore != null) {
+                item.putString(StoredRecord.ATTRIBUTES, attributesToStore);
             }
+            editor.putString(storageKey, Arguments.toJSONString(item));
             
-            // Use commit() for synchronous operations
+            if (batch != null) {
+                // Written by commitBatchSync()
+                return true;
+            }
+            
+            if (durability == DURABILITY_ASYNC) {
+                editor.apply();
+                return true;
+            }
+            
+            // commit() for synchronous operations
             return editor.commit();
         } catch (Exception e) {
             return false;
@@ -168,6 +219,64 @@ public class JSIPureStorageModule {
     
     // Get an item synchronously
     public ReadableMap getItemSync(String key) {
+        ReadableMap item = readItem(key);
+        if (item == null || StoredRecord.isExpired(item)) {
+            return null;
+        }
+        return item;
+    }
+    
+    // Get an item as [type, value, expiresAt, createdAt, modifiedAt, size, attributes] synchronously
+    // (used by the native engine). Expired items are returned too, so the engine can remove them.
+    public String[] getRawItemSync(String key) {
+        ReadableMap item = readItem(key);
+        if (item == null) {
+            return null;
+        }
+        
+        String[] result = new String[3 + StoredRecord.HEADER_FIELDS.length];
+        result[0] = item.getString("type");
+        result[1] = item.isNull("value") ? null : item.getString("value");
+        for (int i = 0; i < StoredRecord.HEADER_FIELDS.length; i++) {
+            result[2 + i] = StoredRecord.headerField(item, StoredRecord.HEADER_FIELDS[i]);
+        }
+        result[2 + StoredRecord.HEADER_FIELDS.length] = item.hasKey(StoredRecord.ATTRIBUTES) ? item.getString(StoredRecord.ATTRIBUTES) : null;
+        return result;
+    }
+    
+    // Get an item's [type, expiresAt, createdAt, modifiedAt, size, attributes] without
+    // decrypting or decoding its value (used by the native engine)
+    public String[] statItemSync(String key) {
+        if (key == null || key.isEmpty()) {
+            return null;
+        }
+        
+        try {
+            String serialized = mSharedPreferences.getString(keyWithPrefix(key), null);
+            if (serialized == null) {
+                return null;
+            }
+            
+            ReadableMap item = Arguments.fromJSONString(serialized);
+            // Values of a shredded namespace read as missing
+            if (StoredRecord.hasKeyNamespace(item) && !mKeyring.hasKey(item.getString(StoredRecord.KEY_NAMESPACE))) {
+                return null;
+            }
+            
+            String[] result = new String[2 + StoredRecord.HEADER_FIELDS.length];
+            result[0] = item.getString("type");
+            for (int i = 0; i < StoredRecord.HEADER_FIELDS.length; i++) {
+                result[1 + i] = StoredRecord.headerField(item, StoredRecord.HEADER_FIELDS[i]);
+            }
+            result[1 + StoredRecord.HEADER_FIELDS.length] = readAttributes(item);
+            return result;
+        } catch (Exception e) {
+            return null;
+        }
+    }
+    
+    // Read, decrypt and decompress a stored record
+    private ReadableMap readItem(String key) {
         if (key == null || key.isEmpty()) {
             return null;
         }
@@ -184,20 +293,77 @@ public class JSIPureStorageModule {
             String type = item.getString("type");
             String value = item.getString("value");
             
-            // Check if the value is encrypted and decrypt if needed
-            if (isEncrypted(value)) {
+            if (StoredRecord.hasKeyNamespace(item)) {
+                value = mKeyring.decrypt(item.getString(StoredRecord.KEY_NAMESPACE), value);
+                if (value == null) {
+                    // Its namespace was shredded
+                    return null;
+                }
+            } else if (isEncrypted(value)) {
+                // Check if the value is encrypted with the global key and decrypt if needed
                 String decryptedValue = decrypt(value);
                 if (decryptedValue != null) {
-                    return serializeItem(type, decryptedValue);
+                    value = decryptedValue;
                 }
             }
             
-            return item;
+            WritableMap result = serializeItem(type, StoredRecord.decodeValue(item, value));
+            for (String field : StoredRecord.HEADER_FIELDS) {
+                if (item.hasKey(field) && !item.isNull(field)) {
+                    result.putDouble(field, item.getDouble(field));
+                }
+            }
+            String attributes = readAttributes(item);
+            if (attributes != null) {
+                result.putString(StoredRecord.ATTRIBUTES, attributes);
+            }
+            return result;
         } catch (Exception e) {
             return null;
         }
     }
     
+    // Decrypt a record's attributes the way its value was encrypted; null if it has none
+    private String readAttributes(ReadableMap item) {
+        if (!item.hasKey(StoredRecord.ATTRIBUTES) || item.isNull(StoredRecord.ATTRIBUTES)) {
+            return null;
+        }
+        
+        String attributes = item.getString(StoredRecord.ATTRIBUTES);
+        if (StoredRecord.hasKeyNamespace(item)) {
+            return mKeyring.decrypt(item.getString(StoredRecord.KEY_NAMESPACE), attributes);
+        }
+        // Plain attributes are a JSON object, so anything else used the global key
+        return attributes.startsWith("{") ? attributes : decrypt(attributes);
+    }
+    
+    // Collect this thread's writes into one editor until commitBatchSync() (used by the native engine)
+    public void beginBatchSync() {
+        mBatch.set(mSharedPreferences.edit());
+    }
+    
+    // Write everything collected since beginBatchSync() with a single commit
+    public boolean commitBatchSync() {
+        SharedPreferences.Editor batch = mBatch.get();
+        mBatch.remove();
+        
+        try {
+            return batch == null || batch.commit();
+        } catch (Exception e) {
+            return false;
+        }
+    }
+    
+    // Destroy a namespace's data key synchronously (used by the native engine)
+    public boolean shredNamespaceSync(String namespace) {
+        return namespace != null && mKeyring.shred(namespace);
+    }
+    
+    // Secret for hashing a namespace's key names (used by the native engine)
+    public byte[] getKeyHashSecretSync(String namespace) {
+        return namespace != null ? mKeyring.keyHashSecret(namespace) : null;
+    }
+    
     // Remove an item synchronously
     public boolean removeItemSync(String key) {
         if (key == null || key.isEmpty()) {
@@ -206,6 +372,14 @@ public class JSIPureStorageModule {
         
         try {
             String storageKey = keyWithPrefix(key);
+            SharedPreferences.Editor batch = mBatch.get();
+            if (batch != null) {
+                // Queued behind the batch's earlier writes, so a put followed
+                // by a remove of the same key ends with the key removed
+                batch.remove(storageKey);
+                return true;
+            }
+            
             SharedPreferences.Editor editor = mSharedPreferences.edit();
             editor.remove(storageKey);
             return editor.commit();
@@ -358,11 +532,81 @@ public class JSIPureStorageModule {
         }
     }
     
+    // Startup hot set (used by the native engine)
+    
+    // Get the keys read during the previous launch's startup
+    public String[] getStartupKeysSync() {
+        try {
+            SharedPreferences prefs = mReactContext.getSharedPreferences(STARTUP_STORAGE_NAME, Context.MODE_PRIVATE);
+            String serialized = prefs.getString(STARTUP_KEYS_NAME, null);
+            if (serialized == null) {
+                return new String[0];
+            }
+            
+            JSONArray array = new JSONArray(serialized);
+            String[] keys = new String[array.length()];
+            for (int i = 0; i < array.length(); i++) {
+                keys[i] = array.getString(i);
+            }
+            return keys;
+        } catch (Exception e) {
+            return new String[0];
+        }
+    }
+    
+    // Save the keys read during this launch's startup
+    public void setStartupKeysSync(String[] keys) {
+        try {
+            JSONArray array = new JSONArray();
+            for (String key : keys) {
+                array.put(key);
+            }
+            
+            // Not needed until the next launch, so apply() is enough
+            mReactContext.getSharedPreferences(STARTUP_STORAGE_NAME, Context.MODE_PRIVATE)
+                .edit()
+                .putString(STARTUP_KEYS_NAME, array.toString())
+                .apply();
+        } catch (Exception e) {
+            // Losing the hot set only costs the next launch its prewarm
+        }
+    }
+    
     // This method will install the JSI bindings
-    public static void install(ReactApplicationContext context, long jsContextPtr) {
-        // This would be implemented in C++ to register the JSI functions
-        nativeInstall(context, jsContextPtr);
+    public static void install(ReactApplicationContext context, long jsContextPtr, CallInvokerHolderImpl jsCallInvokerHolder) {
+        System.loadLibrary("JSIPureStorage");
+        nativeInstall(context, jsContextPtr, jsCallInvokerHolder);
+        sInstalled = true;
     }
     
-    private static native void nativeInstall(ReactApplicationContext context, long jsContextPtr);
+    // Lets native code outside of React (e.g. a WorkManager job) open the store
+    // through pure_storage.h. Only registers how to open it; nothing is loaded
+    // until the first pure_storage_open().
+    public static void prepareNativeAccess(Context context) {
+        System.loadLibrary("JSIPureStorage");
+        nativePrepareNativeAccess(new ReactApplicationContext(context.getApplicationContext()));
+        sInstalled = true;
+    }
+    
+    // Let the native engine know a key was written outside of JSI (e.g. by the async module)
+    public static void notifyItemChanged(String key) {
+        if (sInstalled) {
+            nativeOnItemChanged(key);
+        }
+    }
+    
+    // Let the native engine write out buffered writes before the process can be killed
+    public static void notifyAppBackground() {
+        if (sInstalled) {
+            nativeOnAppBackground();
+        }
+    }
+    
+    private static native void nativeInstall(ReactApplicationContext context, long jsContextPtr, CallInvokerHolderImpl jsCallInvokerHolder);
+    
+    private static native void nativeOnItemChanged(String key);
+    
+    private static native void nativeOnAppBackground();
+    
+    private static native void nativePrepareNativeAccess(ReactApplicationContext context);
 } 
\ No newline at end of file
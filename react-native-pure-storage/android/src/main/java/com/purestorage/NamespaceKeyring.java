@@ -0,0 +1,242 @@
+package com.purestorage;
+
+import android.content.Context;
+import android.content.SharedPreferences;
+import android.os.Build;
+import android.security.keystore.KeyGenParameterSpec;
+import android.security.keystore.KeyProperties;
+import android.util.Base64;
+
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.security.KeyStore;
+import java.security.MessageDigest;
+import java.security.SecureRandom;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.Map;
+
+import javax.crypto.Cipher;
+import javax.crypto.KeyGenerator;
+import javax.crypto.SecretKey;
+import javax.crypto.spec.GCMParameterSpec;
+import javax.crypto.spec.IvParameterSpec;
+import javax.crypto.spec.SecretKeySpec;
+
+/**
+ * Per-namespace data keys for values encrypted by the native engine.
+ *
+ * Each namespace gets a random AES-256 data key, stored wrapped by a master
+ * key that lives in the Android Keystore (or, before API 23, in this file).
+ * Unwrapped keys and their ciphers are cached for the life of the process,
+ * so encrypting a value costs a cipher init and nothing else. Destroying a
+ * namespace's wrapped key crypto-shreds every value encrypted with it.
+ */
+final class NamespaceKeyring {
+    private static final String STORAGE_NAME = "RNPureStorage_Keys";
+    private static final String NAMESPACE_PREFIX = "ns:";
+    private static final String LEGACY_MASTER_KEY_NAME = "master";
+    private static final String KEYSTORE = "AndroidKeyStore";
+    private static final String KEY_HASH_LABEL = "RNPureStorage key names";
+    private static final String MASTER_KEY_ALIAS = "RNPureStorage_MasterKey";
+
+    private static final String WRAP_TRANSFORMATION = "AES/GCM/NoPadding";
+    private static final String DATA_TRANSFORMATION = "AES/CBC/PKCS5Padding";
+    private static final int GCM_IV_LENGTH = 12;
+    private static final int GCM_TAG_BITS = 128;
+    private static final int CBC_IV_LENGTH = 16;
+    private static final int KEY_LENGTH = 32;
+    private static final int KEY_HASH_SECRET_LENGTH = 16;
+
+    private static NamespaceKeyring sInstance;
+
+    // Ciphers aren't thread-safe, so each thread gets its own per data key
+    private static final class CipherContext {
+        final SecretKeySpec key;
+        final byte[] keyHashSecret;
+        final ThreadLocal<Cipher> cipher = new ThreadLocal<Cipher>() {
+            @Override
+            protected Cipher initialValue() {
+                try {
+                    return Cipher.getInstance(DATA_TRANSFORMATION);
+                } catch (Exception e) {
+                    throw new IllegalStateException(e);
+                }
+            }
+        };
+
+        CipherContext(byte[] keyBytes) throws Exception {
+            key = new SecretKeySpec(keyBytes, "AES");
+
+            // Derived rather than stored, so it goes when the data key is shredded
+            MessageDigest digest = MessageDigest.getInstance("SHA-256");
+            digest.update(KEY_HASH_LABEL.getBytes(StandardCharsets.UTF_8));
+            keyHashSecret = Arrays.copyOf(digest.digest(keyBytes), KEY_HASH_SECRET_LENGTH);
+        }
+    }
+
+    private final SharedPreferences mSharedPreferences;
+    private final SecureRandom mRandom = new SecureRandom();
+    private final Map<String, CipherContext> mContexts = new HashMap<>();
+    private SecretKey mMasterKey;
+
+    static synchronized NamespaceKeyring get(Context context) {
+        if (sInstance == null) {
+            sInstance = new NamespaceKeyring(context.getApplicationContext());
+        }
+        return sInstance;
+    }
+
+    private NamespaceKeyring(Context context) {
+        mSharedPreferences = context.getSharedPreferences(STORAGE_NAME, Context.MODE_PRIVATE);
+    }
+
+    // Encrypt a value with the namespace's data key, creating the key on first use
+    String encrypt(String namespace, String value) {
+        try {
+            CipherContext context = getContext(namespace, true);
+            byte[] iv = new byte[CBC_IV_LENGTH];
+            mRandom.nextBytes(iv);
+
+            Cipher cipher = context.cipher.get();
+            cipher.init(Cipher.ENCRYPT_MODE, context.key, new IvParameterSpec(iv));
+            byte[] encrypted = cipher.doFinal(value.getBytes(StandardCharsets.UTF_8));
+
+            return Base64.encodeToString(concat(iv, encrypted), Base64.NO_WRAP);
+        } catch (Exception e) {
+            return null;
+        }
+    }
+
+    // Returns null if the namespace has no key (it was shredded) or the value doesn't decrypt
+    String decrypt(String namespace, String encryptedValue) {
+        try {
+            CipherContext context = getContext(namespace, false);
+            if (context == null) {
+                return null;
+            }
+
+            byte[] data = Base64.decode(encryptedValue, Base64.NO_WRAP);
+            Cipher cipher = context.cipher.get();
+            cipher.init(Cipher.DECRYPT_MODE, context.key, new IvParameterSpec(data, 0, CBC_IV_LENGTH));
+            byte[] decrypted = cipher.doFinal(data, CBC_IV_LENGTH, data.length - CBC_IV_LENGTH);
+
+            return new String(decrypted, StandardCharsets.UTF_8);
+        } catch (Exception e) {
+            return null;
+        }
+    }
+
+    // Secret for hashing the namespace's key names, creating its data key on first use
+    byte[] keyHashSecret(String namespace) {
+        try {
+            return getContext(namespace, true).keyHashSecret.clone();
+        } catch (Exception e) {
+            return null;
+        }
+    }
+
+    // Whether the namespace has a data key, i.e. hasn't been shredded since its last encrypted write
+    synchronized boolean hasKey(String namespace) {
+        return mContexts.containsKey(namespace) || mSharedPreferences.contains(NAMESPACE_PREFIX + namespace);
+    }
+
+        // Destroy the namespace's data key; a new one is created on the next encrypted write
+    synchronized boolean shred(String namespace) {
+        mContexts.remove(namespace);
+        return mSharedPreferences.edit().remove(NAMESPACE_PREFIX + namespace).commit();
+    }
+
+    private synchronized CipherContext getContext(String namespace, boolean create) throws Exception {
+        CipherContext context = mContexts.get(namespace);
+        if (context != null) {
+            return context;
+        }
+
+        String wrapped = mSharedPreferences.getString(NAMESPACE_PREFIX + namespace, null);
+        byte[] keyBytes;
+        if (wrapped != null) {
+            keyBytes = unwrap(Base64.decode(wrapped, Base64.NO_WRAP));
+        } else if (create) {
+            keyBytes = new byte[KEY_LENGTH];
+            mRandom.nextBytes(keyBytes);
+
+            // The key must be on disk before any value encrypted with it
+            String encoded = Base64.encodeToString(wrap(keyBytes), Base64.NO_WRAP);
+            if (!mSharedPreferences.edit().putString(NAMESPACE_PREFIX + namespace, encoded).commit()) {
+                throw new IllegalStateException("Failed to save the data key of " + namespace);
+            }
+        } else {
+            return null;
+        }
+
+        context = new CipherContext(keyBytes);
+        mContexts.put(namespace, context);
+        return context;
+    }
+
+    private byte[] wrap(byte[] keyBytes) throws Exception {
+        Cipher cipher = Cipher.getInstance(WRAP_TRANSFORMATION);
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
+            // Keystore keys pick their own IV
+            cipher.init(Cipher.ENCRYPT_MODE, getMasterKey());
+        } else {
+            byte[] iv = new byte[GCM_IV_LENGTH];
+            mRandom.nextBytes(iv);
+            cipher.init(Cipher.ENCRYPT_MODE, getMasterKey(), new GCMParameterSpec(GCM_TAG_BITS, iv));
+        }
+
+        return concat(cipher.getIV(), cipher.doFinal(keyBytes));
+    }
+
+    private byte[] unwrap(byte[] wrapped) throws Exception {
+        Cipher cipher = Cipher.getInstance(WRAP_TRANSFORMATION);
+        cipher.init(Cipher.DECRYPT_MODE, getMasterKey(), new GCMParameterSpec(GCM_TAG_BITS, wrapped, 0, GCM_IV_LENGTH));
+        return cipher.doFinal(wrapped, GCM_IV_LENGTH, wrapped.length - GCM_IV_LENGTH);
+    }
+
+    private SecretKey getMasterKey() throws Exception {
+        if (mMasterKey != null) {
+            return mMasterKey;
+        }
+
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
+            KeyStore keyStore = KeyStore.getInstance(KEYSTORE);
+            keyStore.load(null);
+
+            if (!keyStore.containsAlias(MASTER_KEY_ALIAS)) {
+                KeyGenerator generator = KeyGenerator.getInstance(KeyProperties.KEY_ALGORITHM_AES, KEYSTORE);
+                generator.init(new KeyGenParameterSpec.Builder(
+                        MASTER_KEY_ALIAS,
+                        KeyProperties.PURPOSE_ENCRYPT | KeyProperties.PURPOSE_DECRYPT)
+                    .setBlockModes(KeyProperties.BLOCK_MODE_GCM)
+                    .setEncryptionPaddings(KeyProperties.ENCRYPTION_PADDING_NONE)
+                    .setKeySize(KEY_LENGTH * 8)
+                    .build());
+                generator.generateKey();
+            }
+
+            mMasterKey = (SecretKey) keyStore.getKey(MASTER_KEY_ALIAS, null);
+        } else {
+            // No Keystore AES before API 23; the master key is kept beside the wrapped keys
+            String encoded = mSharedPreferences.getString(LEGACY_MASTER_KEY_NAME, null);
+            byte[] keyBytes;
+            if (encoded != null) {
+                keyBytes = Base64.decode(encoded, Base64.NO_WRAP);
+            } else {
+                keyBytes = new byte[KEY_LENGTH];
+                mRandom.nextBytes(keyBytes);
+                mSharedPreferences.edit()
+                    .putString(LEGACY_MASTER_KEY_NAME, Base64.encodeToString(keyBytes, Base64.NO_WRAP))
+                    .commit();
+            }
+            mMasterKey = new SecretKeySpec(keyBytes, "AES");
+        }
+
+        return mMasterKey;
+    }
+
+    private static byte[] concat(byte[] first, byte[] second) {
+        return ByteBuffer.allocate(first.length + second.length).put(first).put(second).array();
+    }
+}
@@ -1,19 +1,28 @@
 package com.purestorage;
 
+import com.facebook.react.bridge.LifecycleEventListener;
 import com.facebook.react.bridge.ReactApplicationContext;
 import com.facebook.react.bridge.ReactContextBaseJavaModule;
+import com.facebook.react.bridge.ReactMethod;
 import com.facebook.react.module.annotations.ReactModule;
 import com.facebook.react.turbomodule.core.CallInvokerHolderImpl;
 import com.facebook.react.bridge.JavaScriptContextHolder;
 
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+
 @ReactModule(name = RNJSIPureStorageModule.NAME)
-public class RNJSIPureStorageModule extends ReactContextBaseJavaModule {
+public class RNJSIPureStorageModule extends ReactContextBaseJavaModule implements LifecycleEventListener {
     static final String NAME = "RNJSIPureStorage";
     private static boolean sJSIBindingsInstalled = false;
 
+    // Flushes run off the UI thread, which the lifecycle callbacks are called on
+    private final ExecutorService mFlushExecutor = Executors.newSingleThreadExecutor();
+
     public RNJSIPureStorageModule(ReactApplicationContext reactContext) {
         super(reactContext);
         initializeJSI(reactContext);
+        reactContext.addLifecycleEventListener(this);
     }
 
     @Override
@@ -21,6 +30,40 @@ public class RNJSIPureStorageModule extends ReactContextBaseJavaModule {
         return NAME;
     }
 
+    @Override
+    public void onHostResume() {
+    }
+
+    @Override
+    public void onHostPause() {
+        // A backgrounded process can be killed without further callbacks
+        mFlushExecutor.execute(JSIPureStorageModule::notifyAppBackground);
+    }
+
+    @Override
+    public void onHostDestroy() {
+        mFlushExecutor.execute(JSIPureStorageModule::notifyAppBackground);
+    }
+
+    // Every reload creates a new module, so this one's listener and flush
+    // thread go away with it, after a last flush
+    @Override
+    public void invalidate() {
+        getReactApplicationContext().removeLifecycleEventListener(this);
+        mFlushExecutor.execute(JSIPureStorageModule::notifyAppBackground);
+        mFlushExecutor.shutdown();
+        super.invalidate();
+    }
+
+    // Called by JS when the bindings aren't there yet: without the bridge the
+    // runtime may not exist when the module is created, but it does by the
+    // time JS can call in, on the JS thread
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    public boolean install() {
+        initializeJSI(getReactApplicationContext());
+        return sJSIBindingsInstalled;
+    }
+
     private synchronized void initializeJSI(ReactApplicationContext reactContext) {
         if (sJSIBindingsInstalled) {
             return;
@@ -30,10 +73,13 @@ public class RNJSIPureStorageModule extends ReactContextBaseJavaModule {
             // Install the bindings
             JavaScriptContextHolder jsContext = reactContext.getJavaScriptContextHolder();
             if (jsContext.get() != 0) {
-                JSIPureStorageModule.install(reactContext, jsContext.get());
+                // From the context rather than the CatalystInstance, which bridgeless mode doesn't have
+                CallInvokerHolderImpl jsCallInvokerHolder =
+                    (CallInvokerHolderImpl) reactContext.getJSCallInvokerHolder();
+                JSIPureStorageModule.install(reactContext, jsContext.get(), jsCallInvokerHolder);
                 sJSIBindingsInstalled = true;
             }
-        } catch (Exception e) {
+        } catch (Exception | UnsatisfiedLinkError e) {
             // JSI might not be available
         }
     }
@@ -35,11 +35,16 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
     private final SharedPreferences mSharedPreferences;
     private final Executor mExecutor;
     private String mEncryptionKey;
+    // Derived from mEncryptionKey once rather than on every call
+    private SecretKeySpec mKeySpec;
+    private IvParameterSpec mIvSpec;
+    private final NamespaceKeyring mKeyring;
 
     public RNPureStorageModule(ReactApplicationContext reactContext) {
         super(reactContext);
         mSharedPreferences = reactContext.getSharedPreferences(STORAGE_NAME, Context.MODE_PRIVATE);
         mExecutor = Executors.newSingleThreadExecutor();
+        mKeyring = NamespaceKeyring.get(reactContext);
         setupEncryptionKey();
     }
 
@@ -55,6 +60,14 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
             // Save the encryption key (in a real app, this would be in the Android Keystore)
             mSharedPreferences.edit().putString(ENCRYPTION_KEY_NAME, mEncryptionKey).apply();
         }
+        
+        try {
+            byte[] keyData = Base64.decode(mEncryptionKey, Base64.DEFAULT);
+            mKeySpec = new SecretKeySpec(MessageDigest.getInstance("SHA-256").digest(keyData), "AES");
+            mIvSpec = new IvParameterSpec(MessageDigest.getInstance("MD5").digest(keyData));
+        } catch (Exception e) {
+            // Leaves legacy encryption unavailable; encrypt() and decrypt() return null
+        }
     }
 
     @Override
@@ -65,20 +78,8 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
     // Encryption helpers
     private String encrypt(String value) {
         try {
-            byte[] keyData = Base64.decode(mEncryptionKey, Base64.DEFAULT);
-            
-            // Derive key and IV using hashing
-            MessageDigest sha = MessageDigest.getInstance("SHA-256");
-            byte[] key = sha.digest(keyData);
-            
-            MessageDigest md5 = MessageDigest.getInstance("MD5");
-            byte[] iv = md5.digest(keyData);
-            
             Cipher cipher = Cipher.getInstance("AES/CBC/PKCS5Padding");
-            SecretKeySpec keySpec = new SecretKeySpec(key, "AES");
-            IvParameterSpec ivSpec = new IvParameterSpec(iv);
-            
-            cipher.init(Cipher.ENCRYPT_MODE, keySpec, ivSpec);
+            cipher.init(Cipher.ENCRYPT_MODE, mKeySpec, mIvSpec);
             byte[] encrypted = cipher.doFinal(value.getBytes(StandardCharsets.UTF_8));
             
             return Base64.encodeToString(encrypted, Base64.DEFAULT);
@@ -90,20 +91,8 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
     private String decrypt(String encryptedValue) {
         try {
             byte[] encrypted = Base64.decode(encryptedValue, Base64.DEFAULT);
-            byte[] keyData = Base64.decode(mEncryptionKey, Base64.DEFAULT);
-            
-            // Derive the same key and IV
-            MessageDigest sha = MessageDigest.getInstance("SHA-256");
-            byte[] key = sha.digest(keyData);
-            
-            MessageDigest md5 = MessageDigest.getInstance("MD5");
-            byte[] iv = md5.digest(keyData);
-            
             Cipher cipher = Cipher.getInstance("AES/CBC/PKCS5Padding");
-            SecretKeySpec keySpec = new SecretKeySpec(key, "AES");
-            IvParameterSpec ivSpec = new IvParameterSpec(iv);
-            
-            cipher.init(Cipher.DECRYPT_MODE, keySpec, ivSpec);
+            cipher.init(Cipher.DECRYPT_MODE, mKeySpec, mIvSpec);
             byte[] decrypted = cipher.doFinal(encrypted);
             
             return new String(decrypted, StandardCharsets.UTF_8);
@@ -169,6 +158,7 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
                 
                 // Use apply() instead of commit() for better performance
                 editor.apply();
+                JSIPureStorageModule.notifyItemChanged(key);
                 promise.resolve(true);
             } catch (Exception e) {
                 promise.reject("ERR_UNEXPECTED_EXCEPTION", e.getMessage(), e);
@@ -224,26 +214,33 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
                 
                 if (serialized != null) {
                     ReadableMap item = Arguments.fromJSONString(serialized);
+                    if (StoredRecord.isExpired(item)) {
+                        promise.resolve(null);
+                        return;
+                    }
+                    
                     String type = item.getString("type");
                     String value = item.getString("value");
                     
-                    // Check if value might be encrypted
-                    if ("string".equals(type) && isEncrypted(value)) {
+                    if (StoredRecord.hasKeyNamespace(item)) {
+                        value = mKeyring.decrypt(item.getString(StoredRecord.KEY_NAMESPACE), value);
+                        if (value == null) {
+                            // Its namespace was shredded
+                            promise.resolve(null);
+                            return;
+                        }
+                    } else if ("string".equals(type) && isEncrypted(value)) {
+                        // Value might be encrypted with the global key
                         String decryptedValue = decrypt(value);
                         if (decryptedValue != null) {
-                            // Successfully decrypted
-                            WritableMap decryptedItem = Arguments.createMap();
-                            decryptedItem.putString("type", type);
-                            decryptedItem.putString("value", decryptedValue);
-                            promise.resolve(decryptedItem);
-                            return;
+                            value = decryptedValue;
                         }
                     }
                     
                     // Return as is if not encrypted or decryption failed
                     WritableMap result = Arguments.createMap();
                     result.putString("type", type);
-                    result.putString("value", value);
+                    result.putString("value", StoredRecord.decodeValue(item, value));
                     promise.resolve(result);
                 } else {
                     promise.resolve(null);
@@ -266,25 +263,31 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
             
             if (serialized != null) {
                 ReadableMap item = Arguments.fromJSONString(serialized);
+                if (StoredRecord.isExpired(item)) {
+                    return null;
+                }
+                
                 String type = item.getString("type");
                 String value = item.getString("value");
                 
-                // Check if value might be encrypted
-                if ("string".equals(type) && isEncrypted(value)) {
+                if (StoredRecord.hasKeyNamespace(item)) {
+                    value = mKeyring.decrypt(item.getString(StoredRecord.KEY_NAMESPACE), value);
+                    if (value == null) {
+                        // Its namespace was shredded
+                        return null;
+                    }
+                } else if ("string".equals(type) && isEncrypted(value)) {
+                    // Value might be encrypted with the global key
                     String decryptedValue = decrypt(value);
                     if (decryptedValue != null) {
-                        // Successfully decrypted
-                        WritableMap decryptedItem = Arguments.createMap();
-                        decryptedItem.putString("type", type);
-                        decryptedItem.putString("value", decryptedValue);
-                        return decryptedItem;
+                        value = decryptedValue;
                     }
                 }
                 
                 // Return as is if not encrypted or decryption failed
                 WritableMap result = Arguments.createMap();
                 result.putString("type", type);
-                result.putString("value", value);
+                result.putString("value", StoredRecord.decodeValue(item, value));
                 return result;
             }
             
@@ -307,6 +310,7 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
                 SharedPreferences.Editor editor = mSharedPreferences.edit();
                 editor.remove(storageKey);
                 editor.apply(); // Using apply for better performance
+                JSIPureStorageModule.notifyItemChanged(key);
                 promise.resolve(true);
             } catch (Exception e) {
                 promise.reject("ERR_UNEXPECTED_EXCEPTION", e.getMessage(), e);
@@ -320,14 +324,19 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
             try {
                 SharedPreferences.Editor editor = mSharedPreferences.edit();
                 Map<String, ?> allEntries = mSharedPreferences.getAll();
+                List<String> removedKeys = new ArrayList<>();
                 
                 for (String key : allEntries.keySet()) {
                     if (key.startsWith(PREFIX) && !key.equals(ENCRYPTION_KEY_NAME)) {
                         editor.remove(key);
+                        removedKeys.add(key.substring(PREFIX.length()));
                     }
                 }
                 
                 editor.apply();
+                for (String key : removedKeys) {
+                    JSIPureStorageModule.notifyItemChanged(key);
+                }
                 promise.resolve(true);
             } catch (Exception e) {
                 promise.reject("ERR_UNEXPECTED_EXCEPTION", e.getMessage(), e);
@@ -422,6 +431,9 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
                 }
                 
                 editor.apply();
+                for (int i = 0; i < keyValueArray.size(); i++) {
+                    JSIPureStorageModule.notifyItemChanged(keyValueArray.getArray(i).getString(0));
+                }
                 promise.resolve(true);
             } catch (Exception e) {
                 promise.reject("ERR_UNEXPECTED_EXCEPTION", e.getMessage(), e);
@@ -451,26 +463,33 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
                     
                     if (serialized != null) {
                         ReadableMap item = Arguments.fromJSONString(serialized);
+                        if (StoredRecord.isExpired(item)) {
+                            result.putNull(key);
+                            continue;
+                        }
+                        
                         String type = item.getString("type");
                         String value = item.getString("value");
                         
-                        // Check if value might be encrypted
-                        if ("string".equals(type) && isEncrypted(value)) {
+                        if (StoredRecord.hasKeyNamespace(item)) {
+                            value = mKeyring.decrypt(item.getString(StoredRecord.KEY_NAMESPACE), value);
+                            if (value == null) {
+                                // Its namespace was shredded
+                                result.putNull(key);
+                                continue;
+                            }
+                        } else if ("string".equals(type) && isEncrypted(value)) {
+                            // Value might be encrypted with the global key
                             String decryptedValue = decrypt(value);
                             if (decryptedValue != null) {
-                                // Successfully decrypted
-                                WritableMap decryptedItem = Arguments.createMap();
-                                decryptedItem.putString("type", type);
-                                decryptedItem.putString("value", decryptedValue);
-                                result.putMap(key, decryptedItem);
-                                continue;
+                                value = decryptedValue;
                             }
                         }
                         
                         // Return as is if not encrypted or decryption failed
                         WritableMap itemResult = Arguments.createMap();
                         itemResult.putString("type", type);
-                        itemResult.putString("value", value);
+                        itemResult.putString("value", StoredRecord.decodeValue(item, value));
                         result.putMap(key, itemResult);
                     } else {
                         result.putNull(key);
@@ -507,6 +526,9 @@ public class RNPureStorageModule extends ReactContextBaseJavaModule {
                 }
                 
                 editor.apply();
+                for (int i = 0; i < keys.size(); i++) {
+                    JSIPureStorageModule.notifyItemChanged(keys.getString(i));
+                }
                 promise.resolve(true);
             } catch (Exception e) {
                 promise.reject("ERR_UNEXPECTED_EXCEPTION", e.getMessage(), e);
@@ -0,0 +1,130 @@
+package com.purestorage;
+
+import android.util.Base64;
+
+import com.facebook.react.bridge.ReadableMap;
+import com.facebook.react.bridge.WritableMap;
+
+import java.io.ByteArrayOutputStream;
+import java.nio.charset.StandardCharsets;
+import java.util.zip.Deflater;
+import java.util.zip.Inflater;
+
+/**
+ * Optional fields of a stored record, shared by the sync and async modules.
+ * Records are {type, value} maps; the native engine may add an "encoding"
+ * for compressed values, an "expiresAt" time in milliseconds, the
+ * "keyNamespace" whose data key encrypted the value, and a header of
+ * "createdAt"/"modifiedAt" times and the "size" the value reads as in JS,
+ * and "attributes" written along with the value.
+ */
+final class StoredRecord {
+    static final String ENCODING_DEFLATE = "deflate";
+    static final String KEY_NAMESPACE = "keyNamespace";
+    // JSON object of caller-defined attributes, encrypted like the value
+    static final String ATTRIBUTES = "attributes";
+    
+    // Header fields copied between stored records and the native engine, in that order
+    static final String[] HEADER_FIELDS = { "expiresAt", "createdAt", "modifiedAt", "size" };
+    
+    // Shorter values rarely get smaller once Base64 encoded
+    private static final int MIN_COMPRESS_LENGTH = 256;
+    
+    private StoredRecord() {}
+    
+    // Whether a record has passed its expiry time and should read as missing
+    static boolean isExpired(ReadableMap item) {
+        return item.hasKey("expiresAt")
+            && !item.isNull("expiresAt")
+            && item.getDouble("expiresAt") <= System.currentTimeMillis();
+    }
+    
+    // Returns the Base64 deflated value, or null if compressing doesn't make it smaller
+    static String compress(String value) {
+        if (value == null || value.length() < MIN_COMPRESS_LENGTH) {
+            return null;
+        }
+        
+        byte[] input = value.getBytes(StandardCharsets.UTF_8);
+        Deflater deflater = new Deflater(Deflater.BEST_SPEED);
+        try {
+            deflater.setInput(input);
+            deflater.finish();
+            
+            ByteArrayOutputStream output = new ByteArrayOutputStream(input.length / 2);
+            byte[] buffer = new byte[4096];
+            while (!deflater.finished()) {
+                output.write(buffer, 0, deflater.deflate(buffer));
+            }
+            
+            String encoded = Base64.encodeToString(output.toByteArray(), Base64.NO_WRAP);
+            return encoded.length() < value.length() ? encoded : null;
+        } finally {
+            deflater.end();
+        }
+    }
+    
+    // Undo compress() if the record says the value was compressed
+    static String decodeValue(ReadableMap item, String value) {
+        if (value == null || !item.hasKey("encoding") || !ENCODING_DEFLATE.equals(item.getString("encoding"))) {
+            return value;
+        }
+        
+        Inflater inflater = new Inflater();
+        try {
+            inflater.setInput(Base64.decode(value, Base64.NO_WRAP));
+            
+            ByteArrayOutputStream output = new ByteArrayOutputStream(value.length() * 2);
+            byte[] buffer = new byte[4096];
+            while (!inflater.finished()) {
+                int length = inflater.inflate(buffer);
+                if (length == 0 && (inflater.needsInput() || inflater.needsDictionary())) {
+                    return null;
+                }
+                output.write(buffer, 0, length);
+            }
+            
+            return new String(output.toByteArray(), StandardCharsets.UTF_8);
+        } catch (Exception e) {
+            return null;
+        } finally {
+            inflater.end();
+        }
+    }
+    
+    // Whether the value was encrypted with a namespace data key from NamespaceKeyring
+    static boolean hasKeyNamespace(ReadableMap item) {
+        return item.hasKey(KEY_NAMESPACE) && !item.isNull(KEY_NAMESPACE);
+    }
+    
+    // Copy the optional fields onto a record being written
+    static void putFields(WritableMap item, boolean compressed, long expiresAt, String keyNamespace) {
+        if (keyNamespace != null) {
+            item.putString(KEY_NAMESPACE, keyNamespace);
+        }
+        if (compressed) {
+            item.putString("encoding", ENCODING_DEFLATE);
+        }
+        if (expiresAt > 0) {
+            item.putDouble("expiresAt", expiresAt);
+        }
+    }
+    
+    // Copy the header the native engine keeps for every write
+    static void putHeader(WritableMap item, long createdAt, long modifiedAt, long size) {
+        if (createdAt > 0) {
+            item.putDouble("createdAt", createdAt);
+        }
+        if (modifiedAt > 0) {
+            item.putDouble("modifiedAt", modifiedAt);
+        }
+        if (size >= 0) {
+            item.putDouble("size", size);
+        }
+    }
+    
+    // A header field as a whole number string, or null if the record doesn't have it
+    static String headerField(ReadableMap item, String field) {
+        return item.hasKey(field) && !item.isNull(field) ? String.valueOf((long) item.getDouble(field)) : null;
+    }
+}
@@ -0,0 +1,106 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace pure_storage {
+
+namespace {
+
+// Blocks bigger than this aren't kept across resets
+constexpr size_t kMaxRetainedBlock = 256 * 1024;
+
+std::atomic<uint64_t> gAllocations{0};
+std::atomic<uint64_t> gBytes{0};
+std::atomic<uint64_t> gBlockAllocations{0};
+std::atomic<uint64_t> gResets{0};
+
+thread_local int tScopeDepth = 0;
+
+} // namespace
+
+Arena::Arena(size_t blockSize) : blockSize_(blockSize) {}
+
+void Arena::addBlock(size_t minSize) {
+    size_t size = std::max(blockSize_, minSize);
+    blocks_.push_back(Block{std::unique_ptr<char[]>(new char[size]), size});
+    cursor_ = blocks_.back().data.get();
+    end_ = cursor_ + size;
+    gBlockAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    auto address = reinterpret_cast<uintptr_t>(cursor_);
+    size_t padding = (alignment - address % alignment) % alignment;
+
+    if (cursor_ == nullptr || padding + size > static_cast<size_t>(end_ - cursor_)) {
+        // New blocks come from operator new, which is aligned for any fundamental type
+        addBlock(size);
+        padding = 0;
+    }
+
+    char* result = cursor_ + padding;
+    cursor_ = result + size;
+    used_ += padding + size;
+
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    gBytes.fetch_add(size, std::memory_order_relaxed);
+    return result;
+}
+
+std::string_view Arena::copy(std::string_view string) {
+    if (string.empty()) {
+        return std::string_view();
+    }
+
+    auto data = static_cast<char*>(allocate(string.size(), 1));
+    std::memcpy(data, string.data(), string.size());
+    return std::string_view(data, string.size());
+}
+
+void Arena::reset() {
+    if (blocks_.size() > 1) {
+        size_t merged = std::min(std::max(used_, blockSize_), kMaxRetainedBlock);
+        blocks_.clear();
+        addBlock(merged);
+    } else if (!blocks_.empty() && blocks_.front().size > kMaxRetainedBlock) {
+        blocks_.clear();
+    }
+
+    if (blocks_.empty()) {
+        cursor_ = end_ = nullptr;
+    } else {
+        cursor_ = blocks_.front().data.get();
+        end_ = cursor_ + blocks_.front().size;
+    }
+
+    used_ = 0;
+    gResets.fetch_add(1, std::memory_order_relaxed);
+}
+
+Arena& Arena::current() {
+    thread_local Arena arena;
+    return arena;
+}
+
+ArenaStats Arena::stats() {
+    ArenaStats result;
+    result.allocations = gAllocations.load(std::memory_order_relaxed);
+    result.bytes = gBytes.load(std::memory_order_relaxed);
+    result.blockAllocations = gBlockAllocations.load(std::memory_order_relaxed);
+    result.resets = gResets.load(std::memory_order_relaxed);
+    return result;
+}
+
+ArenaScope::ArenaScope() : arena_(Arena::current()) {
+    tScopeDepth++;
+}
+
+ArenaScope::~ArenaScope() {
+    if (--tScopeDepth == 0) {
+        arena_.reset();
+    }
+}
+
+} // namespace pure_storage
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace pure_storage {
+
+struct ArenaStats {
+    // Requests served from an arena
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    // Blocks taken from the heap to back arenas; flat once every thread's
+    // arena has grown to fit its largest call
+    uint64_t blockAllocations = 0;
+    uint64_t resets = 0;
+};
+
+// Bump allocator for temporaries that only live for one host-function call.
+// Memory is released all at once by reset(); nothing is freed individually.
+// Each thread has its own, see current() and ArenaScope.
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 16 * 1024);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    std::string_view copy(std::string_view string);
+
+    // Drop everything allocated so far. If the last call needed more than one
+    // block, they are merged into one big enough for it next time.
+    void reset();
+
+    static Arena& current();
+
+    // Totals across all threads
+    static ArenaStats stats();
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    void addBlock(size_t minSize);
+
+    size_t blockSize_;
+    std::vector<Block> blocks_;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+    size_t used_ = 0;
+};
+
+// Resets the current thread's arena when the outermost scope ends, so host
+// functions calling each other don't free memory their caller still uses
+class ArenaScope {
+public:
+    ArenaScope();
+    ~ArenaScope();
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    Arena& arena() { return arena_; }
+
+private:
+    Arena& arena_;
+};
+
+} // namespace pure_storage
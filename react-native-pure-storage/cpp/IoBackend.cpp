@@ -0,0 +1,380 @@
+#include "IoBackend.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define PURE_STORAGE_HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+namespace pure_storage {
+
+namespace {
+
+int dataSync(int fd) {
+#if defined(__APPLE__)
+    // fsync() on Apple platforms doesn't reach the platter
+    return fcntl(fd, F_FULLFSYNC) == 0 ? 0 : -errno;
+#else
+    return fdatasync(fd) == 0 ? 0 : -errno;
+#endif
+}
+
+// Carry on from `done` bytes until the request completes, the file ends or an error
+void finishRequest(IoRequest& request, size_t done, bool write) {
+    while (done < request.size) {
+        char* data = static_cast<char*>(request.data) + done;
+        off_t offset = static_cast<off_t>(request.offset + done);
+        ssize_t count = write
+            ? pwrite(request.fd, data, request.size - done, offset)
+            : pread(request.fd, data, request.size - done, offset);
+
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            request.result = -errno;
+            return;
+        }
+        if (count == 0) {
+            break;
+        }
+        done += static_cast<size_t>(count);
+    }
+    request.result = static_cast<ssize_t>(done);
+}
+
+std::vector<int> distinctFiles(const std::vector<IoRequest>& requests) {
+    std::vector<int> files;
+    for (const auto& request : requests) {
+        if (request.result >= 0 && std::find(files.begin(), files.end(), request.fd) == files.end()) {
+            files.push_back(request.fd);
+        }
+    }
+    return files;
+}
+
+// Plain pread/pwrite, one system call per request. Concurrency comes from the
+// callers' threads, so this is the threaded baseline io_uring is measured against.
+class PosixIoBackend : public IoBackend {
+public:
+    const char* name() const override { return "posix"; }
+
+    void read(std::vector<IoRequest>& requests) override {
+        for (auto& request : requests) {
+            finishRequest(request, 0, false);
+        }
+    }
+
+    void write(std::vector<IoRequest>& requests, bool sync) override {
+        for (auto& request : requests) {
+            finishRequest(request, 0, true);
+        }
+
+        if (sync) {
+            for (int fd : distinctFiles(requests)) {
+                int result = dataSync(fd);
+                if (result < 0) {
+                    failFile(requests, fd, result);
+                }
+            }
+        }
+    }
+
+    int sync(int fd) override { return dataSync(fd); }
+
+    static void failFile(std::vector<IoRequest>& requests, int fd, int error) {
+        for (auto& request : requests) {
+            if (request.fd == fd) {
+                request.result = error;
+            }
+        }
+    }
+};
+
+#ifdef PURE_STORAGE_HAS_IO_URING
+
+// io_uring through the raw system calls, so there's no liburing dependency.
+// Needs IORING_OP_READV/WRITEV/FSYNC, which every kernel with io_uring has.
+class IoUringBackend : public IoBackend {
+public:
+    static std::unique_ptr<IoUringBackend> create(unsigned entries) {
+        std::unique_ptr<IoUringBackend> backend(new IoUringBackend());
+        return backend->setUp(entries) ? std::move(backend) : nullptr;
+    }
+
+    ~IoUringBackend() override {
+        if (sqes_) {
+            munmap(sqes_, sqesSize_);
+        }
+        if (cqRing_ && cqRing_ != sqRing_) {
+            munmap(cqRing_, cqRingSize_);
+        }
+        if (sqRing_) {
+            munmap(sqRing_, sqRingSize_);
+        }
+        if (ringFd_ >= 0) {
+            close(ringFd_);
+        }
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+    void read(std::vector<IoRequest>& requests) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        submitAll(requests, IORING_OP_READV);
+        finishShort(requests, false);
+    }
+
+    void write(std::vector<IoRequest>& requests, bool sync) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        submitAll(requests, IORING_OP_WRITEV);
+        finishShort(requests, true);
+
+        if (!sync) {
+            return;
+        }
+
+        // All the files' syncs go to the kernel in one submission
+        std::vector<int> files = distinctFiles(requests);
+        std::vector<IoRequest> syncs(files.size());
+        for (size_t i = 0; i < files.size(); i++) {
+            syncs[i].fd = files[i];
+        }
+        submitAll(syncs, IORING_OP_FSYNC);
+
+        for (const auto& sync : syncs) {
+            if (sync.result < 0) {
+                PosixIoBackend::failFile(requests, sync.fd, static_cast<int>(sync.result));
+            }
+        }
+    }
+
+    int sync(int fd) override {
+        std::vector<IoRequest> syncs(1);
+        syncs[0].fd = fd;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        submitAll(syncs, IORING_OP_FSYNC);
+        return static_cast<int>(syncs[0].result);
+    }
+
+private:
+    IoUringBackend() = default;
+
+    bool setUp(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            return false;
+        }
+        ringFd_ = fd;
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+
+        sqRing_ = map(sqRingSize_, IORING_OFF_SQ_RING);
+        if (!sqRing_) {
+            return false;
+        }
+        cqRing_ = singleMap ? sqRing_ : map(cqRingSize_, IORING_OFF_CQ_RING);
+        if (!cqRing_) {
+            return false;
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqesSize_, IORING_OFF_SQES));
+        if (!sqes_) {
+            return false;
+        }
+
+        auto sq = static_cast<char*>(sqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqEntries_ = params.sq_entries;
+
+        auto cq = static_cast<char*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    void* map(size_t size, uint64_t offset) {
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ringFd_, static_cast<off_t>(offset));
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+    // Submit in chunks the size of the submission ring, waiting for each
+    void submitAll(std::vector<IoRequest>& requests, uint8_t opcode) {
+        std::vector<iovec> vectors(std::min<size_t>(requests.size(), sqEntries_));
+
+        for (size_t start = 0; start < requests.size(); start += sqEntries_) {
+            size_t count = std::min<size_t>(sqEntries_, requests.size() - start);
+
+            // The tail is only written by us, under mutex_
+            unsigned tail = *sqTail_;
+            for (size_t i = 0; i < count; i++) {
+                IoRequest& request = requests[start + i];
+                vectors[i].iov_base = request.data;
+                vectors[i].iov_len = request.size;
+
+                unsigned index = tail & sqMask_;
+                io_uring_sqe& sqe = sqes_[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = opcode;
+                sqe.fd = request.fd;
+                sqe.user_data = start + i;
+                if (opcode == IORING_OP_FSYNC) {
+                    sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+                } else {
+                    sqe.addr = reinterpret_cast<uint64_t>(&vectors[i]);
+                    sqe.len = 1;
+                    sqe.off = request.offset;
+                }
+                sqArray_[index] = index;
+                tail++;
+            }
+            __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+
+            if (!submitAndWait(requests, static_cast<unsigned>(count))) {
+                for (size_t i = 0; i < count; i++) {
+                    requests[start + i].result = -EIO;
+                }
+            }
+        }
+    }
+
+    bool submitAndWait(std::vector<IoRequest>& requests, unsigned count) {
+        unsigned toSubmit = count;
+        unsigned completed = 0;
+
+        while (completed < count) {
+            int entered = static_cast<int>(syscall(__NR_io_uring_enter, ringFd_, toSubmit,
+                count - completed, IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (entered < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(entered));
+
+            unsigned head = *cqHead_;
+            unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                requests[cqe.user_data].result = cqe.res;
+                completed++;
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+    static void finishShort(std::vector<IoRequest>& requests, bool write) {
+        for (auto& request : requests) {
+            if (request.result > 0 && static_cast<size_t>(request.result) < request.size) {
+                finishRequest(request, static_cast<size_t>(request.result), write);
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    int ringFd_ = -1;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqesSize_ = 0;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+#endif // PURE_STORAGE_HAS_IO_URING
+
+} // namespace
+
+ssize_t IoBackend::readAt(int fd, void* data, size_t size, uint64_t offset) {
+    std::vector<IoRequest> requests(1);
+    requests[0].fd = fd;
+    requests[0].data = data;
+    requests[0].size = size;
+    requests[0].offset = offset;
+    read(requests);
+    return requests[0].result;
+}
+
+ssize_t IoBackend::writeAt(int fd, const void* data, size_t size, uint64_t offset, bool sync) {
+    std::vector<IoRequest> requests(1);
+    requests[0].fd = fd;
+    requests[0].data = const_cast<void*>(data);
+    requests[0].size = size;
+    requests[0].offset = offset;
+    write(requests, sync);
+    return requests[0].result;
+}
+
+std::unique_ptr<IoBackend> makePosixIoBackend() {
+    return std::unique_ptr<IoBackend>(new PosixIoBackend());
+}
+
+std::unique_ptr<IoBackend> makeIoUringBackend(unsigned entries) {
+#ifdef PURE_STORAGE_HAS_IO_URING
+    return IoUringBackend::create(entries);
+#else
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<IoBackend> makeIoBackend(IoBackendKind kind) {
+    switch (kind) {
+        case IoBackendKind::Posix:
+            return makePosixIoBackend();
+
+        case IoBackendKind::IoUring:
+            return makeIoUringBackend();
+
+        case IoBackendKind::Auto:
+            break;
+    }
+
+#if defined(__ANDROID__)
+    // App seccomp policies may kill the process on io_uring calls instead of
+    // failing them, so Android only gets it when asked for explicitly
+    return makePosixIoBackend();
+#else
+    std::unique_ptr<IoBackend> backend = makeIoUringBackend();
+    return backend ? std::move(backend) : makePosixIoBackend();
+#endif
+}
+
+} // namespace pure_storage
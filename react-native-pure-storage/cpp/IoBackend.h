@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace pure_storage {
+
+// One read or write of a batch. `result` is the number of bytes transferred,
+// which is all of `size` unless the file ended first, or -errno.
+struct IoRequest {
+    int fd = -1;
+    void* data = nullptr;
+    size_t size = 0;
+    uint64_t offset = 0;
+    ssize_t result = 0;
+};
+
+enum class IoBackendKind {
+    // io_uring where the kernel allows it, pread/pwrite otherwise
+    Auto,
+    Posix,
+    IoUring,
+};
+
+// File I/O used by LogStorageBackend. Batches let an implementation keep
+// several requests in flight with one system call; a request either
+// completes in full or fails, short transfers are retried internally.
+// Implementations are safe to call from several threads.
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    virtual void read(std::vector<IoRequest>& requests) = 0;
+
+    // With `sync`, the written files are made durable once all writes are
+    // done: one data sync per distinct file, however many writes it got
+    virtual void write(std::vector<IoRequest>& requests, bool sync) = 0;
+
+    virtual int sync(int fd) = 0;
+
+    ssize_t readAt(int fd, void* data, size_t size, uint64_t offset);
+    ssize_t writeAt(int fd, const void* data, size_t size, uint64_t offset, bool sync);
+};
+
+std::unique_ptr<IoBackend> makePosixIoBackend();
+
+// Null when this build has no io_uring support, or the kernel or a seccomp
+// policy refuses to set up a ring
+std::unique_ptr<IoBackend> makeIoUringBackend(unsigned entries = 64);
+
+std::unique_ptr<IoBackend> makeIoBackend(IoBackendKind kind = IoBackendKind::Auto);
+
+} // namespace pure_storage
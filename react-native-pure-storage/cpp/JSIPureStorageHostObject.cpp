@@ -0,0 +1,841 @@
+#include "JSIPureStorageHostObject.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "KeyHandleHostObject.h"
+#include "PackedColumns.h"
+
+namespace pure_storage {
+
+namespace {
+
+jsi::String makeString(jsi::Runtime& runtime, std::string_view string) {
+    return jsi::String::createFromUtf8(runtime, reinterpret_cast<const uint8_t*>(string.data()), string.size());
+}
+
+// Lends a value buffer to an ArrayBuffer, which keeps it (and whatever it
+// pins) alive until the ArrayBuffer is garbage-collected
+class ValueMutableBuffer : public jsi::MutableBuffer {
+public:
+    explicit ValueMutableBuffer(std::shared_ptr<ValueBuffer> buffer) : buffer_(std::move(buffer)) {}
+
+    size_t size() const override { return buffer_->size(); }
+    uint8_t* data() override { return buffer_->data(); }
+
+private:
+    std::shared_ptr<ValueBuffer> buffer_;
+};
+
+// Hands a buffer built for one call over to an ArrayBuffer
+class VectorMutableBuffer : public jsi::MutableBuffer {
+public:
+    explicit VectorMutableBuffer(std::vector<uint8_t> data) : data_(std::move(data)) {}
+
+    size_t size() const override { return data_.size(); }
+    uint8_t* data() override { return data_.data(); }
+
+private:
+    std::vector<uint8_t> data_;
+};
+
+// {keys, types, values} or, packed, {keys, types, buffer} in the layout of
+// packValues(): an array per column instead of an object per entry. Missing
+// keys have the type 'null'. `keys` is only set when the caller asked for it,
+// since a multi-get caller already has them.
+jsi::Object makeColumns(jsi::Runtime& runtime, PureStorageEngine& engine,
+                        const std::vector<std::string>& keys, bool packed, bool withKeys) {
+    ArenaScope scope;
+    std::vector<ItemView> items;
+    std::vector<bool> found;
+    engine.readMany(keys, scope.arena(), items, found);
+
+    jsi::Object result(runtime);
+    if (withKeys) {
+        jsi::Array keyColumn(runtime, keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            keyColumn.setValueAtIndex(runtime, i, makeString(runtime, keys[i]));
+        }
+        result.setProperty(runtime, "keys", keyColumn);
+    }
+
+    // A handful of types repeat down the column, so each becomes a JS string once
+    std::vector<std::pair<std::string_view, jsi::String>> typeStrings;
+    jsi::Array typeColumn(runtime, keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        std::string_view type = found[i] ? items[i].type : std::string_view("null");
+        auto it = std::find_if(typeStrings.begin(), typeStrings.end(),
+                               [type](const auto& entry) { return entry.first == type; });
+        if (it == typeStrings.end()) {
+            typeStrings.emplace_back(type, makeString(runtime, type));
+            it = typeStrings.end() - 1;
+        }
+        typeColumn.setValueAtIndex(runtime, i, jsi::Value(runtime, it->second));
+    }
+    result.setProperty(runtime, "types", typeColumn);
+
+    if (packed) {
+        std::vector<const ItemView*> present(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            present[i] = found[i] ? &items[i] : nullptr;
+        }
+        auto buffer = std::make_shared<VectorMutableBuffer>(packValues(present));
+        result.setProperty(runtime, "buffer", jsi::ArrayBuffer(runtime, std::move(buffer)));
+        return result;
+    }
+
+    jsi::Array valueColumn(runtime, keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (found[i] && items[i].type != "null") {
+            valueColumn.setValueAtIndex(runtime, i, makeString(runtime, items[i].value));
+        } else {
+            valueColumn.setValueAtIndex(runtime, i, jsi::Value::null());
+        }
+    }
+    result.setProperty(runtime, "values", valueColumn);
+    return result;
+}
+
+// {type, size, createdAt, modifiedAt, expiresAt, attributes}; times are null
+// where unknown, attributes are the JSON text or null
+jsi::Object makeStatObject(jsi::Runtime& runtime, const ItemStat& stat) {
+    auto time = [](int64_t ms) { return ms != 0 ? jsi::Value(static_cast<double>(ms)) : jsi::Value::null(); };
+
+    jsi::Object result(runtime);
+    result.setProperty(runtime, "type", makeString(runtime, stat.type));
+    result.setProperty(runtime, "size", static_cast<double>(stat.size));
+    result.setProperty(runtime, "createdAt", time(stat.createdAt));
+    result.setProperty(runtime, "modifiedAt", time(stat.modifiedAt));
+    result.setProperty(runtime, "expiresAt", time(stat.expiresAt));
+    if (stat.attributes.empty()) {
+        result.setProperty(runtime, "attributes", jsi::Value::null());
+    } else {
+        result.setProperty(runtime, "attributes", makeString(runtime, stat.attributes));
+    }
+    return result;
+}
+
+// Builds the JS values of a parsed document, a member name's PropNameID once
+// per document. Recursion is bounded by JsonDocument::kMaxDepth.
+class JsonBuilder {
+public:
+    JsonBuilder(jsi::Runtime& runtime, const JsonDocument& document) : runtime_(runtime), document_(document) {
+        names_.reserve(document.names().size());
+        for (const auto& name : document.names()) {
+            names_.push_back(jsi::PropNameID::forUtf8(runtime, name));
+        }
+    }
+
+    jsi::Value build(size_t index) {
+        using Kind = JsonDocument::Kind;
+        const auto& nodes = document_.nodes();
+        const auto& node = nodes[index];
+
+        switch (node.kind) {
+            case Kind::Null:
+                return jsi::Value::null();
+            case Kind::False:
+                return jsi::Value(false);
+            case Kind::True:
+                return jsi::Value(true);
+            case Kind::Number:
+                return jsi::Value(node.number);
+            case Kind::String:
+                return makeString(runtime_, document_.string(node));
+            case Kind::Array: {
+                jsi::Array array(runtime_, node.count);
+                size_t child = index + 1;
+                for (size_t i = 0; i < node.count; i++) {
+                    array.setValueAtIndex(runtime_, i, build(child));
+                    child = nodes[child].end;
+                }
+                return array;
+            }
+            case Kind::Object: {
+                jsi::Object object(runtime_);
+                for (size_t child = index + 1; child < node.end; child = nodes[child].end) {
+                    object.setProperty(runtime_, names_[nodes[child].name], build(child));
+                }
+                return object;
+            }
+        }
+        return jsi::Value::undefined();
+    }
+
+private:
+    jsi::Runtime& runtime_;
+    const JsonDocument& document_;
+    std::vector<jsi::PropNameID> names_;
+};
+
+jsi::Value makeJsonValue(jsi::Runtime& runtime, const JsonDocument& document) {
+    return JsonBuilder(runtime, document).build(0);
+}
+
+NamespaceConfig parseNamespaceConfig(jsi::Runtime& runtime, const jsi::Object& options) {
+    NamespaceConfig config;
+
+    jsi::Value durability = options.getProperty(runtime, "durability");
+    if (durability.isString()) {
+        std::string mode = durability.getString(runtime).utf8(runtime);
+        if (mode == "sync") {
+            config.durability = Durability::Sync;
+        } else if (mode == "async") {
+            config.durability = Durability::Async;
+        } else if (mode != "default") {
+            throw jsi::JSError(runtime, "durability must be 'sync', 'async' or 'default'");
+        }
+    }
+
+    jsi::Value compression = options.getProperty(runtime, "compression");
+    config.compression = compression.isBool() && compression.getBool();
+
+    jsi::Value encryption = options.getProperty(runtime, "encryption");
+    config.encryption = encryption.isBool() && encryption.getBool();
+
+    jsi::Value cacheBytes = options.getProperty(runtime, "cacheBytes");
+    if (cacheBytes.isNumber() && cacheBytes.getNumber() > 0) {
+        config.cacheBytes = static_cast<size_t>(cacheBytes.getNumber());
+    }
+
+    jsi::Value ttlDefault = options.getProperty(runtime, "ttlDefault");
+    if (ttlDefault.isNumber() && ttlDefault.getNumber() > 0) {
+        config.ttlDefaultMs = static_cast<int64_t>(ttlDefault.getNumber());
+    }
+
+    jsi::Value hideKeys = options.getProperty(runtime, "hideKeys");
+    config.hideKeys = hideKeys.isBool() && hideKeys.getBool();
+
+    jsi::Value quotaBytes = options.getProperty(runtime, "quotaBytes");
+    if (quotaBytes.isNumber() && quotaBytes.getNumber() > 0) {
+        config.quotaBytes = static_cast<uint64_t>(quotaBytes.getNumber());
+    }
+
+    jsi::Value maxValueBytes = options.getProperty(runtime, "maxValueBytes");
+    if (maxValueBytes.isNumber() && maxValueBytes.getNumber() > 0) {
+        config.maxValueBytes = static_cast<size_t>(maxValueBytes.getNumber());
+    }
+
+    return config;
+}
+
+} // namespace
+
+jsi::Object makeItemObject(jsi::Runtime& runtime, const ItemView& item) {
+    jsi::Object result(runtime);
+    result.setProperty(runtime, "type", makeString(runtime, item.type));
+    if (item.type == "null") {
+        result.setProperty(runtime, "value", jsi::Value::null());
+    } else {
+        result.setProperty(runtime, "value", makeString(runtime, item.value));
+    }
+    if (!item.attributes.empty()) {
+        result.setProperty(runtime, "attributes", makeString(runtime, item.attributes));
+    }
+    return result;
+}
+
+bool readDecodedItem(PureStorageEngine& engine, const std::string& key, DecodedItem& out) {
+    if (!engine.getItem(key, out.item)) {
+        return false;
+    }
+
+    // Small documents go to JSON.parse, which beats a property set per member on them
+    if (out.item.type == "object" && out.item.value.size() >= kParseOffThreadBytes && out.json.parse(out.item.value)) {
+        std::string().swap(out.item.value);
+    }
+    return true;
+}
+
+jsi::Object makeDecodedItemObject(jsi::Runtime& runtime, const DecodedItem& item) {
+    if (item.json.empty()) {
+        ItemView view;
+        view.type = item.item.type;
+        view.value = item.item.value;
+        view.attributes = item.item.attributes;
+        return makeItemObject(runtime, view);
+    }
+
+    jsi::Object result(runtime);
+    result.setProperty(runtime, "type", makeString(runtime, item.item.type));
+    result.setProperty(runtime, "value", makeJsonValue(runtime, item.json));
+    result.setProperty(runtime, "parsed", true);
+    if (!item.item.attributes.empty()) {
+        result.setProperty(runtime, "attributes", makeString(runtime, item.item.attributes));
+    }
+    return result;
+}
+
+jsi::Value runAsync(jsi::Runtime& runtime,
+                    std::shared_ptr<PureStorageEngine> engine,
+                    std::shared_ptr<facebook::react::CallInvoker> callInvoker,
+                    std::function<AsyncResult()> work) {
+    if (!callInvoker) {
+        throw jsi::JSError(runtime, "Async JSI operations are not available without a JS CallInvoker");
+    }
+
+    jsi::Function promise = runtime.global().getProperty(runtime, "Promise").asObject(runtime).asFunction(runtime);
+    jsi::Runtime* runtimePtr = &runtime;
+
+    auto executor = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "executor"),
+        2,  // Resolve, reject
+        [engine, callInvoker, work, runtimePtr](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+            auto resolve = std::make_shared<jsi::Function>(args[0].asObject(runtime).asFunction(runtime));
+            auto reject = std::make_shared<jsi::Function>(args[1].asObject(runtime).asFunction(runtime));
+
+            engine->worker().enqueue([work, callInvoker, runtimePtr, resolve, reject]() mutable {
+                AsyncResult result;
+                std::string error;
+                try {
+                    result = work();
+                } catch (const std::exception& e) {
+                    error = e.what();
+                }
+
+                // The JS functions are moved along so they're released on the JS thread
+                callInvoker->invokeAsync([runtimePtr, result = std::move(result), error = std::move(error),
+                                          resolve = std::move(resolve), reject = std::move(reject)]() {
+                    jsi::Runtime& runtime = *runtimePtr;
+                    std::string message = error;
+                    try {
+                        if (result) {
+                            resolve->call(runtime, result(runtime));
+                            return;
+                        }
+                    } catch (const std::exception& e) {
+                        message = e.what();
+                    }
+
+                    jsi::Function errorConstructor = runtime.global().getProperty(runtime, "Error").asObject(runtime).asFunction(runtime);
+                    reject->call(runtime, errorConstructor.callAsConstructor(runtime, jsi::String::createFromUtf8(runtime, message)));
+                });
+            });
+
+            return jsi::Value::undefined();
+        }
+    );
+
+    return promise.callAsConstructor(runtime, std::move(executor));
+}
+
+void installJSIPureStorage(jsi::Runtime& runtime,
+                           std::shared_ptr<PureStorageEngine> engine,
+                           std::shared_ptr<facebook::react::CallInvoker> callInvoker) {
+    auto hostObject = std::make_shared<JSIPureStorageHostObject>(std::move(engine), std::move(callInvoker));
+    runtime.global().setProperty(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "JSIPureStorage"),
+        jsi::Object::createFromHostObject(runtime, hostObject)
+    );
+}
+
+TickWriteBatcher::TickWriteBatcher(std::shared_ptr<PureStorageEngine> engine,
+                                   std::shared_ptr<facebook::react::CallInvoker> callInvoker)
+    : engine_(std::move(engine)), callInvoker_(std::move(callInvoker)) {}
+
+TickWriteBatcher::~TickWriteBatcher() {
+    if (commitQueued_) {
+        engine_->commitStaged();
+    }
+}
+
+bool TickWriteBatcher::setEnabled(bool enabled) {
+    enabled_ = enabled && callInvoker_ != nullptr;
+    if (!enabled_ && commitQueued_) {
+        commit();
+    }
+    return enabled_;
+}
+
+void TickWriteBatcher::willWrite() {
+    if (!enabled_ || commitQueued_) {
+        return;
+    }
+
+    engine_->beginStaging();
+    commitQueued_ = true;
+
+    // Runs once the current task is done, microtasks included
+    std::weak_ptr<TickWriteBatcher> weakSelf = shared_from_this();
+    callInvoker_->invokeAsync([weakSelf]() {
+        if (auto self = weakSelf.lock()) {
+            if (self->commitQueued_) {
+                self->commit();
+            }
+        }
+    });
+}
+
+void TickWriteBatcher::commit() {
+    commitQueued_ = false;
+    engine_->commitStaged();
+}
+
+JSIPureStorageHostObject::JSIPureStorageHostObject(std::shared_ptr<PureStorageEngine> engine,
+                                                   std::shared_ptr<facebook::react::CallInvoker> callInvoker)
+    : engine_(std::move(engine)),
+      callInvoker_(std::move(callInvoker)),
+      batcher_(std::make_shared<TickWriteBatcher>(engine_, callInvoker_)),
+      subscriptions_(std::make_shared<SubscriptionTable>(engine_, callInvoker_)) {}
+
+jsi::Value JSIPureStorageHostObject::get(jsi::Runtime& runtime, const jsi::PropNameID& propName) {
+    std::string name = propName.utf8(runtime);
+
+    // setItem
+    if (name == "setItemSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "setItemSync"),
+            6,  // Key, type, value, encrypted, attributes, compressed
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 4) {
+                    return jsi::Value(false);
+                }
+
+                std::string key = args[0].asString(runtime).utf8(runtime);
+                std::string type = args[1].asString(runtime).utf8(runtime);
+                std::string value = args[2].isString() ? args[2].getString(runtime).utf8(runtime) : std::string();
+                bool encrypted = args[3].isBool() && args[3].getBool();
+                // Serialized by the JS wrapper as a JSON object
+                std::string attributes = count > 4 && args[4].isString() ? args[4].getString(runtime).utf8(runtime) : std::string();
+                // Deflated by the platform backend and inflated again on read
+                bool compressed = count > 5 && args[5].isBool() && args[5].getBool();
+
+                batcher_->willWrite();
+                return jsi::Value(engine_->setItem(key, type, value, encrypted, attributes, compressed));
+            }
+        );
+    }
+
+    // getItem
+    else if (name == "getItemSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "getItemSync"),
+            1,  // Key
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1) {
+                    return jsi::Value::null();
+                }
+
+                std::string key = args[0].asString(runtime).utf8(runtime);
+
+                // The item is staged in the call's arena rather than copied to the heap
+                ArenaScope scope;
+                ItemView item;
+                bool found = false;
+                engine_->read(engine_->resolve(key), scope.arena(), item, found);
+                if (!found) {
+                    return jsi::Value::null();
+                }
+
+                return makeItemObject(runtime, item);
+            }
+        );
+    }
+
+    // getItemAsync
+    else if (name == "getItemAsync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "getItemAsync"),
+            1,  // Key
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1 || !args[0].isString()) {
+                    throw jsi::JSError(runtime, "getItemAsync expects a string key");
+                }
+
+                // Reading, decrypting, decompressing and parsing happen on the worker
+                std::string key = args[0].getString(runtime).utf8(runtime);
+                auto engine = engine_;
+                return runAsync(runtime, engine_, callInvoker_, [engine, key = std::move(key)]() -> AsyncResult {
+                    auto item = std::make_shared<DecodedItem>();
+                    if (!readDecodedItem(*engine, key, *item)) {
+                        return [](jsi::Runtime&) { return jsi::Value::null(); };
+                    }
+                    return [item](jsi::Runtime& runtime) -> jsi::Value { return makeDecodedItemObject(runtime, *item); };
+                });
+            }
+        );
+    }
+
+    // getBuffer
+    else if (name == "getBufferSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "getBufferSync"),
+            1,  // Key
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1) {
+                    return jsi::Value::null();
+                }
+
+                std::string key = args[0].asString(runtime).utf8(runtime);
+                std::shared_ptr<ValueBuffer> buffer = engine_->getBuffer(key);
+                if (!buffer) {
+                    return jsi::Value::null();
+                }
+
+                return jsi::ArrayBuffer(runtime, std::make_shared<ValueMutableBuffer>(std::move(buffer)));
+            }
+        );
+    }
+
+    // stat
+    else if (name == "statSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "statSync"),
+            1,  // Key
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1) {
+                    return jsi::Value::null();
+                }
+
+                std::string key = args[0].asString(runtime).utf8(runtime);
+                ItemStat stat;
+                if (!engine_->stat(key, stat)) {
+                    return jsi::Value::null();
+                }
+                return makeStatObject(runtime, stat);
+            }
+        );
+    }
+
+    // listWithStat
+    else if (name == "listWithStatSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "listWithStatSync"),
+            1,  // Prefix
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                std::string prefix = count > 0 && args[0].isString() ? args[0].getString(runtime).utf8(runtime) : std::string();
+                std::vector<std::pair<std::string, ItemStat>> entries = engine_->listWithStat(prefix);
+
+                jsi::Array result(runtime, entries.size());
+                for (size_t i = 0; i < entries.size(); i++) {
+                    jsi::Object entry = makeStatObject(runtime, entries[i].second);
+                    entry.setProperty(runtime, "key", makeString(runtime, entries[i].first));
+                    result.setValueAtIndex(runtime, i, entry);
+                }
+                return result;
+            }
+        );
+    }
+
+    // multiGetColumns
+    else if (name == "multiGetColumnsSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "multiGetColumnsSync"),
+            2,  // Keys, packed
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1) {
+                    return jsi::Value::null();
+                }
+
+                jsi::Array keyArray = args[0].asObject(runtime).asArray(runtime);
+                std::vector<std::string> keys(keyArray.size(runtime));
+                for (size_t i = 0; i < keys.size(); i++) {
+                    keys[i] = keyArray.getValueAtIndex(runtime, i).asString(runtime).utf8(runtime);
+                }
+                bool packed = count > 1 && args[1].isBool() && args[1].getBool();
+
+                return makeColumns(runtime, *engine_, keys, packed, false);
+            }
+        );
+    }
+
+    // scanColumns
+    else if (name == "scanColumnsSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "scanColumnsSync"),
+            2,  // Prefix, packed
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                std::string prefix = count > 0 && args[0].isString() ? args[0].getString(runtime).utf8(runtime) : std::string();
+                bool packed = count > 1 && args[1].isBool() && args[1].getBool();
+
+                return makeColumns(runtime, *engine_, engine_->keysWithPrefix(prefix), packed, true);
+            }
+        );
+    }
+
+    // getIfChanged
+    else if (name == "getIfChangedSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "getIfChangedSync"),
+            2,  // Key, last seen version
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1) {
+                    return jsi::Value::null();
+                }
+
+                std::string key = args[0].asString(runtime).utf8(runtime);
+                double lastVersion = count > 1 && args[1].isNumber() ? args[1].getNumber() : -1;
+
+                // Unchanged keys cost one integer compare and copy nothing
+                SlotRef slot = engine_->resolve(key);
+                if (static_cast<double>(slot->version.load(std::memory_order_acquire)) == lastVersion) {
+                    return jsi::Value::undefined();
+                }
+
+                ArenaScope scope;
+                ItemView item;
+                bool found = false;
+                uint64_t version = engine_->read(slot, scope.arena(), item, found);
+
+                if (!found) {
+                    item.type = "null";
+                }
+
+                jsi::Object result = makeItemObject(runtime, item);
+                result.setProperty(runtime, "version", static_cast<double>(version));
+                return result;
+            }
+        );
+    }
+
+    // removeItem
+    else if (name == "removeItemSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "removeItemSync"),
+            1,  // Key
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1) {
+                    return jsi::Value(false);
+                }
+
+                std::string key = args[0].asString(runtime).utf8(runtime);
+                return jsi::Value(engine_->removeItem(key));
+            }
+        );
+    }
+
+    // clear
+    else if (name == "clearSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "clearSync"),
+            0,
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                return jsi::Value(engine_->clear());
+            }
+        );
+    }
+
+    // getAllKeys
+    else if (name == "getAllKeysSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "getAllKeysSync"),
+            0,
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                std::vector<std::string> keys = engine_->getAllKeys();
+
+                jsi::Array result(runtime, keys.size());
+                for (size_t i = 0; i < keys.size(); i++) {
+                    result.setValueAtIndex(runtime, i, jsi::String::createFromUtf8(runtime, keys[i]));
+                }
+
+                return result;
+            }
+        );
+    }
+
+    // hasKey
+    else if (name == "hasKeySync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "hasKeySync"),
+            1,  // Key
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1) {
+                    return jsi::Value(false);
+                }
+
+                std::string key = args[0].asString(runtime).utf8(runtime);
+                return jsi::Value(engine_->hasKey(key));
+            }
+        );
+    }
+
+    // key handle
+    else if (name == "key") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "key"),
+            1,  // Key
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1) {
+                    throw jsi::JSError(runtime, "JSIPureStorage.key expects a key");
+                }
+
+                std::string key = args[0].asString(runtime).utf8(runtime);
+                auto handle = std::make_shared<KeyHandleHostObject>(engine_, engine_->resolve(key), callInvoker_, batcher_, subscriptions_);
+                return jsi::Object::createFromHostObject(runtime, handle);
+            }
+        );
+    }
+
+    // prefetch
+    else if (name == "prefetchAsync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "prefetchAsync"),
+            1,  // Array of keys or key prefix
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1) {
+                    throw jsi::JSError(runtime, "prefetchAsync expects an array of keys or a key prefix");
+                }
+
+                // Arguments are copied out here; the worker never touches JS values
+                std::vector<std::string> keys;
+                std::string prefix;
+                bool byPrefix = args[0].isString();
+
+                if (byPrefix) {
+                    prefix = args[0].getString(runtime).utf8(runtime);
+                } else {
+                    jsi::Array array = args[0].asObject(runtime).asArray(runtime);
+                    size_t length = array.size(runtime);
+                    keys.reserve(length);
+                    for (size_t i = 0; i < length; i++) {
+                        keys.push_back(array.getValueAtIndex(runtime, i).asString(runtime).utf8(runtime));
+                    }
+                }
+
+                auto engine = engine_;
+                return runAsync(runtime, engine_, callInvoker_, [engine, keys = std::move(keys), prefix, byPrefix]() -> AsyncResult {
+                    size_t loaded = byPrefix ? engine->prefetchPrefix(prefix) : engine->prefetch(keys);
+                    return [loaded](jsi::Runtime&) {
+                        return jsi::Value(static_cast<double>(loaded));
+                    };
+                });
+            }
+        );
+    }
+
+    // configureNamespace
+    else if (name == "configureNamespace") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "configureNamespace"),
+            2,  // Name, options
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 2 || !args[1].isObject()) {
+                    throw jsi::JSError(runtime, "configureNamespace expects a name and an options object");
+                }
+
+                std::string ns = args[0].asString(runtime).utf8(runtime);
+                engine_->configureNamespace(ns, parseNamespaceConfig(runtime, args[1].getObject(runtime)));
+                return jsi::Value::undefined();
+            }
+        );
+    }
+
+    // shredNamespace
+    else if (name == "shredNamespace") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "shredNamespace"),
+            1,  // Name
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1 || !args[0].isString()) {
+                    throw jsi::JSError(runtime, "shredNamespace expects a namespace name");
+                }
+
+                return jsi::Value(engine_->shredNamespace(args[0].getString(runtime).utf8(runtime)));
+            }
+        );
+    }
+
+    // getNamespaceStats
+    else if (name == "getNamespaceStats") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "getNamespaceStats"),
+            0,
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                jsi::Object result(runtime);
+                for (const auto& stats : engine_->namespaceStats()) {
+                    jsi::Object entry(runtime);
+                    entry.setProperty(runtime, "usedBytes", static_cast<double>(stats.usedBytes));
+                    entry.setProperty(runtime, "keys", static_cast<double>(stats.keys));
+                    entry.setProperty(runtime, "measured", stats.measured);
+                    entry.setProperty(runtime, "rejectedWrites", static_cast<double>(stats.rejectedWrites));
+                    if (stats.largestBytes > 0) {
+                        entry.setProperty(runtime, "largestKey", jsi::String::createFromUtf8(runtime, stats.largestKey));
+                        entry.setProperty(runtime, "largestBytes", static_cast<double>(stats.largestBytes));
+                    }
+                    result.setProperty(runtime, jsi::PropNameID::forUtf8(runtime, stats.name), entry);
+                }
+                return result;
+            }
+        );
+    }
+
+    // flushSync
+    else if (name == "flushSync") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "flushSync"),
+            0,
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                // True once nothing is left buffered
+                return jsi::Value(engine_->flush() == 0);
+            }
+        );
+    }
+
+    // setWriteBatching
+    else if (name == "setWriteBatching") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "setWriteBatching"),
+            1,  // Enabled
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                bool enabled = count > 0 && args[0].isBool() && args[0].getBool();
+                return jsi::Value(batcher_->setEnabled(enabled));
+            }
+        );
+    }
+
+    // metrics
+    else if (name == "getMetrics") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "getMetrics"),
+            0,
+            [this](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                EngineMetrics metrics = engine_->metrics();
+
+                jsi::Object result(runtime);
+                result.setProperty(runtime, "openMs", metrics.openMs);
+                result.setProperty(runtime, "openWaits", static_cast<double>(metrics.openWaits));
+                result.setProperty(runtime, "openWaitMs", metrics.openWaitMs);
+                result.setProperty(runtime, "pendingWrites", static_cast<double>(metrics.pendingWrites));
+                result.setProperty(runtime, "flushes", static_cast<double>(metrics.flushes));
+                result.setProperty(runtime, "flushedWrites", static_cast<double>(metrics.flushedWrites));
+                result.setProperty(runtime, "inlineReads", static_cast<double>(metrics.inlineReads));
+
+                ArenaStats arena = Arena::stats();
+                result.setProperty(runtime, "arenaAllocations", static_cast<double>(arena.allocations));
+                result.setProperty(runtime, "arenaBytes", static_cast<double>(arena.bytes));
+                result.setProperty(runtime, "arenaBlockAllocations", static_cast<double>(arena.blockAllocations));
+                result.setProperty(runtime, "arenaResets", static_cast<double>(arena.resets));
+                return result;
+            }
+        );
+    }
+
+    // Return undefined for unknown properties
+    return jsi::Value::undefined();
+}
+
+} // namespace pure_storage
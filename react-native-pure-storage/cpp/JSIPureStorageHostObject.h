@@ -0,0 +1,101 @@
+#pragma once
+
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+
+#include <functional>
+#include <memory>
+
+#include "JsonDocument.h"
+#include "PureStorageEngine.h"
+
+namespace pure_storage {
+
+namespace jsi = facebook::jsi;
+
+// Builds the { type, value } object returned to JS for a stored item
+jsi::Object makeItemObject(jsi::Runtime& runtime, const ItemView& item);
+
+// An item read for an async get. Object values of kParseOffThreadBytes or
+// more are parsed on the worker as well, so the JS thread only builds the
+// objects instead of running JSON.parse over the whole text.
+struct DecodedItem {
+    StoredItem item;
+    // Empty when the value wasn't parsed; its text is in item.value then
+    JsonDocument json;
+};
+
+constexpr size_t kParseOffThreadBytes = 4 * 1024;
+
+// Reads the key and parses its value; false if the key doesn't exist.
+// Called on the engine worker.
+bool readDecodedItem(PureStorageEngine& engine, const std::string& key, DecodedItem& out);
+
+// makeItemObject() for a DecodedItem; a parsed value is set as the object
+// itself, with `parsed: true`
+jsi::Object makeDecodedItemObject(jsi::Runtime& runtime, const DecodedItem& item);
+
+// Produces the JS result of an async operation; always called on the JS thread
+using AsyncResult = std::function<jsi::Value(jsi::Runtime&)>;
+
+// Runs work on the engine worker and returns a Promise settled on the JS
+// thread with the value produced by the AsyncResult the work returns.
+// Throws if there is no CallInvoker to get back onto the JS thread.
+jsi::Value runAsync(jsi::Runtime& runtime,
+                    std::shared_ptr<PureStorageEngine> engine,
+                    std::shared_ptr<facebook::react::CallInvoker> callInvoker,
+                    std::function<AsyncResult()> work);
+
+// Sets global.JSIPureStorage to a host object on the engine. Called by the
+// platform installs and by PureStorageTurboModule.install().
+void installJSIPureStorage(jsi::Runtime& runtime,
+                           std::shared_ptr<PureStorageEngine> engine,
+                           std::shared_ptr<facebook::react::CallInvoker> callInvoker);
+
+// Opt-in batching of the sync writes made during one JS task. The first
+// write of a task puts the engine into staging and queues a commit behind
+// the task (and its microtasks) on the CallInvoker, so the task's writes
+// reach storage as one group commit. Only used on the JS thread.
+class TickWriteBatcher : public std::enable_shared_from_this<TickWriteBatcher> {
+public:
+    TickWriteBatcher(std::shared_ptr<PureStorageEngine> engine,
+                     std::shared_ptr<facebook::react::CallInvoker> callInvoker);
+    // Commits anything still staged
+    ~TickWriteBatcher();
+
+    // Turning batching off commits what the current task staged. Returns
+    // whether batching is on, which needs a CallInvoker.
+    bool setEnabled(bool enabled);
+
+    // Called before every sync write
+    void willWrite();
+
+private:
+    void commit();
+
+    std::shared_ptr<PureStorageEngine> engine_;
+    std::shared_ptr<facebook::react::CallInvoker> callInvoker_;
+    bool enabled_ = false;
+    bool commitQueued_ = false;
+};
+
+class SubscriptionTable;
+
+// The global.JSIPureStorage object, shared by the Android and iOS bindings
+class JSIPureStorageHostObject : public jsi::HostObject {
+public:
+    JSIPureStorageHostObject(std::shared_ptr<PureStorageEngine> engine,
+                             std::shared_ptr<facebook::react::CallInvoker> callInvoker);
+
+    jsi::Value get(jsi::Runtime& runtime, const jsi::PropNameID& propName) override;
+
+private:
+    std::shared_ptr<PureStorageEngine> engine_;
+    std::shared_ptr<facebook::react::CallInvoker> callInvoker_;
+    // Shared with the key handles, whose set() is a sync write too
+    std::shared_ptr<TickWriteBatcher> batcher_;
+    // Key handle subscriptions, dropped with this object when the runtime goes away
+    std::shared_ptr<SubscriptionTable> subscriptions_;
+};
+
+} // namespace pure_storage
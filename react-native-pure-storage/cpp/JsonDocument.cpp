@@ -0,0 +1,390 @@
+#include "JsonDocument.h"
+
+#include <cstdlib>
+#include <limits>
+#include <unordered_map>
+
+namespace pure_storage {
+
+namespace {
+
+using Kind = JsonDocument::Kind;
+using Node = JsonDocument::Node;
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+void appendUtf8(std::string& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+class Parser {
+public:
+    Parser(std::string_view text, std::vector<Node>& nodes, std::vector<std::string>& names, std::string& strings)
+        : pos_(text.data()), end_(text.data() + text.size()), nodes_(nodes), names_(names), strings_(strings) {}
+
+    bool parseDocument() {
+        skipWhitespace();
+        if (!parseValue(0, 0)) {
+            return false;
+        }
+        skipWhitespace();
+        return pos_ == end_;
+    }
+
+private:
+    void skipWhitespace() {
+        while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t')) {
+            pos_++;
+        }
+    }
+
+    bool consume(char c) {
+        if (pos_ < end_ && *pos_ == c) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeLiteral(std::string_view literal) {
+        if (static_cast<size_t>(end_ - pos_) < literal.size() || std::string_view(pos_, literal.size()) != literal) {
+            return false;
+        }
+        pos_ += literal.size();
+        return true;
+    }
+
+    // Nodes are addressed by index, since parsing children grows the vector
+    bool parseValue(uint32_t name, size_t depth) {
+        if (pos_ == end_) {
+            return false;
+        }
+
+        size_t index = nodes_.size();
+        nodes_.emplace_back();
+        nodes_[index].name = name;
+
+        bool parsed = false;
+        switch (*pos_) {
+            case '{':
+                parsed = parseObject(index, depth + 1);
+                break;
+            case '[':
+                parsed = parseArray(index, depth + 1);
+                break;
+            case '"':
+                parsed = parseString(scratch_);
+                if (parsed) {
+                    nodes_[index].kind = Kind::String;
+                    nodes_[index].text.offset = static_cast<uint32_t>(strings_.size());
+                    nodes_[index].text.length = static_cast<uint32_t>(scratch_.size());
+                    strings_ += scratch_;
+                }
+                break;
+            case 't':
+                parsed = consumeLiteral("true");
+                nodes_[index].kind = Kind::True;
+                break;
+            case 'f':
+                parsed = consumeLiteral("false");
+                nodes_[index].kind = Kind::False;
+                break;
+            case 'n':
+                parsed = consumeLiteral("null");
+                nodes_[index].kind = Kind::Null;
+                break;
+            default:
+                parsed = parseNumber(nodes_[index]);
+                break;
+        }
+
+        if (!parsed) {
+            return false;
+        }
+        nodes_[index].end = static_cast<uint32_t>(nodes_.size());
+        return true;
+    }
+
+    bool parseObject(size_t index, size_t depth) {
+        if (depth > JsonDocument::kMaxDepth) {
+            return false;
+        }
+        pos_++;
+        nodes_[index].kind = Kind::Object;
+
+        skipWhitespace();
+        if (consume('}')) {
+            return true;
+        }
+
+        uint32_t count = 0;
+        while (true) {
+            if (pos_ == end_ || *pos_ != '"' || !parseString(scratch_)) {
+                return false;
+            }
+            if (scratch_ == "__proto__") {
+                return false;
+            }
+            uint32_t name = intern(scratch_);
+
+            skipWhitespace();
+            if (!consume(':')) {
+                return false;
+            }
+            skipWhitespace();
+            if (!parseValue(name, depth)) {
+                return false;
+            }
+            count++;
+
+            skipWhitespace();
+            if (consume(',')) {
+                skipWhitespace();
+                continue;
+            }
+            if (consume('}')) {
+                break;
+            }
+            return false;
+        }
+
+        nodes_[index].count = count;
+        return true;
+    }
+
+    bool parseArray(size_t index, size_t depth) {
+        if (depth > JsonDocument::kMaxDepth) {
+            return false;
+        }
+        pos_++;
+        nodes_[index].kind = Kind::Array;
+
+        skipWhitespace();
+        if (consume(']')) {
+            return true;
+        }
+
+        uint32_t count = 0;
+        while (true) {
+            if (!parseValue(0, depth)) {
+                return false;
+            }
+            count++;
+
+            skipWhitespace();
+            if (consume(',')) {
+                skipWhitespace();
+                continue;
+            }
+            if (consume(']')) {
+                break;
+            }
+            return false;
+        }
+
+        nodes_[index].count = count;
+        return true;
+    }
+
+    bool parseHex4(uint32_t& value) {
+        if (end_ - pos_ < 4) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            int digit = hexDigit(pos_[i]);
+            if (digit < 0) {
+                return false;
+            }
+            value = (value << 4) | static_cast<uint32_t>(digit);
+        }
+        pos_ += 4;
+        return true;
+    }
+
+    // Unescapes the string at pos_ into `out`
+    bool parseString(std::string& out) {
+        out.clear();
+        pos_++;
+
+        while (true) {
+            // Copy the run up to the next quote, escape or control character at once
+            const char* run = pos_;
+            while (pos_ < end_ && *pos_ != '"' && *pos_ != '\\' && static_cast<unsigned char>(*pos_) >= 0x20) {
+                pos_++;
+            }
+            out.append(run, pos_ - run);
+
+            if (pos_ == end_ || static_cast<unsigned char>(*pos_) < 0x20) {
+                return false;
+            }
+            if (*pos_++ == '"') {
+                return true;
+            }
+
+            if (pos_ == end_) {
+                return false;
+            }
+            switch (*pos_++) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t codePoint = 0;
+                    if (!parseHex4(codePoint)) {
+                        return false;
+                    }
+                    if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                        // A high surrogate only makes a character with the low one after it
+                        uint32_t low = 0;
+                        if (!consumeLiteral("\\u") || !parseHex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                            return false;
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                        return false;
+                    }
+                    appendUtf8(out, codePoint);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+    }
+
+    bool parseNumber(Node& node) {
+        const char* start = pos_;
+        bool negative = consume('-');
+
+        const char* digits = pos_;
+        if (consume('0')) {
+            // No leading zeros
+        } else if (pos_ < end_ && *pos_ >= '1' && *pos_ <= '9') {
+            while (pos_ < end_ && isDigit(*pos_)) {
+                pos_++;
+            }
+        } else {
+            return false;
+        }
+        size_t integerDigits = pos_ - digits;
+
+        bool integral = true;
+        if (consume('.')) {
+            integral = false;
+            if (pos_ == end_ || !isDigit(*pos_)) {
+                return false;
+            }
+            while (pos_ < end_ && isDigit(*pos_)) {
+                pos_++;
+            }
+        }
+        if (pos_ < end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+            integral = false;
+            pos_++;
+            if (!consume('+')) {
+                consume('-');
+            }
+            if (pos_ == end_ || !isDigit(*pos_)) {
+                return false;
+            }
+            while (pos_ < end_ && isDigit(*pos_)) {
+                pos_++;
+            }
+        }
+
+        node.kind = Kind::Number;
+        if (integral && integerDigits <= 15) {
+            // Exact in a double, so no need for strtod
+            int64_t value = 0;
+            for (const char* c = digits; c < pos_; c++) {
+                value = value * 10 + (*c - '0');
+            }
+            // -0 stays negative, as with JSON.parse
+            node.number = negative ? -static_cast<double>(value) : static_cast<double>(value);
+            return true;
+        }
+
+        // strtod needs a terminated string; the grammar was checked above
+        std::string terminated(start, pos_ - start);
+        node.number = std::strtod(terminated.c_str(), nullptr);
+        return true;
+    }
+
+    uint32_t intern(const std::string& name) {
+        auto it = nameIndex_.find(name);
+        if (it != nameIndex_.end()) {
+            return it->second;
+        }
+        uint32_t index = static_cast<uint32_t>(names_.size());
+        names_.push_back(name);
+        nameIndex_.emplace(name, index);
+        return index;
+    }
+
+    const char* pos_;
+    const char* end_;
+    std::vector<Node>& nodes_;
+    std::vector<std::string>& names_;
+    std::string& strings_;
+    std::unordered_map<std::string, uint32_t> nameIndex_;
+    std::string scratch_;
+};
+
+} // namespace
+
+bool JsonDocument::parse(std::string_view text) {
+    nodes_.clear();
+    names_.clear();
+    strings_.clear();
+
+    // Offsets into the string pool, which is never longer than the text, are 32-bit
+    if (text.size() > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    Parser parser(text, nodes_, names_, strings_);
+    if (!parser.parseDocument()) {
+        nodes_.clear();
+        names_.clear();
+        strings_.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace pure_storage
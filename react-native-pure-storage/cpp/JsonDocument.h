@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pure_storage {
+
+// JSON text parsed into a flat tree, so an async read can do the parsing on
+// the engine worker and leave only object construction to the JS thread.
+// Nodes are stored in pre-order: a container's children follow it, and each
+// node records where its subtree ends. Strings are unescaped into one pool,
+// and member names are interned, so a name repeated down an array of
+// objects is stored (and later turned into a JS property name) once.
+class JsonDocument {
+public:
+    enum class Kind : uint8_t { Null, False, True, Number, String, Array, Object };
+
+    struct Node {
+        Kind kind = Kind::Null;
+        // Index into names() of the member name, for members of an object
+        uint32_t name = 0;
+        // Elements or members, for containers
+        uint32_t count = 0;
+        // Index one past the node's subtree
+        uint32_t end = 0;
+        union {
+            double number;
+            struct {
+                uint32_t offset;
+                uint32_t length;
+            } text;
+        };
+
+        Node() : number(0) {}
+    };
+
+    // Parses `text` the way JSON.parse would. False, leaving the document
+    // empty, when it doesn't parse or parses to something this tree can't
+    // reproduce exactly: lone surrogate escapes, a "__proto__" member (which
+    // JSON.parse defines but a property set would treat as the prototype),
+    // or nesting deeper than kMaxDepth. Callers fall back to JSON.parse then.
+    bool parse(std::string_view text);
+
+    bool empty() const { return nodes_.empty(); }
+    const std::vector<Node>& nodes() const { return nodes_; }
+    const std::vector<std::string>& names() const { return names_; }
+
+    std::string_view string(const Node& node) const {
+        return std::string_view(strings_).substr(node.text.offset, node.text.length);
+    }
+
+    static constexpr size_t kMaxDepth = 256;
+
+private:
+    std::vector<Node> nodes_;
+    std::vector<std::string> names_;
+    std::string strings_;
+};
+
+} // namespace pure_storage
@@ -0,0 +1,192 @@
+#include "KeyHandleHostObject.h"
+
+#include <string>
+
+#include "JSIPureStorageHostObject.h"
+
+namespace pure_storage {
+
+KeyHandleHostObject::KeyHandleHostObject(std::shared_ptr<PureStorageEngine> engine,
+                                         SlotRef slot,
+                                         std::shared_ptr<facebook::react::CallInvoker> callInvoker,
+                                         std::shared_ptr<TickWriteBatcher> batcher,
+                                         std::weak_ptr<SubscriptionTable> subscriptions)
+    : engine_(std::move(engine)),
+      slot_(std::move(slot)),
+      callInvoker_(std::move(callInvoker)),
+      batcher_(std::move(batcher)),
+      subscriptions_(std::move(subscriptions)) {}
+
+jsi::Value KeyHandleHostObject::get(jsi::Runtime& runtime, const jsi::PropNameID& propName) {
+    std::string name = propName.utf8(runtime);
+
+    if (name == "key") {
+        return jsi::String::createFromUtf8(runtime, slot_->key);
+    }
+
+    if (name == "version") {
+        return jsi::Value(static_cast<double>(slot_->version.load(std::memory_order_acquire)));
+    }
+
+    // Functions are created once per handle; they hold the engine and slot
+    // rather than the handle itself so they stay valid if the handle is collected
+    auto cached = functions_.find(name);
+    if (cached != functions_.end()) {
+        return jsi::Value(runtime, cached->second);
+    }
+
+    jsi::Value function = createFunction(runtime, name);
+    if (function.isUndefined()) {
+        return function;
+    }
+
+    auto inserted = functions_.emplace(name, jsi::Value(runtime, function));
+    return jsi::Value(runtime, inserted.first->second);
+}
+
+jsi::Value KeyHandleHostObject::createFunction(jsi::Runtime& runtime, const std::string& name) {
+    auto engine = engine_;
+    auto slot = slot_;
+
+    // get; the JS wrapper caches the value against `version`
+    if (name == "get") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "get"),
+            0,
+            [engine, slot](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                ArenaScope scope;
+                ItemView item;
+                bool found = false;
+                engine->read(slot, scope.arena(), item, found);
+                return found ? jsi::Value(makeItemObject(runtime, item)) : jsi::Value::null();
+            }
+        );
+    }
+
+    // set
+    else if (name == "set") {
+        auto batcher = batcher_;
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "set"),
+            3,  // Type, value, encrypted
+            [engine, slot, batcher](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 2) {
+                    return jsi::Value(false);
+                }
+
+                std::string type = args[0].asString(runtime).utf8(runtime);
+                std::string value = args[1].isString() ? args[1].getString(runtime).utf8(runtime) : std::string();
+                bool encrypted = count > 2 && args[2].isBool() && args[2].getBool();
+
+                batcher->willWrite();
+                return jsi::Value(engine->write(slot, type, value, encrypted));
+            }
+        );
+    }
+
+    // remove
+    else if (name == "remove") {
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "remove"),
+            0,
+            [engine, slot](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                return jsi::Value(engine->erase(slot));
+            }
+        );
+    }
+
+    // subscribe
+    else if (name == "subscribe") {
+        std::weak_ptr<SubscriptionTable> subscriptions = subscriptions_;
+        return jsi::Function::createFromHostFunction(
+            runtime,
+            jsi::PropNameID::forAscii(runtime, "subscribe"),
+            1,  // Callback
+            [slot, subscriptions](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                if (count < 1 || !args[0].isObject() || !args[0].getObject(runtime).isFunction(runtime)) {
+                    throw jsi::JSError(runtime, "subscribe expects a callback function");
+                }
+
+                auto table = subscriptions.lock();
+                if (!table) {
+                    throw jsi::JSError(runtime, "JSIPureStorage is no longer available");
+                }
+                uint64_t id = table->subscribe(runtime, slot->key, args[0].getObject(runtime).getFunction(runtime));
+
+                return jsi::Function::createFromHostFunction(
+                    runtime,
+                    jsi::PropNameID::forAscii(runtime, "unsubscribe"),
+                    0,
+                    [subscriptions, id](jsi::Runtime& runtime, const jsi::Value& thisVal, const jsi::Value* args, size_t count) -> jsi::Value {
+                        if (auto table = subscriptions.lock()) {
+                            table->unsubscribe(id);
+                        }
+                        return jsi::Value::undefined();
+                    }
+                );
+            }
+        );
+    }
+
+    return jsi::Value::undefined();
+}
+
+SubscriptionTable::SubscriptionTable(std::shared_ptr<PureStorageEngine> engine,
+                                     std::shared_ptr<facebook::react::CallInvoker> callInvoker)
+    : engine_(std::move(engine)), callInvoker_(std::move(callInvoker)) {}
+
+SubscriptionTable::~SubscriptionTable() {
+    for (const auto& entry : subscriptions_) {
+        engine_->removeListener(entry.second.key, entry.second.listener);
+    }
+}
+
+uint64_t SubscriptionTable::subscribe(jsi::Runtime& runtime, const std::string& key, jsi::Function callback) {
+    runtime_ = &runtime;
+    uint64_t id = ++nextId_;
+
+    // Changes can come from any thread (e.g. the async module), so callbacks
+    // are always delivered on the JS thread through the CallInvoker
+    std::weak_ptr<SubscriptionTable> weakSelf = shared_from_this();
+    auto callInvoker = callInvoker_;
+    ListenerId listener = engine_->addListener(
+        key,
+        [weakSelf, callInvoker, id](const std::string& /*key*/, uint64_t version) {
+            if (!callInvoker) {
+                return;
+            }
+            callInvoker->invokeAsync([weakSelf, id, version]() {
+                if (auto self = weakSelf.lock()) {
+                    self->deliver(id, version);
+                }
+            });
+        }
+    );
+
+    subscriptions_.emplace(id, Subscription{key, listener, std::make_shared<jsi::Function>(std::move(callback))});
+    return id;
+}
+
+void SubscriptionTable::unsubscribe(uint64_t id) {
+    auto it = subscriptions_.find(id);
+    if (it == subscriptions_.end()) {
+        return;
+    }
+    engine_->removeListener(it->second.key, it->second.listener);
+    subscriptions_.erase(it);
+}
+
+void SubscriptionTable::deliver(uint64_t id, uint64_t version) {
+    auto it = subscriptions_.find(id);
+    if (it == subscriptions_.end()) {
+        return;
+    }
+    // Held across the call in case the callback unsubscribes itself
+    auto callback = it->second.callback;
+    callback->call(*runtime_, jsi::Value(static_cast<double>(version)));
+}
+
+} // namespace pure_storage
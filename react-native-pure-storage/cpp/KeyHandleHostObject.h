@@ -0,0 +1,77 @@
+#pragma once
+
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "PureStorageEngine.h"
+
+namespace pure_storage {
+
+namespace jsi = facebook::jsi;
+
+class TickWriteBatcher;
+
+// The key handle subscriptions of one runtime, keyed by subscription id. Only
+// touched on the JS thread: the engine listeners capture just the id and a
+// weak reference, so callbacks are never copied or released on the writing
+// thread, and whatever is still subscribed goes away with the table.
+class SubscriptionTable : public std::enable_shared_from_this<SubscriptionTable> {
+public:
+    SubscriptionTable(std::shared_ptr<PureStorageEngine> engine,
+                      std::shared_ptr<facebook::react::CallInvoker> callInvoker);
+    // Removes the engine listeners of everything still subscribed
+    ~SubscriptionTable();
+
+    // Returns the id to unsubscribe with
+    uint64_t subscribe(jsi::Runtime& runtime, const std::string& key, jsi::Function callback);
+    void unsubscribe(uint64_t id);
+
+private:
+    struct Subscription {
+        std::string key;
+        ListenerId listener;
+        std::shared_ptr<jsi::Function> callback;
+    };
+
+    void deliver(uint64_t id, uint64_t version);
+
+    std::shared_ptr<PureStorageEngine> engine_;
+    std::shared_ptr<facebook::react::CallInvoker> callInvoker_;
+    // The runtime owning the table, set by the first subscribe
+    jsi::Runtime* runtime_ = nullptr;
+    std::unordered_map<uint64_t, Subscription> subscriptions_;
+    uint64_t nextId_ = 0;
+};
+
+// Returned by JSIPureStorage.key(name). Holds the resolved index slot so
+// repeated access skips key marshalling and the index lookup. It exposes the
+// slot's version so the JS wrapper can serve an unchanged key from its own cache.
+class KeyHandleHostObject : public jsi::HostObject {
+public:
+    KeyHandleHostObject(std::shared_ptr<PureStorageEngine> engine,
+                        SlotRef slot,
+                        std::shared_ptr<facebook::react::CallInvoker> callInvoker,
+                        std::shared_ptr<TickWriteBatcher> batcher,
+                        std::weak_ptr<SubscriptionTable> subscriptions);
+
+    jsi::Value get(jsi::Runtime& runtime, const jsi::PropNameID& propName) override;
+
+private:
+    jsi::Value createFunction(jsi::Runtime& runtime, const std::string& name);
+
+    std::shared_ptr<PureStorageEngine> engine_;
+    SlotRef slot_;
+    std::shared_ptr<facebook::react::CallInvoker> callInvoker_;
+    std::shared_ptr<TickWriteBatcher> batcher_;
+    // Owned by the JSIPureStorage object, which outlives the handles it creates
+    std::weak_ptr<SubscriptionTable> subscriptions_;
+
+    // Only touched on the JS thread
+    std::unordered_map<std::string, jsi::Value> functions_;
+};
+
+} // namespace pure_storage
@@ -0,0 +1,1294 @@
+#include "LogStorageBackend.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pure_storage {
+
+namespace {
+
+// Record layout, little-endian:
+//   0  u32 CRC-32 of bytes 4..end
+//   4  u8  kind
+//   5  u8  flags
+//   6  u16 key size
+//   8  u16 type size
+//  10  u16 attributes size
+//  12  u32 value size
+//  16  i64 expiresAt
+//  24  i64 createdAt
+//  32  i64 modifiedAt
+//  40  i64 size the value reads as in JS, or -1
+//  48  key, type, attributes, value
+// With kCodedKey the key is the varint ID of its namespace followed by the
+// key past the namespace's ':'. Records written before namespace IDs have
+// the whole key.
+constexpr size_t kHeaderSize = 48;
+constexpr uint8_t kPut = 1;
+constexpr uint8_t kRemoval = 2;
+constexpr uint8_t kCodedKey = 0x1;
+constexpr size_t kMaxVarintBytes = 5;
+
+constexpr const char* kSegmentSuffix = ".seg";
+constexpr const char* kColdSegmentSuffix = ".cold.seg";
+
+// Heat stops counting here; anything this rewritten is hot whatever the threshold
+constexpr uint8_t kMaxHeat = 255;
+
+bool hasSuffix(const std::string& name, const char* suffix) {
+    size_t length = std::strlen(suffix);
+    return name.size() > length && name.compare(name.size() - length, std::string::npos, suffix) == 0;
+}
+
+// Namespace file entries, little-endian; an entry's ID is its position, from 1:
+//   0  u32 CRC-32 of bytes 4..end
+//   4  u16 name size
+//   6  name
+constexpr const char* kNamespaceFile = "/namespaces";
+constexpr size_t kNamespaceEntryHeader = 6;
+
+// statItem() reads this much past the key along with the header, which
+// covers every type JS writes and the attributes of most records
+constexpr size_t kStatTailBytes = 256;
+
+// Records closer than this go out as one willNeed() hint
+constexpr uint64_t kAdviceGap = 16 * 1024;
+
+// Mappings smaller than a huge page gain nothing from asking for them
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+int64_t steadyMilliseconds() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void pageFaults(uint64_t& minor, uint64_t& major) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        minor = static_cast<uint64_t>(usage.ru_minflt);
+        major = static_cast<uint64_t>(usage.ru_majflt);
+    }
+}
+
+uint32_t crc32(const char* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> result{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            result[i] = value;
+        }
+        return result;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void putLittleEndian(char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint64_t getLittleEndian(const char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+void putVarint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// Bytes the varint at the start of `in` takes, 0 if it's cut short or too long
+size_t getVarint(std::string_view in, uint32_t& value) {
+    value = 0;
+    for (size_t i = 0; i < in.size() && i < kMaxVarintBytes; i++) {
+        uint8_t byte = static_cast<uint8_t>(in[i]);
+        value |= static_cast<uint32_t>(byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80)) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Where a key's namespace ends, or npos if it has none
+size_t namespaceEnd(std::string_view key) {
+    size_t separator = key.find(':');
+    return separator == 0 ? std::string_view::npos : separator;
+}
+
+// `key` is the key as stored, coded or not as `flags` say
+std::string encodeRecord(uint8_t kind, uint8_t flags, const std::string& key, const StoredItem& item) {
+    std::string record(kHeaderSize, '\0');
+    record[4] = static_cast<char>(kind);
+    record[5] = static_cast<char>(flags);
+    putLittleEndian(&record[6], key.size(), 2);
+    putLittleEndian(&record[8], item.type.size(), 2);
+    putLittleEndian(&record[10], item.attributes.size(), 2);
+    putLittleEndian(&record[12], item.value.size(), 4);
+    putLittleEndian(&record[16], static_cast<uint64_t>(item.expiresAt), 8);
+    putLittleEndian(&record[24], static_cast<uint64_t>(item.createdAt), 8);
+    putLittleEndian(&record[32], static_cast<uint64_t>(item.modifiedAt), 8);
+    putLittleEndian(&record[40], static_cast<uint64_t>(item.size), 8);
+
+    record.reserve(kHeaderSize + key.size() + item.type.size() + item.attributes.size() + item.value.size());
+    record += key;
+    record += item.type;
+    record += item.attributes;
+    record += item.value;
+
+    putLittleEndian(&record[0], crc32(record.data() + 4, record.size() - 4), 4);
+    return record;
+}
+
+// The fixed fields of a record, read without checking its checksum
+struct RecordHeader {
+    uint8_t kind = 0;
+    uint8_t flags = 0;
+    size_t keySize = 0;
+    size_t typeSize = 0;
+    size_t attributesSize = 0;
+    size_t valueSize = 0;
+    int64_t expiresAt = 0;
+    int64_t createdAt = 0;
+    int64_t modifiedAt = 0;
+    int64_t size = -1;
+
+    size_t typeOffset() const { return kHeaderSize + keySize; }
+    size_t valueOffset() const { return typeOffset() + typeSize + attributesSize; }
+    size_t recordSize() const { return valueOffset() + valueSize; }
+};
+
+RecordHeader readHeader(const char* data) {
+    RecordHeader header;
+    header.kind = static_cast<uint8_t>(data[4]);
+    header.flags = static_cast<uint8_t>(data[5]);
+    header.keySize = getLittleEndian(data + 6, 2);
+    header.typeSize = getLittleEndian(data + 8, 2);
+    header.attributesSize = getLittleEndian(data + 10, 2);
+    header.valueSize = getLittleEndian(data + 12, 4);
+    header.expiresAt = static_cast<int64_t>(getLittleEndian(data + 16, 8));
+    header.createdAt = static_cast<int64_t>(getLittleEndian(data + 24, 8));
+    header.modifiedAt = static_cast<int64_t>(getLittleEndian(data + 32, 8));
+    header.size = static_cast<int64_t>(getLittleEndian(data + 40, 8));
+    return header;
+}
+
+struct DecodedRecord {
+    RecordHeader header;
+    size_t size = 0;
+    std::string_view key;
+    std::string_view type;
+    std::string_view attributes;
+    std::string_view value;
+};
+
+// False for a record that is cut short or doesn't match its checksum
+bool decodeRecord(const char* data, size_t available, DecodedRecord& record) {
+    if (available < kHeaderSize) {
+        return false;
+    }
+
+    record.header = readHeader(data);
+    record.size = record.header.recordSize();
+    if (record.size > available) {
+        return false;
+    }
+    if (getLittleEndian(data, 4) != crc32(data + 4, record.size - 4)) {
+        return false;
+    }
+
+    const RecordHeader& header = record.header;
+    record.key = std::string_view(data + kHeaderSize, header.keySize);
+    record.type = std::string_view(data + header.typeOffset(), header.typeSize);
+    record.attributes = std::string_view(data + header.typeOffset() + header.typeSize, header.attributesSize);
+    record.value = std::string_view(data + header.valueOffset(), header.valueSize);
+    return header.kind == kPut || header.kind == kRemoval;
+}
+
+// Whether a record's stored key is that of the key with this space and rest
+bool storedKeyIs(uint8_t flags, std::string_view stored, uint32_t space, std::string_view rest, const std::string& key) {
+    if (!(flags & kCodedKey)) {
+        return stored == key;
+    }
+    uint32_t id = 0;
+    size_t used = getVarint(stored, id);
+    return used > 0 && id == space && stored.substr(used) == rest;
+}
+
+void copyHeader(const RecordHeader& header, StoredItem& item) {
+    item.expiresAt = header.expiresAt;
+    item.createdAt = header.createdAt;
+    item.modifiedAt = header.modifiedAt;
+    item.size = header.size;
+}
+
+} // namespace
+
+// A value inside its own mapping of a segment, holding a pin on the segment
+class LogStorageBackend::MappedValue : public ValueBuffer {
+public:
+    MappedValue(std::shared_ptr<Segment> segment, std::shared_ptr<Mapping> mapping, uint8_t* data, size_t size)
+        : segment_(std::move(segment)), mapping_(std::move(mapping)), data_(data), size_(size) {
+        segment_->pins.fetch_add(1, std::memory_order_relaxed);
+        segment_->mappedBytes.fetch_add(mapping_->length, std::memory_order_relaxed);
+    }
+
+    ~MappedValue() override {
+        segment_->mappedBytes.fetch_sub(mapping_->length, std::memory_order_relaxed);
+        segment_->pins.fetch_sub(1, std::memory_order_release);
+    }
+
+    uint8_t* data() override { return data_; }
+    size_t size() const override { return size_; }
+
+private:
+    std::shared_ptr<Segment> segment_;
+    std::shared_ptr<Mapping> mapping_;
+    uint8_t* data_;
+    size_t size_;
+};
+
+LogStorageBackend::Mapping::~Mapping() {
+    if (address) {
+        munmap(address, length);
+    }
+}
+
+LogStorageBackend::Segment::~Segment() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+LogStorageBackend::LogStorageBackend(std::string directory, LogStorageOptions options)
+    : directory_(std::move(directory)), options_(options), io_(makeIoBackend(options.io)) {
+    pageFaults(minorFaultsAtOpen_, majorFaultsAtOpen_);
+
+    if (!io_) {
+        throw std::runtime_error("PureStorage: the requested I/O backend is not available");
+    }
+
+    if (mkdir(directory_.c_str(), 0700) != 0 && errno != EEXIST) {
+        throw std::runtime_error("PureStorage: can't create " + directory_ + ": " + std::strerror(errno));
+    }
+    directoryFd_ = open(directory_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directoryFd_ < 0) {
+        throw std::runtime_error("PureStorage: can't open " + directory_ + ": " + std::strerror(errno));
+    }
+
+    struct stat directoryInfo;
+    if (fstat(directoryFd_, &directoryInfo) == 0 && directoryInfo.st_blksize > 0) {
+        blockSize_ = static_cast<uint64_t>(directoryInfo.st_blksize);
+    }
+    preallocating_ = options_.preallocateBytes > 0;
+
+    // Records refer to namespaces by ID, so the IDs are needed to replay them
+    spaces_.emplace_back();
+    loadNamespaces();
+
+    std::vector<std::pair<uint32_t, Stream>> ids;
+    if (DIR* dir = opendir(directory_.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (hasSuffix(name, kSegmentSuffix)) {
+                Stream stream = hasSuffix(name, kColdSegmentSuffix) ? Stream::Cold : Stream::Hot;
+                ids.emplace_back(static_cast<uint32_t>(std::strtoul(name.c_str(), nullptr, 10)), stream);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(ids.begin(), ids.end());
+
+    // Later segments hold later records of a key, whichever stream they're
+    // in, so replaying in order leaves the index pointing at its latest one
+    for (const auto& entry : ids) {
+        uint32_t id = entry.first;
+        std::shared_ptr<Segment> segment = openSegment(id, entry.second, false);
+        if (!segment) {
+            throw std::runtime_error("PureStorage: can't open " + segmentPath(id, entry.second));
+        }
+        if (!replay(segment)) {
+            throw std::runtime_error("PureStorage: can't read " + segmentPath(id, entry.second));
+        }
+        segments_.push_back(std::move(segment));
+        nextSegmentId_ = id + 1;
+    }
+}
+
+LogStorageBackend::~LogStorageBackend() {
+    if (namespaceFd_ >= 0) {
+        close(namespaceFd_);
+    }
+    if (directoryFd_ >= 0) {
+        close(directoryFd_);
+    }
+}
+
+std::string LogStorageBackend::segmentPath(uint32_t id, Stream stream) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%08u%s", id, stream == Stream::Cold ? kColdSegmentSuffix : kSegmentSuffix);
+    return directory_ + name;
+}
+
+std::shared_ptr<LogStorageBackend::Segment> LogStorageBackend::openSegment(uint32_t id, Stream stream, bool create) {
+    int flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0);
+    int fd = open(segmentPath(id, stream).c_str(), flags, 0600);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    auto segment = std::make_shared<Segment>();
+    segment->id = id;
+    segment->stream = stream;
+    segment->fd = fd;
+    segment->lastRead.store(steadyMilliseconds(), std::memory_order_relaxed);
+
+    if (create) {
+        // The new file's directory entry has to be durable too
+        io_->sync(directoryFd_);
+        if (options_.adviseRandom) {
+            adviseFile(fd, 0, 0, Advice::Random);
+        }
+    }
+    return segment;
+}
+
+bool LogStorageBackend::replay(const std::shared_ptr<Segment>& segment) {
+    struct stat info;
+    if (fstat(segment->fd, &info) != 0) {
+        return false;
+    }
+
+    if (options_.adviseSequential) {
+        adviseFile(segment->fd, 0, 0, Advice::Sequential);
+    }
+    std::string data(static_cast<size_t>(info.st_size), '\0');
+    if (io_->readAt(segment->fd, &data[0], data.size(), 0) != static_cast<ssize_t>(data.size())) {
+        return false;
+    }
+    // From here on the segment only sees point reads
+    if (options_.adviseRandom) {
+        adviseFile(segment->fd, 0, 0, Advice::Random);
+    } else if (options_.adviseSequential) {
+        adviseFile(segment->fd, 0, 0, Advice::Normal);
+    }
+
+    size_t offset = 0;
+    DecodedRecord record;
+    while (decodeRecord(data.data() + offset, data.size() - offset, record)) {
+        Location location{segment, offset, static_cast<uint32_t>(record.size)};
+        std::string key = recordKey(record.header.flags, record.key);
+        offset += record.size;
+
+        // A namespace that only appears in records from before IDs gets one
+        // now, so the index can file the key under it
+        size_t end = namespaceEnd(key);
+        bool known = !key.empty() && (end == std::string::npos || namespaceId(std::string_view(key).substr(0, end)) != 0);
+        if (known) {
+            place(key, record.header.kind == kRemoval, location, false);
+        }
+    }
+
+    // Whatever follows the last good record is preallocated zeros, or a
+    // write that didn't finish. Appends start at `offset` and overwrite
+    // either, but a torn write is cut off so no stale bytes outlive them.
+    segment->size = offset;
+    segment->written = offset;
+    segment->allocated = data.size();
+    if (std::any_of(data.begin() + static_cast<ptrdiff_t>(offset), data.end(), [](char byte) { return byte != 0; })) {
+        if (ftruncate(segment->fd, static_cast<off_t>(offset)) == 0) {
+            segment->allocated = offset;
+        }
+    }
+    return true;
+}
+
+void LogStorageBackend::place(const std::string& key, bool removal, Location location, bool copied) {
+    // Appends and replay give the namespace an ID before placing its keys
+    KeyRef ref;
+    if (!refer(key, ref)) {
+        return;
+    }
+    auto& keys = spaces_[ref.space].keys;
+    auto it = keys.find(std::string(ref.rest));
+    if (it != keys.end()) {
+        it->second.segment->liveBytes -= it->second.size;
+        if (!copied) {
+            location.heat = static_cast<uint8_t>(std::min<int>(it->second.heat + 1, kMaxHeat));
+        }
+    }
+
+    if (removal) {
+        if (it != keys.end()) {
+            keys.erase(it);
+        }
+        return;
+    }
+
+    location.segment->liveBytes += location.size;
+    if (it != keys.end()) {
+        it->second = location;
+    } else {
+        keys.emplace(std::string(ref.rest), location);
+    }
+}
+
+void LogStorageBackend::loadNamespaces() {
+    std::string path = directory_ + kNamespaceFile;
+    bool created = access(path.c_str(), F_OK) != 0;
+    namespaceFd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (namespaceFd_ < 0) {
+        throw std::runtime_error("PureStorage: can't open " + path + ": " + std::strerror(errno));
+    }
+    if (created) {
+        io_->sync(directoryFd_);
+    }
+
+    struct stat info;
+    if (fstat(namespaceFd_, &info) != 0) {
+        throw std::runtime_error("PureStorage: can't read " + path);
+    }
+    std::string data(static_cast<size_t>(info.st_size), '\0');
+    if (!data.empty() && io_->readAt(namespaceFd_, &data[0], data.size(), 0) != static_cast<ssize_t>(data.size())) {
+        throw std::runtime_error("PureStorage: can't read " + path);
+    }
+
+    size_t offset = 0;
+    while (data.size() - offset >= kNamespaceEntryHeader) {
+        size_t nameSize = getLittleEndian(&data[offset + 4], 2);
+        size_t entrySize = kNamespaceEntryHeader + nameSize;
+        if (data.size() - offset < entrySize ||
+            getLittleEndian(&data[offset], 4) != crc32(&data[offset + 4], entrySize - 4)) {
+            break;
+        }
+
+        std::string name = data.substr(offset + kNamespaceEntryHeader, nameSize);
+        namespaceIds_.emplace(name, static_cast<uint32_t>(spaces_.size()));
+        spaces_.push_back(KeySpace{std::move(name), {}});
+        offset += entrySize;
+    }
+
+    // An entry that didn't finish was never used: IDs are synced before records refer to them
+    if (offset < data.size() && ftruncate(namespaceFd_, static_cast<off_t>(offset)) != 0) {
+        throw std::runtime_error("PureStorage: can't repair " + path);
+    }
+    namespaceFileSize_ = offset;
+}
+
+uint32_t LogStorageBackend::namespaceId(std::string_view name) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = namespaceIds_.find(std::string(name));
+        if (it != namespaceIds_.end()) {
+            return it->second;
+        }
+    }
+
+    std::lock_guard<std::mutex> namespaceLock(namespaceMutex_);
+    {
+        // Another writer may have assigned it while we waited
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = namespaceIds_.find(std::string(name));
+        if (it != namespaceIds_.end()) {
+            return it->second;
+        }
+    }
+    if (name.size() > std::numeric_limits<uint16_t>::max()) {
+        return 0;
+    }
+
+    std::string entry(kNamespaceEntryHeader, '\0');
+    putLittleEndian(&entry[4], name.size(), 2);
+    entry += name;
+    putLittleEndian(&entry[0], crc32(entry.data() + 4, entry.size() - 4), 4);
+
+    std::vector<IoRequest> requests(1);
+    requests[0].fd = namespaceFd_;
+    requests[0].data = &entry[0];
+    requests[0].size = entry.size();
+    requests[0].offset = namespaceFileSize_;
+    io_->write(requests, true);
+    if (requests[0].result != static_cast<ssize_t>(entry.size())) {
+        return 0;
+    }
+    namespaceFileSize_ += entry.size();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t id = static_cast<uint32_t>(spaces_.size());
+    spaces_.push_back(KeySpace{std::string(name), {}});
+    namespaceIds_.emplace(std::string(name), id);
+    return id;
+}
+
+bool LogStorageBackend::storedKey(const std::string& key, std::string& stored, uint8_t& flags) {
+    size_t end = namespaceEnd(key);
+    if (end == std::string::npos) {
+        stored = key;
+        flags = 0;
+        return true;
+    }
+
+    uint32_t id = namespaceId(std::string_view(key).substr(0, end));
+    if (id == 0) {
+        return false;
+    }
+    stored.clear();
+    putVarint(stored, id);
+    stored.append(key, end + 1, std::string::npos);
+    flags = kCodedKey;
+    return true;
+}
+
+std::string LogStorageBackend::recordKey(uint8_t flags, std::string_view stored) const {
+    if (!(flags & kCodedKey)) {
+        return std::string(stored);
+    }
+
+    uint32_t id = 0;
+    size_t used = getVarint(stored, id);
+    if (used == 0 || id == 0 || id >= spaces_.size()) {
+        return std::string();
+    }
+    std::string key = spaces_[id].name;
+    key += ':';
+    key.append(stored.substr(used));
+    return key;
+}
+
+bool LogStorageBackend::refer(const std::string& key, KeyRef& ref) const {
+    size_t end = namespaceEnd(key);
+    if (end == std::string::npos) {
+        ref.space = 0;
+        ref.rest = key;
+        return true;
+    }
+
+    auto it = namespaceIds_.find(key.substr(0, end));
+    if (it == namespaceIds_.end()) {
+        return false;
+    }
+    ref.space = it->second;
+    ref.rest = std::string_view(key).substr(end + 1);
+    return true;
+}
+
+LogStorageBackend::Location* LogStorageBackend::locate(const std::string& key, KeyRef& ref) {
+    if (!refer(key, ref)) {
+        return nullptr;
+    }
+    auto& keys = spaces_[ref.space].keys;
+    auto it = keys.find(std::string(ref.rest));
+    return it != keys.end() ? &it->second : nullptr;
+}
+
+bool LogStorageBackend::append(std::vector<Record>& records, bool sync) {
+    // appendMutex_ is held, so segment sizes and the active segments are ours
+    std::shared_ptr<Segment> hot;
+    std::shared_ptr<Segment> cold;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = segments_.rbegin(); it != segments_.rend() && (!hot || !cold); ++it) {
+            std::shared_ptr<Segment>& active = (*it)->stream == Stream::Cold ? cold : hot;
+            if (!active) {
+                active = *it;
+            }
+        }
+    }
+
+    struct Run {
+        std::shared_ptr<Segment> segment;
+        uint64_t offset;
+        std::string bytes;
+    };
+    std::vector<Run> runs;
+    std::vector<Location> locations;
+    locations.reserve(records.size());
+
+    for (auto& record : records) {
+        std::shared_ptr<Segment>& active = record.stream == Stream::Cold ? cold : hot;
+        bool full = active && active->size > 0 &&
+            active->size + record.bytes.size() > options_.segmentBytes;
+        // Replay goes by segment ID, so a key's record can't land in a segment
+        // older than its previous one: writes go to the newest segment, and a
+        // copy to one newer than the segment it came from
+        bool behind = active && (record.stream == Stream::Hot
+            ? active->id + 1 != nextSegmentId_
+            : active->id <= record.copiedFrom);
+        if (!active || full || behind) {
+            std::shared_ptr<Segment> next = openSegment(nextSegmentId_, record.stream, true);
+            if (!next) {
+                return false;
+            }
+            nextSegmentId_++;
+
+            // Give back the sealed segment's unused preallocation
+            if (active && active->allocated > active->size &&
+                ftruncate(active->fd, static_cast<off_t>(active->size)) == 0) {
+                active->allocated = active->size;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            segments_.push_back(next);
+            active = std::move(next);
+        }
+
+        if (runs.empty() || runs.back().segment != active) {
+            runs.push_back(Run{active, active->size, std::string()});
+        }
+        locations.push_back(Location{active, active->size, static_cast<uint32_t>(record.bytes.size()), record.heat});
+        runs.back().bytes += record.bytes;
+        active->size += record.bytes.size();
+    }
+
+    for (const auto& run : runs) {
+        preallocate(*run.segment, run.offset + run.bytes.size());
+    }
+
+    // One write per segment the records landed in
+    std::vector<IoRequest> requests(runs.size());
+    for (size_t i = 0; i < runs.size(); i++) {
+        requests[i].fd = runs[i].segment->fd;
+        requests[i].data = &runs[i].bytes[0];
+        requests[i].size = runs[i].bytes.size();
+        requests[i].offset = runs[i].offset;
+    }
+    io_->write(requests, sync);
+
+    bool written = true;
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requests[i].result != static_cast<ssize_t>(runs[i].bytes.size())) {
+            written = false;
+        }
+    }
+    if (!written) {
+        // The next append overwrites whatever did get written
+        for (const auto& run : runs) {
+            run.segment->size = std::min(run.segment->size, run.offset);
+        }
+        return false;
+    }
+
+    for (const auto& record : records) {
+        std::atomic<uint64_t>& written = record.copiedFrom ? compactedBytes_ : appendedBytes_;
+        written.fetch_add(record.bytes.size(), std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < records.size(); i++) {
+        place(records[i].key, records[i].removal, locations[i], records[i].copiedFrom != 0);
+    }
+    for (const auto& run : runs) {
+        run.segment->written = std::max(run.segment->written, run.offset + run.bytes.size());
+    }
+    return true;
+}
+
+void LogStorageBackend::preallocate(Segment& segment, uint64_t end) {
+    if (!preallocating_ || end <= segment.allocated) {
+        return;
+    }
+
+    // Whole blocks, and never past the segment limit unless a record needs it
+    uint64_t extent = (options_.preallocateBytes + blockSize_ - 1) / blockSize_ * blockSize_;
+    uint64_t target = (end + extent - 1) / extent * extent;
+    uint64_t limit = (options_.segmentBytes + blockSize_ - 1) / blockSize_ * blockSize_;
+    target = std::max(end, std::min(target, limit));
+
+#if defined(__linux__)
+    // Mode 0 extends the size too; the blocks read as zeros, which replay
+    // takes for the end of the records
+    int result = fallocate(segment.fd, 0, static_cast<off_t>(segment.allocated),
+        static_cast<off_t>(target - segment.allocated));
+#else
+    // No fallocate(): a sparse extension still keeps the size fixed across syncs
+    int result = ftruncate(segment.fd, static_cast<off_t>(target));
+#endif
+    if (result != 0) {
+        // EOPNOTSUPP and friends: the writes below grow the file instead
+        preallocating_ = false;
+        return;
+    }
+    segment.allocated = target;
+}
+
+bool LogStorageBackend::enqueueOrAppend(Record record, bool sync) {
+    std::lock_guard<std::mutex> appendLock(appendMutex_);
+
+    auto batch = batches_.find(std::this_thread::get_id());
+    if (batch != batches_.end()) {
+        batch->second.push_back(std::move(record));
+        return true;
+    }
+
+    if (record.removal) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        KeyRef ref;
+        if (!locate(record.key, ref)) {
+            return true;
+        }
+    }
+
+    std::vector<Record> records;
+    records.push_back(std::move(record));
+    return append(records, sync);
+}
+
+bool LogStorageBackend::setItem(const std::string& key, const StoredItem& item, const WriteOptions& options) {
+    if (options.encrypted || key.empty()) {
+        return false;
+    }
+    std::string stored;
+    uint8_t flags = 0;
+    if (!storedKey(key, stored, flags)) {
+        return false;
+    }
+    uint64_t size = kHeaderSize + stored.size() + item.type.size() + item.attributes.size() +
+        static_cast<uint64_t>(item.value.size());
+    if (stored.size() > std::numeric_limits<uint16_t>::max() ||
+        item.type.size() > std::numeric_limits<uint16_t>::max() ||
+        item.attributes.size() > std::numeric_limits<uint16_t>::max() ||
+        size > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    return enqueueOrAppend(Record{key, false, encodeRecord(kPut, flags, stored, item)},
+        options.durability == Durability::Sync);
+}
+
+bool LogStorageBackend::getItem(const std::string& key, StoredItem& item) {
+    Location location;
+    KeyRef ref;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Location* found = locate(key, ref);
+        if (!found) {
+            return false;
+        }
+        location = *found;
+    }
+
+    // The location holds a reference to the segment, so clear() can't close it under us
+    location.segment->lastRead.store(steadyMilliseconds(), std::memory_order_relaxed);
+    std::string data(location.size, '\0');
+    if (io_->readAt(location.segment->fd, &data[0], data.size(), location.offset) != static_cast<ssize_t>(data.size())) {
+        return false;
+    }
+
+    DecodedRecord record;
+    if (!decodeRecord(data.data(), data.size(), record) || record.header.kind != kPut ||
+        !storedKeyIs(record.header.flags, record.key, ref.space, ref.rest, key)) {
+        return false;
+    }
+
+    item.type.assign(record.type);
+    item.value.assign(record.value);
+    item.attributes.assign(record.attributes);
+    copyHeader(record.header, item);
+    return true;
+}
+
+bool LogStorageBackend::statItem(const std::string& key, ItemStat& stat) {
+    Location location;
+    KeyRef ref;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Location* found = locate(key, ref);
+        if (!found) {
+            return false;
+        }
+        location = *found;
+    }
+
+    // The header, key, type and attributes lead the record; the value is never
+    // read. A coded key is never more than a varint longer than the whole key.
+    location.segment->lastRead.store(steadyMilliseconds(), std::memory_order_relaxed);
+    size_t length = std::min<size_t>(location.size, kHeaderSize + key.size() + kMaxVarintBytes + kStatTailBytes);
+    std::string data(length, '\0');
+    if (io_->readAt(location.segment->fd, &data[0], length, location.offset) != static_cast<ssize_t>(length)) {
+        return false;
+    }
+
+    RecordHeader header = readHeader(data.data());
+    if (header.kind != kPut || header.recordSize() != location.size || header.keySize > length - kHeaderSize ||
+        !storedKeyIs(header.flags, std::string_view(data.data() + kHeaderSize, header.keySize), ref.space, ref.rest, key)) {
+        return false;
+    }
+
+    // A long type or attributes take a second read
+    size_t tailSize = header.typeSize + header.attributesSize;
+    if (header.typeOffset() + tailSize > length) {
+        data.resize(header.typeOffset() + tailSize);
+        if (io_->readAt(location.segment->fd, &data[header.typeOffset()], tailSize, location.offset + header.typeOffset()) !=
+            static_cast<ssize_t>(tailSize)) {
+            return false;
+        }
+    }
+
+    stat.type.assign(data, header.typeOffset(), header.typeSize);
+    stat.attributes.assign(data, header.typeOffset() + header.typeSize, header.attributesSize);
+    stat.size = header.size;
+    stat.createdAt = header.createdAt;
+    stat.modifiedAt = header.modifiedAt;
+    stat.expiresAt = header.expiresAt;
+    return true;
+}
+
+std::shared_ptr<ValueBuffer> LogStorageBackend::mapItem(const std::string& key, StoredItem& item) {
+    Location location;
+    uint64_t written;
+    KeyRef ref;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Location* found = locate(key, ref);
+        if (!found) {
+            return nullptr;
+        }
+        location = *found;
+        written = location.segment->written;
+    }
+
+    location.segment->lastRead.store(steadyMilliseconds(), std::memory_order_relaxed);
+    uint64_t end = location.offset + location.size;
+    // Never past the file's end: touching that would raise SIGBUS
+    struct stat info;
+    uint64_t available = std::min<uint64_t>(written, fstat(location.segment->fd, &info) == 0 ? info.st_size : 0);
+    if (available < end) {
+        return nullptr;
+    }
+
+    // Each buffer gets its own private, writable window over the record's
+    // pages, so JS can write to the ArrayBuffer without reaching the file or
+    // any other read of the key. Pages it doesn't write stay shared with the
+    // page cache.
+    static const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t start = location.offset / pageSize * pageSize;
+    size_t length = static_cast<size_t>(end - start);
+    void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, location.segment->fd, static_cast<off_t>(start));
+    if (address == MAP_FAILED) {
+        return nullptr;
+    }
+    auto mapping = std::make_shared<Mapping>();
+    mapping->address = static_cast<uint8_t*>(address);
+    mapping->length = length;
+
+    if (options_.adviseRandom) {
+        adviseMapping(mapping->address, length, Advice::Random);
+    }
+    if (options_.adviseHugePages && length >= kHugePageSize) {
+        adviseMapping(mapping->address, length, Advice::HugePage);
+    }
+
+    // Checksums were verified when the log was opened or the record written;
+    // checking again would read the whole value, which is what this avoids
+    const char* record = reinterpret_cast<const char*>(mapping->address + (location.offset - start));
+    RecordHeader header = readHeader(record);
+    if (header.kind != kPut || header.recordSize() != location.size ||
+        !storedKeyIs(header.flags, std::string_view(record + kHeaderSize, header.keySize), ref.space, ref.rest, key)) {
+        return nullptr;
+    }
+
+    item.type.assign(record + header.typeOffset(), header.typeSize);
+    item.attributes.assign(record + header.typeOffset() + header.typeSize, header.attributesSize);
+    item.value.clear();
+    copyHeader(header, item);
+
+    uint8_t* value = mapping->address + (location.offset - start) + header.valueOffset();
+    return std::make_shared<MappedValue>(location.segment, std::move(mapping), value, header.valueSize);
+}
+
+size_t LogStorageBackend::compact(double minLiveRatio, double coldMinLiveRatio) {
+    std::lock_guard<std::mutex> appendLock(appendMutex_);
+
+    // A pinned segment's pages stay in use until its buffers are collected,
+    // so rewriting it now would only add to the space it holds. The newest
+    // segment of each stream is still being appended to.
+    std::vector<std::shared_ptr<Segment>> candidates;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool activeCold = true;
+        for (size_t i = segments_.size(); i-- > 0;) {
+            Segment& segment = *segments_[i];
+            bool coldStream = segment.stream == Stream::Cold;
+            if (i + 1 == segments_.size() || (coldStream && activeCold)) {
+                activeCold = activeCold && !coldStream;
+                continue;
+            }
+            double ratio = coldStream ? coldMinLiveRatio : minLiveRatio;
+            if (segment.pins.load(std::memory_order_acquire) == 0 && segment.liveBytes < segment.size * ratio) {
+                candidates.push_back(segments_[i]);
+            }
+        }
+        std::reverse(candidates.begin(), candidates.end());
+    }
+
+    size_t compacted = 0;
+    for (const auto& segment : candidates) {
+        if (options_.adviseSequential) {
+            adviseFile(segment->fd, 0, 0, Advice::Sequential);
+        }
+        std::string data(segment->size, '\0');
+        if (io_->readAt(segment->fd, &data[0], data.size(), 0) != static_cast<ssize_t>(data.size())) {
+            break;
+        }
+
+        std::vector<Record> records;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // Removals only matter while an older segment may still hold the key
+            bool older = segments_.front() != segment;
+
+            DecodedRecord record;
+            for (size_t offset = 0; decodeRecord(data.data() + offset, data.size() - offset, record); offset += record.size) {
+                // Records are copied as written, coded or not: namespace IDs never change
+                std::string key = recordKey(record.header.flags, record.key);
+                KeyRef ref;
+                Location* location = key.empty() ? nullptr : locate(key, ref);
+                bool live = record.header.kind == kPut && location &&
+                    location->segment == segment && location->offset == offset;
+                bool keepRemoval = record.header.kind == kRemoval && older && !key.empty() && !location;
+                if (!live && !keepRemoval) {
+                    continue;
+                }
+
+                // A removal kept this long guards records nobody rewrites
+                Record copy{std::move(key), keepRemoval, data.substr(offset, record.size)};
+                copy.copiedFrom = segment->id;
+                bool hot = options_.hotUpdates == 0 || (live && location->heat >= options_.hotUpdates);
+                if (hot) {
+                    copy.heat = live ? location->heat / 2 : 0;
+                } else {
+                    copy.stream = Stream::Cold;
+                }
+                records.push_back(std::move(copy));
+            }
+        }
+
+        // Cold records first: a cold segment opened for them would leave the
+        // hot one behind, and hot records then need a newer one
+        std::stable_partition(records.begin(), records.end(), [](const Record& record) {
+            return record.stream == Stream::Cold;
+        });
+
+        if (!records.empty() && !append(records, true)) {
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            segments_.erase(std::find(segments_.begin(), segments_.end(), segment));
+        }
+        // Readers still holding the segment keep its descriptor, and the
+        // mappings of its buffers stay valid after the unlink. Its pages would
+        // stay cached until then; nothing should need them again.
+        if (options_.adviseDontNeed) {
+            adviseFile(segment->fd, 0, 0, Advice::DontNeed);
+        }
+        unlink(segmentPath(segment->id, segment->stream).c_str());
+        compacted++;
+    }
+
+    if (compacted > 0) {
+        io_->sync(directoryFd_);
+    }
+    return compacted;
+}
+
+void LogStorageBackend::willNeed(const std::vector<std::string>& keys) {
+    if (!options_.adviseWillNeed) {
+        return;
+    }
+
+    struct Range {
+        std::shared_ptr<Segment> segment;
+        uint64_t offset;
+        uint64_t end;
+    };
+    std::vector<Range> ranges;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& key : keys) {
+            KeyRef ref;
+            if (const Location* location = locate(key, ref)) {
+                ranges.push_back(Range{location->segment, location->offset, location->offset + location->size});
+            }
+        }
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) {
+        return a.segment != b.segment ? a.segment->id < b.segment->id : a.offset < b.offset;
+    });
+
+    // For a file mapping, madvise(MADV_WILLNEED) reads ahead through the page
+    // cache just like this, so the file hint covers mapped reads too
+    for (size_t i = 0; i < ranges.size();) {
+        const Range& first = ranges[i];
+        uint64_t end = first.end;
+        for (i++; i < ranges.size() && ranges[i].segment == first.segment && ranges[i].offset <= end + kAdviceGap; i++) {
+            end = std::max(end, ranges[i].end);
+        }
+        adviseFile(first.segment->fd, first.offset, end - first.offset, Advice::WillNeed);
+    }
+}
+
+size_t LogStorageBackend::releaseColdSegments(std::chrono::milliseconds idle) {
+    int64_t cutoff = steadyMilliseconds() - idle.count();
+
+    std::vector<std::shared_ptr<Segment>> cold;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // The active segment is where the next reads of fresh writes land
+        for (size_t i = 0; i + 1 < segments_.size(); i++) {
+            Segment& segment = *segments_[i];
+            if (segment.pins.load(std::memory_order_acquire) == 0 &&
+                segment.lastRead.load(std::memory_order_relaxed) <= cutoff) {
+                cold.push_back(segments_[i]);
+            }
+        }
+    }
+
+    if (options_.adviseDontNeed) {
+        for (const auto& segment : cold) {
+            adviseFile(segment->fd, 0, 0, Advice::DontNeed);
+        }
+    }
+    return cold.size();
+}
+
+LogStorageStats LogStorageBackend::stats() {
+    LogStorageStats stats;
+    {
+        // Segment sizes change under appendMutex_
+        std::lock_guard<std::mutex> appendLock(appendMutex_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.segments = segments_.size();
+        stats.namespaces = spaces_.size() - 1;
+        for (const auto& segment : segments_) {
+            stats.bytes += segment->size;
+            stats.liveBytes += segment->liveBytes;
+            stats.allocatedBytes += std::max(segment->allocated, segment->size);
+            stats.pinnedSegments += segment->pins.load(std::memory_order_relaxed) > 0 ? 1 : 0;
+            stats.mappedBytes += segment->mappedBytes.load(std::memory_order_relaxed);
+            if (segment->stream == Stream::Cold) {
+                stats.coldSegments++;
+                stats.coldBytes += segment->size;
+            }
+        }
+    }
+    stats.appendedBytes = appendedBytes_.load(std::memory_order_relaxed);
+    stats.compactedBytes = compactedBytes_.load(std::memory_order_relaxed);
+
+    stats.randomAdvice = randomAdvice_.load(std::memory_order_relaxed);
+    stats.sequentialAdvice = sequentialAdvice_.load(std::memory_order_relaxed);
+    stats.willNeedAdvice = willNeedAdvice_.load(std::memory_order_relaxed);
+    stats.dontNeedAdvice = dontNeedAdvice_.load(std::memory_order_relaxed);
+    stats.hugePageAdvice = hugePageAdvice_.load(std::memory_order_relaxed);
+    stats.failedAdvice = failedAdvice_.load(std::memory_order_relaxed);
+
+    uint64_t minor = minorFaultsAtOpen_;
+    uint64_t major = majorFaultsAtOpen_;
+    pageFaults(minor, major);
+    stats.minorFaults = minor - minorFaultsAtOpen_;
+    stats.majorFaults = major - majorFaultsAtOpen_;
+    return stats;
+}
+
+std::atomic<uint64_t>* LogStorageBackend::adviceCounter(Advice advice) {
+    switch (advice) {
+        case Advice::Random: return &randomAdvice_;
+        case Advice::Sequential: return &sequentialAdvice_;
+        case Advice::WillNeed: return &willNeedAdvice_;
+        case Advice::DontNeed: return &dontNeedAdvice_;
+        case Advice::HugePage: return &hugePageAdvice_;
+        default: return nullptr;
+    }
+}
+
+void LogStorageBackend::adviseFile(int fd, uint64_t offset, uint64_t length, Advice advice) {
+    int result;
+#if defined(POSIX_FADV_NORMAL)
+    int flag;
+    switch (advice) {
+        case Advice::Normal: flag = POSIX_FADV_NORMAL; break;
+        case Advice::Random: flag = POSIX_FADV_RANDOM; break;
+        case Advice::Sequential: flag = POSIX_FADV_SEQUENTIAL; break;
+        case Advice::WillNeed: flag = POSIX_FADV_WILLNEED; break;
+        case Advice::DontNeed: flag = POSIX_FADV_DONTNEED; break;
+        default: return;
+    }
+    result = posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), flag);
+#elif defined(__APPLE__)
+    // No posix_fadvise: readahead is a per-descriptor switch, and there's no
+    // way to drop cached pages short of F_NOCACHE, which would stop caching
+    switch (advice) {
+        case Advice::Normal:
+        case Advice::Sequential:
+            result = fcntl(fd, F_RDAHEAD, 1);
+            break;
+        case Advice::Random:
+            result = fcntl(fd, F_RDAHEAD, 0);
+            break;
+        case Advice::WillNeed: {
+            struct radvisory hint;
+            hint.ra_offset = static_cast<off_t>(offset);
+            hint.ra_count = static_cast<int>(std::min<uint64_t>(length, std::numeric_limits<int>::max()));
+            result = fcntl(fd, F_RDADVISE, &hint);
+            break;
+        }
+        default:
+            return;
+    }
+#else
+    return;
+#endif
+
+    if (std::atomic<uint64_t>* counter = adviceCounter(advice)) {
+        counter->fetch_add(1, std::memory_order_relaxed);
+    }
+    if (result != 0) {
+        failedAdvice_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void LogStorageBackend::adviseMapping(uint8_t* address, size_t length, Advice advice) {
+    int flag;
+    switch (advice) {
+        case Advice::Random: flag = MADV_RANDOM; break;
+#ifdef MADV_HUGEPAGE
+        case Advice::HugePage: flag = MADV_HUGEPAGE; break;
+#endif
+        // Dropping pages of a private mapping would throw away JS's writes
+        default: return;
+    }
+
+    adviceCounter(advice)->fetch_add(1, std::memory_order_relaxed);
+    if (madvise(address, length, flag) != 0) {
+        failedAdvice_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool LogStorageBackend::removeItem(const std::string& key) {
+    std::string stored;
+    uint8_t flags = 0;
+    if (!storedKey(key, stored, flags)) {
+        return false;
+    }
+    // A batched write of the key isn't in the index yet, so it needs the removal queued after it
+    return enqueueOrAppend(Record{key, true, encodeRecord(kRemoval, flags, stored, StoredItem())}, false);
+}
+
+bool LogStorageBackend::clear() {
+    std::lock_guard<std::mutex> appendLock(appendMutex_);
+    for (auto& batch : batches_) {
+        batch.second.clear();
+    }
+
+    std::vector<std::shared_ptr<Segment>> segments;
+    {
+        // Namespace IDs outlive the records; the next writes reuse them
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& space : spaces_) {
+            space.keys.clear();
+        }
+        segments.swap(segments_);
+    }
+
+    bool removed = true;
+    for (const auto& segment : segments) {
+        removed = unlink(segmentPath(segment->id, segment->stream).c_str()) == 0 && removed;
+    }
+    return io_->sync(directoryFd_) == 0 && removed;
+}
+
+std::vector<std::string> LogStorageBackend::getAllKeys() {
+    return keysWithPrefix(std::string());
+}
+
+std::vector<std::string> LogStorageBackend::keysWithPrefix(const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> keys;
+
+    auto collect = [&keys](const KeySpace& space, std::string_view restPrefix) {
+        for (const auto& entry : space.keys) {
+            if (entry.first.compare(0, restPrefix.size(), restPrefix) != 0) {
+                continue;
+            }
+            if (space.name.empty()) {
+                keys.push_back(entry.first);
+            } else {
+                keys.push_back(space.name + ":" + entry.first);
+            }
+        }
+    };
+
+    // A prefix that reaches into a namespace only needs that namespace's keys
+    size_t end = namespaceEnd(prefix);
+    if (end != std::string::npos) {
+        auto it = namespaceIds_.find(prefix.substr(0, end));
+        if (it != namespaceIds_.end()) {
+            collect(spaces_[it->second], std::string_view(prefix).substr(end + 1));
+        }
+        return keys;
+    }
+
+    // Otherwise every namespace whose name starts with the prefix, whole, and
+    // the keys without one (including those starting with ':') that match
+    for (size_t i = 1; i < spaces_.size(); i++) {
+        if (spaces_[i].name.compare(0, prefix.size(), prefix) == 0) {
+            collect(spaces_[i], std::string_view());
+        }
+    }
+    collect(spaces_[0], prefix);
+    return keys;
+}
+
+bool LogStorageBackend::hasKey(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    KeyRef ref;
+    return locate(key, ref) != nullptr;
+}
+
+void LogStorageBackend::beginBatch() {
+    std::lock_guard<std::mutex> appendLock(appendMutex_);
+    batches_[std::this_thread::get_id()];
+}
+
+bool LogStorageBackend::commitBatch() {
+    std::lock_guard<std::mutex> appendLock(appendMutex_);
+    auto batch = batches_.find(std::this_thread::get_id());
+    if (batch == batches_.end()) {
+        return true;
+    }
+
+    std::vector<Record> records = std::move(batch->second);
+    batches_.erase(batch);
+    return records.empty() || append(records, true);
+}
+
+} // namespace pure_storage
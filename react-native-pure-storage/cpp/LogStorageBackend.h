@@ -0,0 +1,280 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "IoBackend.h"
+#include "StorageBackend.h"
+
+namespace pure_storage {
+
+struct LogStorageOptions {
+    IoBackendKind io = IoBackendKind::Auto;
+    // The active segment is closed for appends once it reaches this size
+    uint64_t segmentBytes = 4 * 1024 * 1024;
+    // Segment files are extended ahead of appends in extents of this size,
+    // rounded to the filesystem block, so a synced append rarely changes the
+    // file size and fdatasync() has no inode to flush. 0 grows them per write.
+    uint64_t preallocateBytes = 1024 * 1024;
+    // Compaction sorts the records it keeps by how often their keys get
+    // rewritten. Keys overwritten at least this many times go back to the
+    // hot segments that take new writes; the rest move to cold segments,
+    // which compact() rewrites less eagerly. 0 keeps a single stream.
+    uint32_t hotUpdates = 2;
+
+    // Page cache hints, each of which can be turned off to compare fault
+    // counts in stats() with and without it.
+    // Point reads: no readahead on segment files and their mappings
+    bool adviseRandom = true;
+    // Replay and compaction read whole segments front to back
+    bool adviseSequential = true;
+    // willNeed() starts reading the records it's given
+    bool adviseWillNeed = true;
+    // Compacted segments and those idle past releaseColdSegments() leave the page cache
+    bool adviseDontNeed = true;
+    // Transparent huge pages for segment mappings, where the kernel has them for files
+    bool adviseHugePages = false;
+};
+
+struct LogStorageStats {
+    size_t segments = 0;
+    uint64_t bytes = 0;
+    uint64_t liveBytes = 0;
+    // Record bytes plus the preallocated space after them
+    uint64_t allocatedBytes = 0;
+    size_t pinnedSegments = 0;
+    uint64_t mappedBytes = 0;
+    // Namespaces with an ID in the namespace file
+    size_t namespaces = 0;
+    // Segments holding records compaction found cold, and their bytes
+    size_t coldSegments = 0;
+    uint64_t coldBytes = 0;
+    // Record bytes written since the log was opened, for writes and by
+    // compaction; their ratio is the log's write amplification
+    uint64_t appendedBytes = 0;
+    uint64_t compactedBytes = 0;
+
+    // Hints given, by kind, and those the kernel refused
+    uint64_t randomAdvice = 0;
+    uint64_t sequentialAdvice = 0;
+    uint64_t willNeedAdvice = 0;
+    uint64_t dontNeedAdvice = 0;
+    uint64_t hugePageAdvice = 0;
+    uint64_t failedAdvice = 0;
+
+    // Page faults taken by the whole process since the log was opened
+    uint64_t minorFaults = 0;
+    uint64_t majorFaults = 0;
+};
+
+// Storage backend on append-only segment files in a directory, for builds
+// without a platform module (Linux hosts, benchmarks). Every write appends a
+// record; an in-memory index maps each key to its latest record and is
+// rebuilt from the segments when the log is opened.
+//
+// Compaction separates keys by update frequency. Live records of keys that
+// keep being rewritten go back among the new writes, where they'll soon be
+// dead anyway; those that were written once and left alone go to cold
+// segments, so later compactions of the hot ones don't copy them again.
+//
+// A key's namespace (the part before its first ':') is stored as a varint
+// ID, so records and the index carry only the rest of the key. IDs are
+// assigned in the order namespaces first appear, in a small file of their
+// own that is synced before any record uses a new one.
+//
+// Values are stored as given: there is no cipher here, so encrypted writes
+// fail instead of landing in plaintext, and compression is left to callers.
+class LogStorageBackend : public StorageBackend {
+public:
+    // Opens or creates the log, replaying its segments. Throws std::runtime_error
+    // if the directory can't be used.
+    explicit LogStorageBackend(std::string directory, LogStorageOptions options = LogStorageOptions());
+    ~LogStorageBackend() override;
+
+    LogStorageBackend(const LogStorageBackend&) = delete;
+    LogStorageBackend& operator=(const LogStorageBackend&) = delete;
+
+    bool setItem(const std::string& key, const StoredItem& item, const WriteOptions& options) override;
+    bool getItem(const std::string& key, StoredItem& item) override;
+    bool removeItem(const std::string& key) override;
+    bool clear() override;
+    std::vector<std::string> getAllKeys() override;
+    bool hasKey(const std::string& key) override;
+    // Within one namespace, only that namespace's keys are looked at
+    std::vector<std::string> keysWithPrefix(const std::string& prefix) override;
+
+    // Nothing is encrypted, so there are no data keys to destroy
+    bool shredNamespace(const std::string& /*name*/) override { return true; }
+    std::string getKeyHashSecret(const std::string& /*name*/) override { return std::string(); }
+
+    // Reads the record's header, key, type and attributes, leaving the value on disk
+    bool statItem(const std::string& key, ItemStat& stat) override;
+
+    // Serves the value from a private, copy-on-write mapping of the record's
+    // pages, one per call, so writes to one buffer are never seen by another.
+    // The buffer pins the segment: compaction leaves it alone while pinned.
+    std::shared_ptr<ValueBuffer> mapItem(const std::string& key, StoredItem& item) override;
+
+    // Rewrite the live records of hot segments less than `minLiveRatio` live,
+    // and of cold ones less than `coldMinLiveRatio` live, into the active
+    // segments and delete them. Returns the number of segments deleted.
+    size_t compact(double minLiveRatio = 0.5, double coldMinLiveRatio = 0.25);
+
+    // Starts reading the keys' records into the page cache
+    void willNeed(const std::vector<std::string>& keys) override;
+
+    // Drops the cached pages of closed segments that no buffer pins and
+    // nothing has read for `idle`. Returns the number released.
+    size_t releaseColdSegments(std::chrono::milliseconds idle);
+
+    LogStorageStats stats();
+
+    // Batched records are appended with one write per segment and made
+    // durable with one data sync per file. Each thread has its own batch.
+    void beginBatch() override;
+    bool commitBatch() override;
+
+    const char* ioBackendName() const { return io_->name(); }
+
+private:
+    struct Mapping {
+        uint8_t* address = nullptr;
+        size_t length = 0;
+
+        ~Mapping();
+    };
+
+    // New writes always go to the hot stream; only compaction writes cold records
+    enum class Stream { Hot, Cold };
+
+    struct Segment {
+        uint32_t id = 0;
+        Stream stream = Stream::Hot;
+        int fd = -1;
+        uint64_t size = 0;
+        // File size, past `size` by the preallocated zeros. Guarded by appendMutex_.
+        uint64_t allocated = 0;
+        // End of the records placed in the index; mappings stop there, since
+        // a page mapped over the preallocated zeros may be a private copy
+        // by the time a record lands in it. Guarded by mutex_.
+        uint64_t written = 0;
+        // Bytes of records the index still points to
+        uint64_t liveBytes = 0;
+        // Buffers handed out by mapItem() that are still alive, and the
+        // length of their mappings
+        std::atomic<int> pins{0};
+        std::atomic<uint64_t> mappedBytes{0};
+        // Steady clock milliseconds of the last read
+        std::atomic<int64_t> lastRead{0};
+
+        ~Segment();
+    };
+
+    class MappedValue;
+
+    struct Location {
+        std::shared_ptr<Segment> segment;
+        uint64_t offset = 0;
+        uint32_t size = 0;
+        // Times the key was overwritten, halved whenever compaction copies its
+        // record. Not stored: replay counts the older records still in the log.
+        uint8_t heat = 0;
+    };
+
+    struct Record {
+        std::string key;
+        bool removal = false;
+        std::string bytes;
+        // Set by compaction; writes are hot and copied from nowhere
+        Stream stream = Stream::Hot;
+        uint32_t copiedFrom = 0;
+        uint8_t heat = 0;
+    };
+
+    // The index of one namespace, keyed by the rest of the key. Space 0
+    // holds the keys without a namespace, whole; the others are indexed by
+    // namespace ID.
+    struct KeySpace {
+        std::string name;
+        std::unordered_map<std::string, Location> keys;
+    };
+
+    // A key's space and the part of it that space is keyed by
+    struct KeyRef {
+        uint32_t space = 0;
+        std::string_view rest;
+    };
+
+    std::string segmentPath(uint32_t id, Stream stream) const;
+    std::shared_ptr<Segment> openSegment(uint32_t id, Stream stream, bool create);
+    bool replay(const std::shared_ptr<Segment>& segment);
+    // A copied record keeps the heat in `location`; a write adds to the key's
+    void place(const std::string& key, bool removal, Location location, bool copied);
+
+    void loadNamespaces();
+    // The namespace's ID, assigned and made durable if it's new; 0 if that failed
+    uint32_t namespaceId(std::string_view name);
+    // The key as records store it, with `flags` for the record header
+    bool storedKey(const std::string& key, std::string& stored, uint8_t& flags);
+    // The key a record was written for; empty if its namespace is unknown. mutex_ held.
+    std::string recordKey(uint8_t flags, std::string_view stored) const;
+    // False if the key's namespace has no ID. mutex_ held.
+    bool refer(const std::string& key, KeyRef& ref) const;
+    // Null if the key has no record. mutex_ held.
+    Location* locate(const std::string& key, KeyRef& ref);
+    bool append(std::vector<Record>& records, bool sync);
+    void preallocate(Segment& segment, uint64_t end);
+    bool enqueueOrAppend(Record record, bool sync);
+
+    enum class Advice { Normal, Random, Sequential, WillNeed, DontNeed, HugePage };
+    void adviseFile(int fd, uint64_t offset, uint64_t length, Advice advice);
+    void adviseMapping(uint8_t* address, size_t length, Advice advice);
+    // Null for Normal, which only undoes an earlier hint and isn't counted
+    std::atomic<uint64_t>* adviceCounter(Advice advice);
+
+    std::string directory_;
+    LogStorageOptions options_;
+    std::unique_ptr<IoBackend> io_;
+    int directoryFd_ = -1;
+    uint64_t blockSize_ = 4096;
+    // Cleared when the filesystem can't preallocate
+    bool preallocating_ = false;
+
+    // Serializes appends, so offsets are handed out in write order
+    std::mutex appendMutex_;
+    // Records held back by each thread between beginBatch() and commitBatch()
+    std::unordered_map<std::thread::id, std::vector<Record>> batches_;
+    uint32_t nextSegmentId_ = 1;
+
+    // Serializes namespace ID assignment, which writes the namespace file
+    std::mutex namespaceMutex_;
+    int namespaceFd_ = -1;
+    uint64_t namespaceFileSize_ = 0;
+
+    // Guards the index, the namespace IDs and the segment list; never held during I/O
+    std::mutex mutex_;
+    std::vector<KeySpace> spaces_;
+    std::unordered_map<std::string, uint32_t> namespaceIds_;
+    std::vector<std::shared_ptr<Segment>> segments_;
+
+    std::atomic<uint64_t> randomAdvice_{0};
+    std::atomic<uint64_t> sequentialAdvice_{0};
+    std::atomic<uint64_t> willNeedAdvice_{0};
+    std::atomic<uint64_t> dontNeedAdvice_{0};
+    std::atomic<uint64_t> hugePageAdvice_{0};
+    std::atomic<uint64_t> failedAdvice_{0};
+    std::atomic<uint64_t> appendedBytes_{0};
+    std::atomic<uint64_t> compactedBytes_{0};
+    uint64_t minorFaultsAtOpen_ = 0;
+    uint64_t majorFaultsAtOpen_ = 0;
+};
+
+} // namespace pure_storage
@@ -0,0 +1,125 @@
+#include "PackedColumns.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace pure_storage {
+
+namespace {
+
+int base64Digit(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+') {
+        return 62;
+    }
+    if (c == '/') {
+        return 63;
+    }
+    return -1;
+}
+
+// Number(text) in JS, for the strings serializeValue() writes for numbers
+double parseNumber(std::string_view text) {
+    if (text.empty()) {
+        return 0;
+    }
+
+    // strtod needs a terminated string; numbers are short
+    std::string terminated(text);
+    char* end = nullptr;
+    double number = std::strtod(terminated.c_str(), &end);
+    return end == terminated.c_str() + terminated.size() ? number : std::nan("");
+}
+
+void appendLittleEndian(std::vector<uint8_t>& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+} // namespace
+
+bool decodeBase64(std::string_view text, std::vector<uint8_t>& out) {
+    while (!text.empty() && text.back() == '=') {
+        text.remove_suffix(1);
+    }
+    if (text.size() % 4 == 1) {
+        return false;
+    }
+
+    size_t start = out.size();
+    out.reserve(start + text.size() / 4 * 3 + 2);
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : text) {
+        int digit = base64Digit(c);
+        if (digit < 0) {
+            out.resize(start);
+            return false;
+        }
+        bits = (bits << 6) | static_cast<uint32_t>(digit);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out.push_back(static_cast<uint8_t>(bits >> count));
+        }
+    }
+    return true;
+}
+
+std::vector<uint8_t> packValues(const std::vector<const ItemView*>& items) {
+    size_t dataOffset = packedDataOffset(items.size());
+
+    size_t estimate = dataOffset;
+    for (const ItemView* item : items) {
+        estimate += item ? item->value.size() + 8 : 0;
+    }
+
+    // The table is filled in once the data is laid out
+    std::vector<uint8_t> buffer(dataOffset, 0);
+    buffer.reserve(estimate);
+
+    auto setRange = [&buffer, dataOffset](size_t index, size_t start) {
+        size_t range[2] = {start, buffer.size() - dataOffset};
+        for (size_t r = 0; r < 2; r++) {
+            for (size_t b = 0; b < 4; b++) {
+                buffer[index * 8 + r * 4 + b] = static_cast<uint8_t>(range[r] >> (8 * b));
+            }
+        }
+    };
+
+    for (size_t i = 0; i < items.size(); i++) {
+        const ItemView* item = items[i];
+        if (item && item->type == "number") {
+            // Aligned, so a column of numbers can be viewed as a Float64Array
+            buffer.resize(dataOffset + ((buffer.size() - dataOffset + 7) & ~static_cast<size_t>(7)), 0);
+            size_t start = buffer.size() - dataOffset;
+
+            double number = parseNumber(item->value);
+            uint64_t bits;
+            std::memcpy(&bits, &number, sizeof(bits));
+            appendLittleEndian(buffer, bits, 8);
+            setRange(i, start);
+            continue;
+        }
+
+        size_t start = buffer.size() - dataOffset;
+        if (item && item->type != "null" && !(item->type == "binary" && decodeBase64(item->value, buffer))) {
+            buffer.insert(buffer.end(), item->value.begin(), item->value.end());
+        }
+        setRange(i, start);
+    }
+    return buffer;
+}
+
+} // namespace pure_storage
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "StorageBackend.h"
+
+namespace pure_storage {
+
+// The values of a batch read packed into one buffer, so JS gets a single
+// ArrayBuffer instead of a string per entry. The buffer starts with a table
+// of count little-endian u32 (start, end) pairs followed by the data; entry i
+// is data[start, end). Numbers are a float64, binary values their decoded
+// bytes, anything else its serialized UTF-8, and missing keys are empty.
+// Numbers start at multiples of 8, so the data of a batch holding only
+// numbers reads as one Float64Array.
+std::vector<uint8_t> packValues(const std::vector<const ItemView*>& items);
+
+// Offset of the data in a packValues() buffer of `count` entries, a multiple of 8
+inline size_t packedDataOffset(size_t count) { return count * 8; }
+
+// Appends the bytes of standard Base64 text to `out`. False, with `out`
+// unchanged, if the text isn't Base64.
+bool decodeBase64(std::string_view text, std::vector<uint8_t>& out);
+
+} // namespace pure_storage
@@ -0,0 +1,1388 @@
+#include "PureStorageEngine.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#include "SipHash.h"
+
+namespace pure_storage {
+
+namespace {
+
+// Keeps the persisted set small for apps that read a lot during startup
+constexpr size_t kMaxStartupKeys = 256;
+
+// How long buffered writes may wait before the worker group-commits them
+constexpr std::chrono::milliseconds kWriteBackDelay(1000);
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+int64_t recordBytes(const std::string& key, const std::string& type, const std::string& value,
+                    const std::string& attributes) {
+    return static_cast<int64_t>(key.size() + type.size() + value.size() + attributes.size());
+}
+
+// The stored length of a value whose valueSize() is `size`: binary values are Base64
+int64_t storedValueBytes(const std::string& type, int64_t size) {
+    return type == "binary" ? (size + 2) / 3 * 4 : size;
+}
+
+bool isExpired(int64_t expiresAt) {
+    return expiresAt != 0 && nowMs() >= expiresAt;
+}
+
+bool isExpired(const StoredItem& item) {
+    return isExpired(item.expiresAt);
+}
+
+// The value types an inlined value can have, as stored in IndexSlot::inlineType
+const char* const kInlineTypes[] = {"string", "number", "boolean", "object", "binary", "null"};
+
+void inlineItem(IndexSlot& slot, bool present, const StoredItem& item) {
+    slot.inlineState = InlineState::None;
+    if (!present) {
+        slot.inlineState = InlineState::Absent;
+        return;
+    }
+    if (item.value.size() > kInlineValueBytes || !item.attributes.empty() || item.expiresAt != 0) {
+        return;
+    }
+
+    auto type = std::find(std::begin(kInlineTypes), std::end(kInlineTypes), item.type);
+    if (type == std::end(kInlineTypes)) {
+        return;
+    }
+
+    slot.inlineType = static_cast<uint8_t>(type - std::begin(kInlineTypes));
+    slot.inlineLength = static_cast<uint8_t>(item.value.size());
+    std::memcpy(slot.inlineValue, item.value.data(), item.value.size());
+    slot.inlineCreatedAt = item.createdAt;
+    slot.inlineModifiedAt = item.modifiedAt;
+    slot.inlineState = InlineState::Value;
+}
+
+// Both strings fit in the small-string buffer, so this doesn't allocate
+StoredItem inlinedItem(const IndexSlot& slot) {
+    StoredItem item;
+    item.type = kInlineTypes[slot.inlineType];
+    item.value.assign(slot.inlineValue, slot.inlineLength);
+    item.size = valueSize(item.type, item.value);
+    item.createdAt = slot.inlineCreatedAt;
+    item.modifiedAt = slot.inlineModifiedAt;
+    return item;
+}
+
+// A value copied out of storage or the cache, for backends that can't map theirs
+class StringValueBuffer : public ValueBuffer {
+public:
+    explicit StringValueBuffer(std::string value) : value_(std::move(value)) {}
+
+    uint8_t* data() override { return reinterpret_cast<uint8_t*>(&value_[0]); }
+    size_t size() const override { return value_.size(); }
+
+private:
+    std::string value_;
+};
+
+// Records of namespaces that hide keys carry their key in front of the
+// value as "<length>:<key><value>", so it's encrypted along with it
+std::string embedKey(const std::string& key, const std::string& value) {
+    return std::to_string(key.size()) + ":" + key + value;
+}
+
+// Strips the embedded key, returning false if it isn't `key` (a hash collision)
+bool extractKey(std::string& value, std::string* key, const std::string* expected) {
+    size_t separator = value.find(':');
+    if (separator == std::string::npos || separator == 0 || separator > 10) {
+        return false;
+    }
+
+    size_t length = 0;
+    for (size_t i = 0; i < separator; i++) {
+        if (value[i] < '0' || value[i] > '9') {
+            return false;
+        }
+        length = length * 10 + (value[i] - '0');
+    }
+
+    size_t start = separator + 1;
+    if (value.size() - start < length) {
+        return false;
+    }
+    if (expected && value.compare(start, length, *expected) != 0) {
+        return false;
+    }
+    if (key) {
+        key->assign(value, start, length);
+    }
+
+    value.erase(0, start + length);
+    return true;
+}
+
+} // namespace
+
+PureStorageEngine::PureStorageEngine(std::shared_ptr<StorageBackend> backend)
+    : backend_(std::move(backend)), backendReady_(true), openMs_(0) {}
+
+PureStorageEngine::PureStorageEngine(BackendOpener openBackend) {
+    // Queued first, so every other worker task runs after the open
+    worker_.enqueue([this, openBackend = std::move(openBackend)] {
+        auto start = std::chrono::steady_clock::now();
+
+        std::shared_ptr<StorageBackend> backend;
+        try {
+            backend = openBackend();
+        } catch (const std::exception&) {
+            // Left null; backend() reports it to every caller
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(openMutex_);
+            backend_ = std::move(backend);
+            openMs_ = elapsedMs(start);
+            backendReady_.store(true, std::memory_order_release);
+        }
+        openCondition_.notify_all();
+    });
+}
+
+PureStorageEngine::~PureStorageEngine() {
+    // Not waiting for an open that hasn't finished: it may be queued on this very thread
+    if (!backendReady_.load(std::memory_order_acquire) || !backend_) {
+        return;
+    }
+
+    try {
+        std::lock_guard<std::mutex> writeLock(writeMutex_);
+        flushLocked(std::chrono::milliseconds(0), FlushScope::Everything);
+    } catch (const std::exception&) {
+        // Nothing left to report to
+    }
+}
+
+StorageBackend& PureStorageEngine::backend() {
+    if (!backendReady_.load(std::memory_order_acquire)) {
+        waitForBackend();
+    }
+
+    if (!backend_) {
+        throw std::runtime_error("PureStorage failed to open its storage backend");
+    }
+    return *backend_;
+}
+
+void PureStorageEngine::waitForBackend() {
+    auto start = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(openMutex_);
+    if (backendReady_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    openCondition_.wait(lock, [this] { return backendReady_.load(std::memory_order_acquire); });
+    openWaits_++;
+    openWaitMs_ += elapsedMs(start);
+}
+
+EngineMetrics PureStorageEngine::metrics() {
+    EngineMetrics result;
+    {
+        std::lock_guard<std::mutex> lock(openMutex_);
+        result.openMs = backendReady_.load(std::memory_order_acquire) ? openMs_ : -1;
+        result.openWaits = openWaits_;
+        result.openWaitMs = openWaitMs_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        result.pendingWrites = pending_.size();
+        result.flushes = flushes_;
+        result.flushedWrites = flushedWrites_;
+        result.inlineReads = inlineReads_;
+    }
+    return result;
+}
+
+SlotRef PureStorageEngine::resolve(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        return it->second;
+    }
+
+    auto slot = std::make_shared<IndexSlot>(key);
+    slot->ns = &namespaceState(namespaceOf(key));
+    slot->version.store(++nextVersion_, std::memory_order_release);
+    index_.emplace(key, slot);
+    return slot;
+}
+
+uint64_t PureStorageEngine::bumpVersion(IndexSlot& slot) {
+    uint64_t version = ++nextVersion_;
+    slot.version.store(version, std::memory_order_release);
+    slot.stat.reset();
+    return version;
+}
+
+std::string PureStorageEngine::namespaceOf(const std::string& key) {
+    size_t separator = key.find(':');
+    return separator == std::string::npos ? std::string() : key.substr(0, separator);
+}
+
+NamespaceState& PureStorageEngine::namespaceState(const std::string& name) {
+    auto& ns = namespaces_[name];
+    if (!ns) {
+        ns = std::make_unique<NamespaceState>(name);
+    }
+    return *ns;
+}
+
+void PureStorageEngine::configureNamespace(const std::string& name, const NamespaceConfig& config) {
+    bool measure;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        NamespaceState& ns = namespaceState(name);
+        ns.config = config;
+        evict(ns, nullptr);
+        measure = config.quotaBytes > 0 && !ns.measured;
+    }
+
+    if (measure) {
+        worker_.enqueue([this, name] { measureNamespace(name); });
+    }
+}
+
+void PureStorageEngine::measureNamespace(const std::string& name) {
+    bool hiding;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        NamespaceState& ns = namespaceState(name);
+        // Already done by a write that ran on the worker ahead of this pass
+        if (ns.measured) {
+            return;
+        }
+        hiding = ns.config.hideKeys;
+    }
+
+    // Hidden keys only come back from listKeys(), as the keys they hash.
+    // Buffered writes are missed, but those were accounted when they were made.
+    std::vector<std::string> keys = hiding || name.empty() ? listKeys() : backend().keysWithPrefix(name + ":");
+    for (const auto& key : keys) {
+        if (namespaceOf(key) != name) {
+            continue;
+        }
+
+        SlotRef slot = resolve(key);
+        uint64_t version;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (slot->storedBytes >= 0) {
+                continue;
+            }
+            version = slot->version.load(std::memory_order_relaxed);
+        }
+
+        // Sized from the record's header, leaving the value on disk. Only
+        // records written before headers were kept need reading in full.
+        bool hidden = false;
+        std::string stored = storageKey(*slot, hidden);
+        int64_t bytes = 0;
+        ItemStat stat;
+        if (backend().statItem(stored, stat) && stat.size >= 0) {
+            bytes = static_cast<int64_t>(slot->key.size() + stat.type.size() + stat.attributes.size()) +
+                    storedValueBytes(stat.type, stat.size);
+        } else {
+            StoredItem item;
+            bool found = backend().getItem(stored, item);
+            if (found && hidden) {
+                found = extractKey(item.value, nullptr, &slot->key);
+            }
+            bytes = found ? recordBytes(slot->key, item.type, item.value, item.attributes) : 0;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slot->version.load(std::memory_order_relaxed) == version && slot->storedBytes < 0) {
+            account(*slot, bytes);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        namespaceState(name).measured = true;
+    }
+    measuredCondition_.notify_all();
+}
+
+void PureStorageEngine::awaitMeasured(NamespaceState& ns) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (ns.config.quotaBytes == 0 || ns.measured) {
+            return;
+        }
+        // The worker's pass is queued behind whatever it runs now, so a write
+        // made there would wait on itself; it measures the namespace instead
+        if (!worker_.isCurrentThread()) {
+            measuredCondition_.wait(lock, [&ns] { return ns.config.quotaBytes == 0 || ns.measured; });
+            return;
+        }
+    }
+    measureNamespace(ns.name);
+}
+
+std::vector<NamespaceStats> PureStorageEngine::namespaceStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::unordered_map<const NamespaceState*, NamespaceStats> stats;
+    for (const auto& entry : namespaces_) {
+        const NamespaceState& ns = *entry.second;
+        NamespaceStats& result = stats[&ns];
+        result.name = ns.name;
+        result.usedBytes = ns.usedBytes;
+        result.measured = ns.measured;
+        result.rejectedWrites = ns.rejectedWrites;
+    }
+
+    for (const auto& entry : index_) {
+        const IndexSlot& slot = *entry.second;
+        if (slot.storedBytes <= 0) {
+            continue;
+        }
+
+        NamespaceStats& result = stats[slot.ns];
+        result.keys++;
+        if (static_cast<uint64_t>(slot.storedBytes) > result.largestBytes) {
+            result.largestBytes = static_cast<uint64_t>(slot.storedBytes);
+            result.largestKey = slot.key;
+        }
+    }
+
+    std::vector<NamespaceStats> result;
+    result.reserve(stats.size());
+    for (auto& entry : stats) {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+void PureStorageEngine::account(IndexSlot& slot, int64_t storedBytes) {
+    NamespaceState& ns = *slot.ns;
+    if (slot.storedBytes > 0) {
+        ns.usedBytes -= static_cast<uint64_t>(slot.storedBytes);
+    }
+    slot.storedBytes = storedBytes;
+    if (storedBytes > 0) {
+        ns.usedBytes += static_cast<uint64_t>(storedBytes);
+    }
+}
+
+bool PureStorageEngine::admit(const IndexSlot& slot, const std::string& type, const std::string& value,
+                              const std::string& attributes) {
+    const NamespaceConfig& config = slot.ns->config;
+
+    if (attributes.size() > kMaxAttributesBytes) {
+        return false;
+    }
+    if (config.maxValueBytes > 0 && value.size() > config.maxValueBytes) {
+        return false;
+    }
+
+    if (config.quotaBytes > 0) {
+        // The record being replaced no longer counts. write() waits for the
+        // namespace to be measured, so a size still unknown means there's no record.
+        uint64_t others = slot.ns->usedBytes - static_cast<uint64_t>(std::max<int64_t>(slot.storedBytes, 0));
+        if (others + static_cast<uint64_t>(recordBytes(slot.key, type, value, attributes)) > config.quotaBytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PureStorageEngine::cacheItem(IndexSlot& slot, bool present, StoredItem item) {
+    NamespaceState& ns = *slot.ns;
+
+    ns.cachedBytes -= slot.cachedBytes;
+    slot.item = std::move(item);
+    slot.loaded = true;
+    slot.present = present;
+    slot.cachedBytes = slot.key.size() + slot.item.type.size() + slot.item.value.size() + slot.item.attributes.size();
+    ns.cachedBytes += slot.cachedBytes;
+    // What's cached is what's stored
+    account(slot, present ? static_cast<int64_t>(slot.cachedBytes) : 0);
+    inlineItem(slot, present, slot.item);
+
+    touch(slot);
+    evict(ns, &slot);
+}
+
+void PureStorageEngine::uncacheItem(IndexSlot& slot) {
+    // Only eviction keeps the inlined copy, since the value didn't change
+    slot.inlineState = InlineState::None;
+    dropItem(slot);
+}
+
+void PureStorageEngine::dropItem(IndexSlot& slot) {
+    if (!slot.loaded) {
+        return;
+    }
+
+    unlink(slot);
+    slot.ns->cachedBytes -= slot.cachedBytes;
+    slot.cachedBytes = 0;
+    slot.item = StoredItem();
+    slot.loaded = false;
+    slot.present = false;
+}
+
+void PureStorageEngine::touch(IndexSlot& slot) {
+    NamespaceState& ns = *slot.ns;
+    if (ns.lruHead == &slot) {
+        return;
+    }
+
+    unlink(slot);
+    slot.lruNext = ns.lruHead;
+    if (ns.lruHead) {
+        ns.lruHead->lruPrev = &slot;
+    }
+    ns.lruHead = &slot;
+    if (!ns.lruTail) {
+        ns.lruTail = &slot;
+    }
+}
+
+void PureStorageEngine::unlink(IndexSlot& slot) {
+    NamespaceState& ns = *slot.ns;
+
+    if (slot.lruPrev) {
+        slot.lruPrev->lruNext = slot.lruNext;
+    } else if (ns.lruHead == &slot) {
+        ns.lruHead = slot.lruNext;
+    }
+
+    if (slot.lruNext) {
+        slot.lruNext->lruPrev = slot.lruPrev;
+    } else if (ns.lruTail == &slot) {
+        ns.lruTail = slot.lruPrev;
+    }
+
+    slot.lruPrev = nullptr;
+    slot.lruNext = nullptr;
+}
+
+void PureStorageEngine::evict(NamespaceState& ns, const IndexSlot* keep) {
+    if (ns.config.cacheBytes == 0) {
+        return;
+    }
+
+    // Evicted slots keep their version: the stored value didn't change, so
+    // values cached by key handles stay valid. Dirty slots are the only copy
+    // of their value until the next flush, so they stay.
+    IndexSlot* slot = ns.lruTail;
+    while (ns.cachedBytes > ns.config.cacheBytes && slot) {
+        IndexSlot* previous = slot->lruPrev;
+        if (slot != keep && !slot->dirty) {
+            dropItem(*slot);
+        }
+        slot = previous;
+    }
+}
+
+template <typename CopyOut>
+uint64_t PureStorageEngine::readWith(const SlotRef& slot, bool& found, CopyOut copyOut) {
+    uint64_t version;
+    bool cached = false;
+    bool expired = false;
+    bool record = recordingStartup_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // The startup set is persisted in plaintext
+        record = record && !slot->ns->config.hideKeys;
+        version = slot->version.load(std::memory_order_relaxed);
+        if (slot->inlineState != InlineState::None) {
+            // Ahead of the cached item: no LRU update, and it may have been evicted
+            cached = true;
+            found = slot->inlineState == InlineState::Value;
+            if (found) {
+                copyOut(inlinedItem(*slot));
+            }
+            inlineReads_++;
+        } else if (slot->loaded) {
+            cached = true;
+            touch(*slot);
+            found = slot->present && !isExpired(slot->item);
+            expired = slot->present && !found;
+            if (found) {
+                copyOut(slot->item);
+            }
+        }
+    }
+
+    if (record) {
+        recordStartupRead(slot->key);
+    }
+
+    if (!cached) {
+        StoredItem loadedItem;
+        found = fetch(slot, version, loadedItem);
+        if (found && isExpired(loadedItem)) {
+            found = false;
+            expired = true;
+        } else if (found) {
+            copyOut(std::move(loadedItem));
+        }
+    }
+
+    if (expired) {
+        expire(slot, version);
+    }
+    return version;
+}
+
+uint64_t PureStorageEngine::read(const SlotRef& slot, StoredItem& item, bool& found) {
+    return readWith(slot, found, [&item](auto&& stored) {
+        item = std::forward<decltype(stored)>(stored);
+    });
+}
+
+uint64_t PureStorageEngine::read(const SlotRef& slot, Arena& arena, ItemView& item, bool& found) {
+    return readWith(slot, found, [&arena, &item](const StoredItem& stored) {
+        item.type = arena.copy(stored.type);
+        item.value = arena.copy(stored.value);
+        item.attributes = arena.copy(stored.attributes);
+    });
+}
+
+void PureStorageEngine::readMany(const std::vector<std::string>& keys, Arena& arena,
+                                 std::vector<ItemView>& items, std::vector<bool>& found) {
+    prefetch(keys);
+
+    items.assign(keys.size(), ItemView());
+    found.assign(keys.size(), false);
+    for (size_t i = 0; i < keys.size(); i++) {
+        bool itemFound = false;
+        read(resolve(keys[i]), arena, items[i], itemFound);
+        found[i] = itemFound;
+    }
+}
+
+bool PureStorageEngine::fetch(const SlotRef& slot, uint64_t version, StoredItem& item) {
+    // Load outside the lock so a slow backend read doesn't block other keys
+    bool hidden = false;
+    bool found = backend().getItem(storageKey(*slot, hidden), item);
+    if (found && hidden) {
+        found = extractKey(item.value, nullptr, &slot->key);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Only cache the result if nothing changed the key while we were loading
+    if (slot->version.load(std::memory_order_relaxed) == version && !slot->loaded) {
+        cacheItem(*slot, found, found ? item : StoredItem());
+    }
+    return found;
+}
+
+std::shared_ptr<ValueBuffer> PureStorageEngine::getBuffer(const std::string& key) {
+    SlotRef slot = resolve(key);
+
+    uint64_t version;
+    bool mappable;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        version = slot->version.load(std::memory_order_relaxed);
+        if ((slot->loaded && !slot->present) || slot->inlineState == InlineState::Absent) {
+            return nullptr;
+        }
+
+        // Only where the stored bytes are the value itself, and a buffered
+        // write hasn't left storage behind the cache
+        const NamespaceConfig& config = slot->ns->config;
+        mappable = !slot->dirty && !config.encryption && !config.compression && !config.hideKeys;
+    }
+
+    if (mappable) {
+        StoredItem item;
+        std::shared_ptr<ValueBuffer> buffer = backend().mapItem(key, item);
+        if (buffer && isExpired(item)) {
+            expire(slot, version);
+            return nullptr;
+        }
+        if (buffer) {
+            return buffer;
+        }
+    }
+
+    StoredItem item;
+    bool found = false;
+    read(slot, item, found);
+    return found ? std::make_shared<StringValueBuffer>(std::move(item.value)) : nullptr;
+}
+
+bool PureStorageEngine::stat(const std::string& key, ItemStat& stat) {
+    SlotRef slot = resolve(key);
+
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slot->loaded) {
+            const StoredItem& item = slot->item;
+            if (!slot->present || isExpired(item)) {
+                return false;
+            }
+            stat.type = item.type;
+            stat.size = valueSize(item.type, item.value);
+            stat.createdAt = item.createdAt;
+            stat.modifiedAt = item.modifiedAt;
+            stat.expiresAt = item.expiresAt;
+            stat.attributes = item.attributes;
+            return true;
+        }
+        if (slot->inlineState != InlineState::None) {
+            if (slot->inlineState == InlineState::Absent) {
+                return false;
+            }
+            StoredItem item = inlinedItem(*slot);
+            stat.type = std::move(item.type);
+            stat.size = item.size;
+            stat.createdAt = item.createdAt;
+            stat.modifiedAt = item.modifiedAt;
+            stat.expiresAt = 0;
+            stat.attributes.clear();
+            return true;
+        }
+        if (slot->stat && !isExpired(slot->stat->expiresAt)) {
+            stat = *slot->stat;
+            return true;
+        }
+        version = slot->version.load(std::memory_order_relaxed);
+    }
+
+    bool hidden = false;
+    if (!backend().statItem(storageKey(*slot, hidden), stat) || isExpired(stat.expiresAt)) {
+        return false;
+    }
+
+    if (stat.size < 0) {
+        // Written before sizes were kept, so measure the value, which also
+        // caches it and makes the next stat() free
+        StoredItem item;
+        bool found = false;
+        read(slot, item, found);
+        if (!found) {
+            return false;
+        }
+        stat.type = std::move(item.type);
+        stat.size = valueSize(stat.type, item.value);
+        stat.createdAt = item.createdAt;
+        stat.modifiedAt = item.modifiedAt;
+        stat.expiresAt = item.expiresAt;
+        stat.attributes = std::move(item.attributes);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slot->version.load(std::memory_order_relaxed) == version && !slot->loaded) {
+        slot->stat = std::make_unique<ItemStat>(stat);
+    }
+    return true;
+}
+
+std::vector<std::pair<std::string, ItemStat>> PureStorageEngine::listWithStat(const std::string& prefix) {
+    std::vector<std::pair<std::string, ItemStat>> result;
+    for (auto& key : keysWithPrefix(prefix)) {
+        ItemStat itemStat;
+        if (stat(key, itemStat)) {
+            result.emplace_back(std::move(key), std::move(itemStat));
+        }
+    }
+    return result;
+}
+
+bool PureStorageEngine::write(const SlotRef& slot, const std::string& type, const std::string& value, bool encrypted,
+                              const std::string& attributes, bool compressed) {
+    // A quota is only as good as usedBytes, so writes to a namespace the
+    // worker is still measuring wait for it rather than being admitted
+    // against a partial sum. Writes to other namespaces go ahead.
+    awaitMeasured(*slot->ns);
+
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+
+    NamespaceConfig config;
+    bool staging;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Checked before anything is encoded or written, so oversized
+        // writes cost no more than a comparison
+        if (!admit(*slot, type, value, attributes)) {
+            slot->ns->rejectedWrites++;
+            return false;
+        }
+        config = slot->ns->config;
+        staging = stagingThreads_.count(std::this_thread::get_id()) > 0;
+    }
+
+    StoredItem item;
+    item.type = type;
+    item.value = value;
+    item.attributes = attributes;
+    item.size = valueSize(type, value);
+    item.modifiedAt = nowMs();
+    if (config.ttlDefaultMs > 0) {
+        item.expiresAt = item.modifiedAt + config.ttlDefaultMs;
+    }
+
+    WriteOptions options;
+    options.encrypted = encrypted || config.encryption || config.hideKeys;
+    if (options.encrypted) {
+        options.keyNamespace = slot->ns->name;
+    }
+    options.compressed = compressed || config.compression;
+    options.durability = config.durability;
+
+    bool hidden = false;
+    std::string name = storageKey(*slot, hidden);
+    item.createdAt = createdAt(*slot, name, item.modifiedAt);
+    StoredItem stored = item;
+    if (hidden) {
+        stored.value = embedKey(slot->key, value);
+    }
+
+    // Async and staged writes are only buffered here; the cache serves them until a flush
+    bool buffered = staging || config.durability == Durability::Async;
+    if (!buffered && !backend().setItem(name, stored, options)) {
+        return false;
+    }
+
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (buffered) {
+            std::thread::id stager = staging ? std::this_thread::get_id() : std::thread::id();
+            pending_[slot->key] = PendingWrite{slot, std::move(name), std::move(stored), std::move(options), stager};
+        } else {
+            pending_.erase(slot->key);
+        }
+        slot->dirty = buffered;
+
+        // The cache always holds the decrypted value
+        cacheItem(*slot, true, std::move(item));
+        version = bumpVersion(*slot);
+    }
+
+    // Staged writes are committed by commitStaged() instead
+    if (buffered && !staging) {
+        scheduleFlush();
+    }
+
+    notify(slot->key, version);
+    return true;
+}
+
+int64_t PureStorageEngine::createdAt(IndexSlot& slot, const std::string& storageKey, int64_t now) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slot.loaded) {
+            bool replacing = slot.present && !isExpired(slot.item) && slot.item.createdAt != 0;
+            return replacing ? slot.item.createdAt : now;
+        }
+        if (slot.inlineState == InlineState::Value) {
+            return slot.inlineCreatedAt != 0 ? slot.inlineCreatedAt : now;
+        }
+        if (slot.inlineState == InlineState::Absent) {
+            return now;
+        }
+        if (slot.stat) {
+            return slot.stat->createdAt != 0 ? slot.stat->createdAt : now;
+        }
+    }
+
+    // Overwriting a key that isn't loaded: its header says when it was created
+    ItemStat stat;
+    bool replacing = backend().statItem(storageKey, stat) && !isExpired(stat.expiresAt) && stat.createdAt != 0;
+    return replacing ? stat.createdAt : now;
+}
+
+bool PureStorageEngine::isStaged(const PendingWrite& write) const {
+    // A thread that stopped staging left its failed writes to the worker
+    return write.stager != std::thread::id() && stagingThreads_.count(write.stager) > 0;
+}
+
+void PureStorageEngine::scheduleFlush() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (flushScheduled_) {
+            return;
+        }
+        // Staged writes wait for their thread's commitStaged()
+        bool flushable = std::any_of(pending_.begin(), pending_.end(), [this](const auto& entry) {
+            return !isStaged(entry.second);
+        });
+        if (!flushable) {
+            return;
+        }
+        flushScheduled_ = true;
+    }
+
+    worker_.enqueueAfter(kWriteBackDelay, [this] { flush(); });
+}
+
+size_t PureStorageEngine::flush(std::chrono::milliseconds budget) {
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+    return flushLocked(budget, FlushScope::OwnStaged);
+}
+
+void PureStorageEngine::beginStaging() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stagingThreads_.insert(std::this_thread::get_id());
+}
+
+size_t PureStorageEngine::commitStaged() {
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+    {
+        // Under writeMutex_ too, so no write can stage itself after the batch is taken
+        std::lock_guard<std::mutex> lock(mutex_);
+        stagingThreads_.erase(std::this_thread::get_id());
+    }
+    return flushLocked(std::chrono::milliseconds(0), FlushScope::Unstaged);
+}
+
+void PureStorageEngine::beginBatch() {
+    backend().beginBatch();
+}
+
+bool PureStorageEngine::commitBatch() {
+    // A flush running meanwhile batches on its own thread
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+    return backend().commitBatch();
+}
+
+bool PureStorageEngine::isBuffered(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.count(key) > 0;
+}
+
+size_t PureStorageEngine::onAppBackground(std::chrono::milliseconds budget) {
+    // The process may not live to see a staging thread commit
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+    return flushLocked(budget, FlushScope::Everything);
+}
+
+size_t PureStorageEngine::flushLocked(std::chrono::milliseconds budget, FlushScope scope) {
+    // writeMutex_ keeps new writes out, so the batch is everything there is
+    std::vector<PendingWrite> batch;
+    size_t left;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushScheduled_ = false;
+        std::thread::id self = std::this_thread::get_id();
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            PendingWrite& write = it->second;
+            bool take = !isStaged(write) || scope == FlushScope::Everything ||
+                (scope == FlushScope::OwnStaged && write.stager == self);
+            if (take) {
+                batch.push_back(std::move(write));
+                it = pending_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        left = pending_.size();
+    }
+
+    // Staged writes left alone still count as buffered
+    if (batch.empty()) {
+        return left;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    size_t written = 0;
+    bool committed = false;
+    try {
+        backend().beginBatch();
+        for (; written < batch.size(); written++) {
+            if (budget.count() > 0 && written > 0 && std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+
+            const PendingWrite& write = batch[written];
+            if (!backend().setItem(write.storageKey, write.item, write.options)) {
+                break;
+            }
+        }
+        committed = backend().commitBatch();
+    } catch (const std::exception&) {
+        // Everything stays buffered for the next attempt
+    }
+
+    size_t remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!committed) {
+            written = 0;
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (i < written) {
+                batch[i].slot->dirty = false;
+            } else {
+                // Retried by the worker from now on, staged or not
+                std::string key = batch[i].slot->key;
+                batch[i].stager = std::thread::id();
+                pending_.emplace(std::move(key), std::move(batch[i]));
+            }
+        }
+
+        flushes_++;
+        flushedWrites_ += written;
+        remaining = pending_.size();
+    }
+
+    scheduleFlush();
+    return remaining;
+}
+
+bool PureStorageEngine::erase(const SlotRef& slot) {
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+    return eraseLocked(slot);
+}
+
+std::string PureStorageEngine::storageKey(const IndexSlot& slot, bool& hidden) {
+    NamespaceState& ns = *slot.ns;
+    std::string secret;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hidden = ns.config.hideKeys;
+        if (!hidden) {
+            return slot.key;
+        }
+        secret = ns.keyHashSecret;
+    }
+
+    if (secret.empty()) {
+        // May create the namespace's data key, so done outside the lock
+        secret = backend().getKeyHashSecret(ns.name);
+        if (secret.size() != 16) {
+            throw std::runtime_error("PureStorage has no key hash secret for namespace " + ns.name);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ns.keyHashSecret = secret;
+    }
+
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+        static_cast<unsigned long long>(sipHash24(reinterpret_cast<const uint8_t*>(secret.data()), slot.key)));
+    return ns.name + ":" + hash;
+}
+
+bool PureStorageEngine::eraseLocked(const SlotRef& slot) {
+    bool hidden = false;
+    if (!backend().removeItem(storageKey(*slot, hidden))) {
+        return false;
+    }
+
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.erase(slot->key);
+        slot->dirty = false;
+        cacheItem(*slot, false, StoredItem());
+        version = bumpVersion(*slot);
+    }
+
+    notify(slot->key, version);
+    return true;
+}
+
+void PureStorageEngine::expire(const SlotRef& slot, uint64_t version) {
+    // Removing the record is I/O, so it's left to the worker; the item
+    // already reads as missing
+    worker_.enqueue([this, slot, version] {
+        std::lock_guard<std::mutex> writeLock(writeMutex_);
+        if (slot->version.load(std::memory_order_acquire) == version) {
+            eraseLocked(slot);
+        }
+    });
+}
+
+bool PureStorageEngine::getItem(const std::string& key, StoredItem& item) {
+    bool found = false;
+    read(resolve(key), item, found);
+    return found;
+}
+
+bool PureStorageEngine::setItem(const std::string& key, const std::string& type, const std::string& value, bool encrypted,
+                                const std::string& attributes, bool compressed) {
+    return write(resolve(key), type, value, encrypted, attributes, compressed);
+}
+
+bool PureStorageEngine::removeItem(const std::string& key) {
+    return erase(resolve(key));
+}
+
+bool PureStorageEngine::hasKey(const std::string& key) {
+    // A full read, so expired items count as missing; the item is then
+    // cached for the get that usually follows
+    StoredItem item;
+    return getItem(key, item);
+}
+
+bool PureStorageEngine::clear() {
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+
+    if (!backend().clear()) {
+        return false;
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> changed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        changed.reserve(index_.size());
+        pending_.clear();
+        for (auto& entry : index_) {
+            IndexSlot& slot = *entry.second;
+            bool wasPresent = slot.loaded ? slot.present : slot.inlineState != InlineState::Absent;
+            slot.dirty = false;
+            cacheItem(slot, false, StoredItem());
+            if (wasPresent) {
+                changed.emplace_back(slot.key, bumpVersion(slot));
+            }
+        }
+    }
+
+    for (const auto& change : changed) {
+        notify(change.first, change.second);
+    }
+    return true;
+}
+
+bool PureStorageEngine::shredNamespace(const std::string& name) {
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+
+    if (!backend().shredNamespace(name)) {
+        return false;
+    }
+
+    // Plaintext copies of the namespace's values must not outlive the key,
+    // so drop them from the cache now and let the next read go to storage
+    std::vector<std::pair<std::string, uint64_t>> changed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // The next data key comes with a new secret
+        namespaceState(name).keyHashSecret.clear();
+
+        for (auto& entry : index_) {
+            IndexSlot& slot = *entry.second;
+            if (slot.ns->name == name) {
+                // Buffered values were encrypted for the old key
+                pending_.erase(slot.key);
+                slot.dirty = false;
+                uncacheItem(slot);
+                account(slot, -1);
+                changed.emplace_back(slot.key, bumpVersion(slot));
+            }
+        }
+    }
+
+    for (const auto& change : changed) {
+        notify(change.first, change.second);
+    }
+
+    worker_.enqueue([this, name] { removeUnreadable(name); });
+    return true;
+}
+
+void PureStorageEngine::removeUnreadable(const std::string& name) {
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+
+    // The keys without a namespace share no prefix
+    std::vector<std::string> keys = name.empty() ? backend().getAllKeys() : backend().keysWithPrefix(name + ":");
+    for (const auto& key : keys) {
+        if (namespaceOf(key) != name) {
+            continue;
+        }
+
+        // A record that exists but doesn't read was encrypted with the shredded
+        // key. Removed by its stored name, which is a hash if keys are hidden;
+        // the cache already forgot it when the key was shredded.
+        StoredItem item;
+        if (!backend().getItem(key, item) && backend().hasKey(key)) {
+            backend().removeItem(key);
+        }
+    }
+
+    bool measure;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        NamespaceState& ns = namespaceState(name);
+        measure = ns.measured;
+        ns.measured = false;
+    }
+    if (measure) {
+        measureNamespace(name);
+    }
+}
+
+std::vector<std::string> PureStorageEngine::keysWithPrefix(const std::string& prefix) {
+    // Buffered keys aren't in storage yet. A batch being staged isn't
+    // complete, so its keys are listed from the buffer instead.
+    {
+        std::lock_guard<std::mutex> writeLock(writeMutex_);
+        flushLocked(std::chrono::milliseconds(0), FlushScope::Unstaged);
+    }
+
+    // A prefix inside one namespace can be looked up in the backend, unless
+    // the namespace hides its keys behind hashes
+    bool scoped = false;
+    std::string name = namespaceOf(prefix);
+    if (!name.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = namespaces_.find(name);
+        scoped = it == namespaces_.end() || !it->second->config.hideKeys;
+    }
+
+    std::vector<std::string> keys;
+    if (scoped) {
+        keys = backend().keysWithPrefix(prefix);
+    } else {
+        keys = listKeys();
+        keys.erase(
+            std::remove_if(keys.begin(), keys.end(), [&prefix](const std::string& key) {
+                return key.compare(0, prefix.size(), prefix) != 0;
+            }),
+            keys.end()
+        );
+    }
+    addStagedKeys(keys, prefix);
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+std::vector<std::string> PureStorageEngine::getAllKeys() {
+    {
+        std::lock_guard<std::mutex> writeLock(writeMutex_);
+        flushLocked(std::chrono::milliseconds(0), FlushScope::Unstaged);
+    }
+    std::vector<std::string> keys = listKeys();
+    addStagedKeys(keys, std::string());
+    return keys;
+}
+
+void PureStorageEngine::addStagedKeys(std::vector<std::string>& keys, const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_set<std::string> listed;
+    for (const auto& entry : pending_) {
+        if (!isStaged(entry.second) || entry.first.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        if (listed.empty()) {
+            listed.insert(keys.begin(), keys.end());
+        }
+        if (listed.insert(entry.first).second) {
+            keys.push_back(entry.first);
+        }
+    }
+}
+
+std::vector<std::string> PureStorageEngine::listKeys() {
+    std::vector<std::string> keys = backend().getAllKeys();
+
+    std::unordered_set<std::string> hiding;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : namespaces_) {
+            if (entry.second->config.hideKeys) {
+                hiding.insert(entry.first);
+            }
+        }
+    }
+    if (hiding.empty()) {
+        return keys;
+    }
+
+    // Hidden keys can only be recovered by reading their records, which
+    // makes this a full scan of those namespaces
+    std::vector<std::string> result;
+    result.reserve(keys.size());
+    for (const auto& key : keys) {
+        if (!hiding.count(namespaceOf(key))) {
+            result.push_back(key);
+            continue;
+        }
+
+        StoredItem item;
+        std::string original;
+        if (backend().getItem(key, item) && extractKey(item.value, &original, nullptr)) {
+            result.push_back(std::move(original));
+        }
+    }
+    return result;
+}
+
+size_t PureStorageEngine::prefetch(const std::vector<std::string>& keys) {
+    size_t present = 0;
+
+    std::vector<std::pair<SlotRef, uint64_t>> missing;
+    for (const auto& key : keys) {
+        SlotRef slot = resolve(key);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slot->loaded) {
+            present += slot->present ? 1 : 0;
+            continue;
+        }
+        if (slot->inlineState != InlineState::None) {
+            present += slot->inlineState == InlineState::Value ? 1 : 0;
+            continue;
+        }
+        missing.emplace_back(slot, slot->version.load(std::memory_order_relaxed));
+    }
+
+    // Let the backend start on all of them before reading them one by one
+    if (missing.size() > 1) {
+        std::vector<std::string> storageKeys;
+        storageKeys.reserve(missing.size());
+        for (const auto& entry : missing) {
+            bool hidden = false;
+            storageKeys.push_back(storageKey(*entry.first, hidden));
+        }
+        backend().willNeed(storageKeys);
+    }
+
+    for (const auto& entry : missing) {
+        StoredItem item;
+        if (fetch(entry.first, entry.second, item)) {
+            present++;
+        }
+    }
+
+    return present;
+}
+
+size_t PureStorageEngine::prefetchPrefix(const std::string& prefix) {
+    return prefetch(backend().keysWithPrefix(prefix));
+}
+
+void PureStorageEngine::prewarmStartupKeys(std::chrono::milliseconds window) {
+    recordingStartup_.store(true, std::memory_order_relaxed);
+
+    // Reads racing the prewarm are fine: prefetch skips keys already loaded
+    worker_.enqueue([this] {
+        prefetch(backend().getStartupKeys());
+    });
+
+    worker_.enqueueAfter(window, [this] {
+        finishStartupRecording();
+    });
+}
+
+void PureStorageEngine::recordStartupRead(const std::string& key) {
+    std::lock_guard<std::mutex> lock(startupMutex_);
+    if (!recordingStartup_.load(std::memory_order_relaxed) || startupKeys_.size() >= kMaxStartupKeys) {
+        return;
+    }
+
+    if (startupKeySet_.insert(key).second) {
+        startupKeys_.push_back(key);
+    }
+}
+
+void PureStorageEngine::finishStartupRecording() {
+    std::vector<std::string> keys;
+    {
+        std::lock_guard<std::mutex> lock(startupMutex_);
+        recordingStartup_.store(false, std::memory_order_relaxed);
+        keys.swap(startupKeys_);
+        startupKeySet_.clear();
+    }
+
+    // A launch that read nothing (e.g. a headless start) keeps the last set
+    if (!keys.empty()) {
+        backend().setStartupKeys(keys);
+    }
+}
+
+void PureStorageEngine::invalidate(const std::string& key) {
+    // Waits out a flush in progress, so it can't write over the change
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            // Nothing cached and nobody holds a handle for this key
+            return;
+        }
+
+        // The value written from outside the engine wins over a buffered one
+        IndexSlot& slot = *it->second;
+        pending_.erase(key);
+        slot.dirty = false;
+        uncacheItem(slot);
+        account(slot, -1);
+        version = bumpVersion(slot);
+    }
+
+    notify(key, version);
+}
+
+ListenerId PureStorageEngine::addListener(const std::string& key, ChangeListener listener) {
+    std::lock_guard<std::mutex> lock(listenerMutex_);
+    ListenerId id = ++nextListenerId_;
+    listeners_[key].emplace_back(id, std::move(listener));
+    return id;
+}
+
+void PureStorageEngine::removeListener(const std::string& key, ListenerId id) {
+    std::lock_guard<std::mutex> lock(listenerMutex_);
+
+    auto it = listeners_.find(key);
+    if (it == listeners_.end()) {
+        return;
+    }
+
+    auto& keyListeners = it->second;
+    for (auto listener = keyListeners.begin(); listener != keyListeners.end(); ++listener) {
+        if (listener->first == id) {
+            keyListeners.erase(listener);
+            break;
+        }
+    }
+
+    if (keyListeners.empty()) {
+        listeners_.erase(it);
+    }
+}
+
+void PureStorageEngine::notify(const std::string& key, uint64_t version) {
+    std::vector<ChangeListener> toCall;
+    {
+        std::lock_guard<std::mutex> lock(listenerMutex_);
+        auto it = listeners_.find(key);
+        if (it == listeners_.end()) {
+            return;
+        }
+        for (const auto& listener : it->second) {
+            toCall.push_back(listener.second);
+        }
+    }
+
+    // Call outside the lock so listeners can (un)subscribe
+    for (const auto& listener : toCall) {
+        listener(key, version);
+    }
+}
+
+} // namespace pure_storage
@@ -0,0 +1,368 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "Arena.h"
+#include "StorageBackend.h"
+#include "WorkQueue.h"
+
+namespace pure_storage {
+
+struct NamespaceConfig {
+    Durability durability = Durability::Default;
+    bool compression = false;
+    // Encrypt every write, whatever the caller asked for
+    bool encryption = false;
+    // Budget for the namespace's cached items; 0 means unlimited
+    size_t cacheBytes = 0;
+    // Expiry applied to every write; 0 means items don't expire
+    int64_t ttlDefaultMs = 0;
+    // Store records under a keyed hash of their key, with the key itself
+    // inside the encrypted value. Implies encryption.
+    bool hideKeys = false;
+    // Writes that would take the namespace past quotaBytes, or whose value is
+    // longer than maxValueBytes, are rejected before reaching storage; 0 means no limit
+    uint64_t quotaBytes = 0;
+    size_t maxValueBytes = 0;
+};
+
+struct NamespaceStats {
+    std::string name;
+    // Size of the namespace's records the engine knows about (key, type,
+    // value and attributes, before compression); complete once the namespace was measured
+    uint64_t usedBytes = 0;
+    uint64_t keys = 0;
+    bool measured = false;
+    uint64_t rejectedWrites = 0;
+    // The namespace's biggest known record
+    std::string largestKey;
+    uint64_t largestBytes = 0;
+};
+
+struct IndexSlot;
+
+// Guarded by the engine mutex. Never removed once created, so slots can point at it.
+struct NamespaceState {
+    explicit NamespaceState(std::string stateName) : name(std::move(stateName)) {}
+
+    const std::string name;
+    NamespaceConfig config;
+    // For hideKeys; fetched from the backend on first use
+    std::string keyHashSecret;
+    // Sum of the slots' storedBytes
+    uint64_t usedBytes = 0;
+    bool measured = false;
+    uint64_t rejectedWrites = 0;
+    size_t cachedBytes = 0;
+    // Loaded slots, most recently used first, for evicting down to cacheBytes
+    IndexSlot* lruHead = nullptr;
+    IndexSlot* lruTail = nullptr;
+};
+
+// Values of up to this many bytes are also kept in their index slot
+constexpr size_t kInlineValueBytes = 15;
+
+enum class InlineState : uint8_t {
+    None,
+    // The key is known to have no value
+    Absent,
+    Value,
+};
+
+// A resolved entry in the engine index. Slots are never dropped from the
+// index once created, so key handles can keep a pointer to them; removing
+// a key only clears the cached item and bumps the version.
+struct IndexSlot {
+    explicit IndexSlot(std::string slotKey) : key(std::move(slotKey)) {}
+
+    const std::string key;
+
+    // Changes every time the stored value changes. Readable without the lock
+    // so key handles can validate their cached value with a single load.
+    std::atomic<uint64_t> version{0};
+
+    // Guarded by the engine mutex. A copy of a small value, or of the key
+    // having none, kept next to the version. Eviction leaves it in place,
+    // so reads of flags and counters are served from the slot without the
+    // cached item, the LRU list or the backend. Values with attributes or
+    // an expiry aren't inlined.
+    InlineState inlineState = InlineState::None;
+    // Index into the engine's table of value types
+    uint8_t inlineType = 0;
+    uint8_t inlineLength = 0;
+    char inlineValue[kInlineValueBytes];
+    int64_t inlineCreatedAt = 0;
+    int64_t inlineModifiedAt = 0;
+
+    // Guarded by the engine mutex
+    bool loaded = false;
+    bool present = false;
+    StoredItem item;
+    NamespaceState* ns = nullptr;
+    size_t cachedBytes = 0;
+    // Has a buffered write that isn't in storage yet, so it can't be evicted
+    bool dirty = false;
+    // Size of the stored record (0 if there is none), or -1 if unknown
+    int64_t storedBytes = -1;
+    // Header of a record that isn't loaded, from the last statItem(); reset
+    // whenever the version changes
+    std::unique_ptr<ItemStat> stat;
+    IndexSlot* lruPrev = nullptr;
+    IndexSlot* lruNext = nullptr;
+};
+
+using SlotRef = std::shared_ptr<IndexSlot>;
+using ListenerId = uint64_t;
+using ChangeListener = std::function<void(const std::string& key, uint64_t version)>;
+
+// Creates the platform backend. Run on the engine worker, so it may be slow.
+using BackendOpener = std::function<std::shared_ptr<StorageBackend>()>;
+
+struct EngineMetrics {
+    // Time spent opening the backend; negative while the open is in progress
+    double openMs = -1;
+    // Calls that had to wait for the open to finish, and for how long in total
+    uint64_t openWaits = 0;
+    double openWaitMs = 0;
+    // Buffered writes not yet in storage, and the group commits that wrote the rest
+    uint64_t pendingWrites = 0;
+    uint64_t flushes = 0;
+    uint64_t flushedWrites = 0;
+    // Reads served from a value inlined in its index slot
+    uint64_t inlineReads = 0;
+};
+
+// Native storage engine shared by the JSI bindings on both platforms.
+// Keeps an index of every key touched through it, caches decoded items and
+// writes through to the platform backend.
+class PureStorageEngine {
+public:
+    explicit PureStorageEngine(std::shared_ptr<StorageBackend> backend);
+
+    // Returns immediately and opens the backend on worker(). Calls that need
+    // the backend before the open has finished block until it has.
+    explicit PureStorageEngine(BackendOpener openBackend);
+
+    // Writes out anything still buffered
+    ~PureStorageEngine();
+
+    // Find or create the index slot for a key
+    SlotRef resolve(const std::string& key);
+
+    // Slot operations. read() returns the version the item was read at.
+    uint64_t read(const SlotRef& slot, StoredItem& item, bool& found);
+    // Same, with the item's strings copied into the arena instead of the heap
+    uint64_t read(const SlotRef& slot, Arena& arena, ItemView& item, bool& found);
+    // Several keys into the arena; found[i] says whether items[i] is set.
+    // Keys that aren't cached are fetched as one batch before any is read.
+    void readMany(const std::vector<std::string>& keys, Arena& arena,
+                  std::vector<ItemView>& items, std::vector<bool>& found);
+    // Replaces the whole record, so attributes not passed again are dropped.
+    // `compressed` asks for this record to be compressed even if its
+    // namespace isn't.
+    bool write(const SlotRef& slot, const std::string& type, const std::string& value, bool encrypted,
+               const std::string& attributes = std::string(), bool compressed = false);
+    bool erase(const SlotRef& slot);
+
+    // Key operations
+    bool getItem(const std::string& key, StoredItem& item);
+    bool setItem(const std::string& key, const std::string& type, const std::string& value, bool encrypted,
+                 const std::string& attributes = std::string(), bool compressed = false);
+    bool removeItem(const std::string& key);
+    bool hasKey(const std::string& key);
+    // The stored bytes of a value, e.g. the UTF-8 of a string, for handing to
+    // JS as an ArrayBuffer. Served in place from storage when the backend can
+    // map it and the namespace stores values as they are; otherwise a single
+    // copy. Null if the key doesn't exist.
+    std::shared_ptr<ValueBuffer> getBuffer(const std::string& key);
+    // Type, size, times and attributes of a value without reading it: from
+    // the cache if it's loaded, otherwise from the record's header
+    bool stat(const std::string& key, ItemStat& stat);
+    // stat() of every key starting with `prefix`, in key order
+    std::vector<std::pair<std::string, ItemStat>> listWithStat(const std::string& prefix);
+    // Every key starting with `prefix`, sorted
+    std::vector<std::string> keysWithPrefix(const std::string& prefix);
+    bool clear();
+    std::vector<std::string> getAllKeys();
+
+    // Keys belong to the namespace before their first ':', which is how
+    // StorageInstance writes them; keys without one are in the "" namespace
+    static std::string namespaceOf(const std::string& key);
+
+    // Applies to writes made from now on, and to the cache right away.
+    // Setting a quota measures the namespace's current usage on worker().
+    void configureNamespace(const std::string& name, const NamespaceConfig& config);
+
+    // Usage of every namespace the engine has seen, for finding the ones
+    // that store too much
+    std::vector<NamespaceStats> namespaceStats();
+
+    // Crypto-shred a namespace: its data key is destroyed, so everything
+    // encrypted with it reads as missing from then on. The unreadable
+    // records are removed later on worker().
+    bool shredNamespace(const std::string& name);
+
+    // Load keys into the cache so later reads don't reach the backend.
+    // Blocking; meant to run on worker(). Returns how many keys exist.
+    size_t prefetch(const std::vector<std::string>& keys);
+    size_t prefetchPrefix(const std::string& prefix);
+
+    // Warm the keys the previous launch read during startup, and record the
+    // keys read during the next `window` for the launch after this one.
+    // Called once after install; the work happens on worker().
+    void prewarmStartupKeys(std::chrono::milliseconds window = std::chrono::seconds(5));
+
+    // Write buffered writes to storage in one group commit. Stops starting
+    // new writes once `budget` has passed (zero means no limit); whatever is
+    // left stays buffered. Writes staged by another thread are left to it.
+    // Returns the number of writes still buffered.
+    size_t flush(std::chrono::milliseconds budget = std::chrono::milliseconds(0));
+
+    // Buffer every write the calling thread makes from now on, whatever its
+    // namespace's durability, until it calls commitStaged(), which writes
+    // them out as one group commit. Other threads' writes are unaffected,
+    // and their flushes skip the staged ones. Reads are served the staged
+    // values from the cache meanwhile; removals still go straight to storage.
+    void beginStaging();
+    // Stop staging on the calling thread, and flush(). If the commit fails
+    // the writes stay buffered and are retried on worker(), like
+    // Durability::Async ones.
+    size_t commitStaged();
+
+    // Storage holds back the calling thread's writes until commitBatch()
+    // persists them together. Nothing is buffered in the engine, so other
+    // threads and staging are unaffected; writes to Durability::Async
+    // namespaces are still buffered as usual.
+    void beginBatch();
+    // False if storage couldn't persist the batch
+    bool commitBatch();
+    // Whether a write of the key is buffered in the engine, not yet in storage
+    bool isBuffered(const std::string& key);
+
+    // Called by the platform modules when the app goes to the background,
+    // after which the process may be killed without warning
+    size_t onAppBackground(std::chrono::milliseconds budget = std::chrono::seconds(1));
+
+    EngineMetrics metrics();
+
+    // Background thread for work that shouldn't run on the JS thread
+    WorkQueue& worker() { return worker_; }
+
+    // Drop the cached state of a key that was written outside the engine
+    // (e.g. by the async bridge module)
+    void invalidate(const std::string& key);
+
+    // Change listeners are called on the thread that made the change
+    ListenerId addListener(const std::string& key, ChangeListener listener);
+    void removeListener(const std::string& key, ListenerId id);
+
+private:
+    StorageBackend& backend();
+    void waitForBackend();
+
+    uint64_t bumpVersion(IndexSlot& slot);
+
+    // Cache bookkeeping; called with mutex_ held
+    NamespaceState& namespaceState(const std::string& name);
+    void cacheItem(IndexSlot& slot, bool present, StoredItem item);
+    void uncacheItem(IndexSlot& slot);
+    void dropItem(IndexSlot& slot);
+    void touch(IndexSlot& slot);
+    void unlink(IndexSlot& slot);
+    void evict(NamespaceState& ns, const IndexSlot* keep);
+    void account(IndexSlot& slot, int64_t storedBytes);
+    bool admit(const IndexSlot& slot, const std::string& type, const std::string& value, const std::string& attributes);
+    void measureNamespace(const std::string& name);
+    // Blocks until a namespace with a quota has been measured
+    void awaitMeasured(NamespaceState& ns);
+    std::vector<std::string> listKeys();
+    // Adds the keys with `prefix` that are only in staged writes
+    void addStagedKeys(std::vector<std::string>& keys, const std::string& prefix);
+
+    // Which buffered writes a flush takes: unstaged ones always, and staged
+    // ones of the calling thread or of every thread
+    enum class FlushScope { Unstaged, OwnStaged, Everything };
+    size_t flushLocked(std::chrono::milliseconds budget, FlushScope scope);
+    void scheduleFlush();
+
+    // The key the slot's record is stored under, which is its own key unless
+    // the namespace hides keys
+    std::string storageKey(const IndexSlot& slot, bool& hidden);
+    // When the record a write replaces was created, or `now` if it's new
+    int64_t createdAt(IndexSlot& slot, const std::string& storageKey, int64_t now);
+    bool eraseLocked(const SlotRef& slot);
+    void removeUnreadable(const std::string& name);
+    void expire(const SlotRef& slot, uint64_t version);
+    bool fetch(const SlotRef& slot, uint64_t version, StoredItem& item);
+    template <typename CopyOut>
+    uint64_t readWith(const SlotRef& slot, bool& found, CopyOut copyOut);
+    void recordStartupRead(const std::string& key);
+    void finishStartupRecording();
+    void notify(const std::string& key, uint64_t version);
+
+    // Written once by the open, then read without the lock after checking backendReady_
+    std::shared_ptr<StorageBackend> backend_;
+    std::atomic<bool> backendReady_{false};
+    std::mutex openMutex_;
+    std::condition_variable openCondition_;
+    double openMs_ = -1;
+    uint64_t openWaits_ = 0;
+    double openWaitMs_ = 0;
+
+    // Serializes writes so the backend and the index apply them in the same order
+    std::mutex writeMutex_;
+
+    // Durability::Async and staged writes waiting for a group commit, by key. Guarded by mutex_.
+    struct PendingWrite {
+        SlotRef slot;
+        std::string storageKey;
+        StoredItem item;
+        WriteOptions options;
+        // The thread that staged it, or a default id
+        std::thread::id stager;
+    };
+    std::unordered_map<std::string, PendingWrite> pending_;
+    bool flushScheduled_ = false;
+    // Threads between beginStaging() and commitStaged(); their pending
+    // writes are staged. Guarded by mutex_.
+    std::unordered_set<std::thread::id> stagingThreads_;
+    // Whether the write waits for its thread's commitStaged(). mutex_ held.
+    bool isStaged(const PendingWrite& write) const;
+    uint64_t flushes_ = 0;
+    uint64_t flushedWrites_ = 0;
+    uint64_t inlineReads_ = 0;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, SlotRef> index_;
+    std::unordered_map<std::string, std::unique_ptr<NamespaceState>> namespaces_;
+    uint64_t nextVersion_ = 0;
+    // Signalled when a namespace's measurement finishes
+    std::condition_variable measuredCondition_;
+
+    std::mutex listenerMutex_;
+    std::unordered_map<std::string, std::vector<std::pair<ListenerId, ChangeListener>>> listeners_;
+    ListenerId nextListenerId_ = 0;
+
+    // Startup hot set, in first-read order
+    std::atomic<bool> recordingStartup_{false};
+    std::mutex startupMutex_;
+    std::vector<std::string> startupKeys_;
+    std::unordered_set<std::string> startupKeySet_;
+
+    // Declared last so it stops before the state its tasks use is destroyed
+    WorkQueue worker_;
+};
+
+} // namespace pure_storage
@@ -0,0 +1,230 @@
+#include "PureStorageTurboModule.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "JSIPureStorageHostObject.h"
+
+namespace pure_storage {
+
+namespace {
+
+using facebook::react::TurboModule;
+
+PureStorageTurboModule& module(TurboModule& turboModule) {
+    return static_cast<PureStorageTurboModule&>(turboModule);
+}
+
+std::string stringArg(jsi::Runtime& runtime, const jsi::Value* args, size_t count, size_t index, const char* method) {
+    if (index >= count || !args[index].isString()) {
+        throw jsi::JSError(runtime, std::string(method) + " expects a string key");
+    }
+    return args[index].getString(runtime).utf8(runtime);
+}
+
+std::vector<std::string> stringArrayArg(jsi::Runtime& runtime, const jsi::Value* args, size_t count, const char* method) {
+    if (count < 1 || !args[0].isObject() || !args[0].getObject(runtime).isArray(runtime)) {
+        throw jsi::JSError(runtime, std::string(method) + " expects an array of keys");
+    }
+
+    jsi::Array array = args[0].getObject(runtime).getArray(runtime);
+    std::vector<std::string> keys(array.size(runtime));
+    for (size_t i = 0; i < keys.size(); i++) {
+        keys[i] = array.getValueAtIndex(runtime, i).asString(runtime).utf8(runtime);
+    }
+    return keys;
+}
+
+jsi::Value itemValue(jsi::Runtime& runtime, bool found, const DecodedItem& item) {
+    if (!found) {
+        return jsi::Value::null();
+    }
+    return makeDecodedItemObject(runtime, item);
+}
+
+// Runs `work` on the engine worker and resolves with the boolean it returns
+template <typename Work>
+jsi::Value runBoolAsync(jsi::Runtime& runtime, PureStorageTurboModule& self, Work work) {
+    return runAsync(runtime, self.engine(), self.jsInvoker_, [work = std::move(work)]() -> AsyncResult {
+        bool result = work();
+        return [result](jsi::Runtime&) { return jsi::Value(result); };
+    });
+}
+
+jsi::Value setItem(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    std::string key = stringArg(runtime, args, count, 0, "setItem");
+    std::string type = count > 1 && args[1].isString() ? args[1].getString(runtime).utf8(runtime) : std::string("null");
+    std::string value = count > 2 && args[2].isString() ? args[2].getString(runtime).utf8(runtime) : std::string();
+    bool encrypted = count > 3 && args[3].isBool() && args[3].getBool();
+
+    auto engine = self.engine();
+    return runBoolAsync(runtime, self, [engine, key = std::move(key), type = std::move(type), value = std::move(value), encrypted] {
+        return engine->setItem(key, type, value, encrypted);
+    });
+}
+
+jsi::Value getItem(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    std::string key = stringArg(runtime, args, count, 0, "getItem");
+
+    auto engine = self.engine();
+    return runAsync(runtime, engine, self.jsInvoker_, [engine, key = std::move(key)]() -> AsyncResult {
+        auto item = std::make_shared<DecodedItem>();
+        bool found = readDecodedItem(*engine, key, *item);
+        return [found, item](jsi::Runtime& runtime) { return itemValue(runtime, found, *item); };
+    });
+}
+
+jsi::Value removeItem(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    std::string key = stringArg(runtime, args, count, 0, "removeItem");
+
+    auto engine = self.engine();
+    return runBoolAsync(runtime, self, [engine, key = std::move(key)] {
+        return engine->removeItem(key);
+    });
+}
+
+jsi::Value hasKey(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    std::string key = stringArg(runtime, args, count, 0, "hasKey");
+
+    auto engine = self.engine();
+    return runBoolAsync(runtime, self, [engine, key = std::move(key)] {
+        return engine->hasKey(key);
+    });
+}
+
+jsi::Value clear(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    auto engine = self.engine();
+    return runBoolAsync(runtime, self, [engine] {
+        return engine->clear();
+    });
+}
+
+jsi::Value getAllKeys(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    auto engine = self.engine();
+    return runAsync(runtime, engine, self.jsInvoker_, [engine]() -> AsyncResult {
+        auto keys = std::make_shared<std::vector<std::string>>(engine->getAllKeys());
+        return [keys](jsi::Runtime& runtime) -> jsi::Value {
+            jsi::Array result(runtime, keys->size());
+            for (size_t i = 0; i < keys->size(); i++) {
+                result.setValueAtIndex(runtime, i, jsi::String::createFromUtf8(runtime, (*keys)[i]));
+            }
+            return result;
+        };
+    });
+}
+
+jsi::Value multiSet(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    if (count < 1 || !args[0].isObject() || !args[0].getObject(runtime).isArray(runtime)) {
+        throw jsi::JSError(runtime, "multiSet expects an array of [key, type, value] entries");
+    }
+
+    struct Entry {
+        std::string key;
+        std::string type;
+        std::string value;
+    };
+
+    jsi::Array array = args[0].getObject(runtime).getArray(runtime);
+    std::vector<Entry> entries(array.size(runtime));
+    for (size_t i = 0; i < entries.size(); i++) {
+        jsi::Array entry = array.getValueAtIndex(runtime, i).asObject(runtime).asArray(runtime);
+        if (entry.size(runtime) < 3) {
+            throw jsi::JSError(runtime, "multiSet entries must be [key, type, value]");
+        }
+        entries[i].key = entry.getValueAtIndex(runtime, 0).asString(runtime).utf8(runtime);
+        entries[i].type = entry.getValueAtIndex(runtime, 1).asString(runtime).utf8(runtime);
+        jsi::Value value = entry.getValueAtIndex(runtime, 2);
+        entries[i].value = value.isString() ? value.getString(runtime).utf8(runtime) : std::string();
+    }
+    bool encrypted = count > 1 && args[1].isBool() && args[1].getBool();
+
+    auto engine = self.engine();
+    return runBoolAsync(runtime, self, [engine, entries = std::move(entries), encrypted] {
+        bool success = true;
+        for (const auto& entry : entries) {
+            success = engine->setItem(entry.key, entry.type, entry.value, encrypted) && success;
+        }
+        return success;
+    });
+}
+
+jsi::Value multiGet(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    std::vector<std::string> keys = stringArrayArg(runtime, args, count, "multiGet");
+
+    struct Result {
+        std::vector<std::string> keys;
+        std::vector<DecodedItem> items;
+        std::vector<bool> found;
+    };
+
+    auto engine = self.engine();
+    return runAsync(runtime, engine, self.jsInvoker_, [engine, keys = std::move(keys)]() mutable -> AsyncResult {
+        // Already on the worker, so the batch load costs nothing extra
+        engine->prefetch(keys);
+
+        auto result = std::make_shared<Result>();
+        result->items.resize(keys.size());
+        result->found.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            result->found[i] = readDecodedItem(*engine, keys[i], result->items[i]);
+        }
+        result->keys = std::move(keys);
+
+        return [result](jsi::Runtime& runtime) -> jsi::Value {
+            jsi::Object object(runtime);
+            for (size_t i = 0; i < result->keys.size(); i++) {
+                object.setProperty(runtime, jsi::PropNameID::forUtf8(runtime, result->keys[i]),
+                                   itemValue(runtime, result->found[i], result->items[i]));
+            }
+            return object;
+        };
+    });
+}
+
+jsi::Value multiRemove(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    std::vector<std::string> keys = stringArrayArg(runtime, args, count, "multiRemove");
+
+    auto engine = self.engine();
+    return runBoolAsync(runtime, self, [engine, keys = std::move(keys)] {
+        bool success = true;
+        for (const auto& key : keys) {
+            success = engine->removeItem(key) && success;
+        }
+        return success;
+    });
+}
+
+jsi::Value install(jsi::Runtime& runtime, TurboModule& turboModule, const jsi::Value* args, size_t count) {
+    auto& self = module(turboModule);
+    installJSIPureStorage(runtime, self.engine(), self.jsInvoker_);
+    return jsi::Value(true);
+}
+
+} // namespace
+
+PureStorageTurboModule::PureStorageTurboModule(std::shared_ptr<PureStorageEngine> engine,
+                                               std::shared_ptr<facebook::react::CallInvoker> jsInvoker)
+    : TurboModule(kModuleName, std::move(jsInvoker)), engine_(std::move(engine)) {
+    methodMap_["setItem"] = MethodMetadata{4, setItem};
+    methodMap_["getItem"] = MethodMetadata{1, getItem};
+    methodMap_["removeItem"] = MethodMetadata{1, removeItem};
+    methodMap_["hasKey"] = MethodMetadata{1, hasKey};
+    methodMap_["clear"] = MethodMetadata{0, clear};
+    methodMap_["getAllKeys"] = MethodMetadata{0, getAllKeys};
+    methodMap_["multiSet"] = MethodMetadata{2, multiSet};
+    methodMap_["multiGet"] = MethodMetadata{1, multiGet};
+    methodMap_["multiRemove"] = MethodMetadata{1, multiRemove};
+    methodMap_["install"] = MethodMetadata{0, install};
+}
+
+} // namespace pure_storage
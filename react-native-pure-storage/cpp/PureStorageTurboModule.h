@@ -0,0 +1,46 @@
+#pragma once
+
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+#include <ReactCommon/TurboModule.h>
+
+#include <memory>
+
+#include "PureStorageEngine.h"
+
+namespace pure_storage {
+
+namespace jsi = facebook::jsi;
+
+// The async API as a C++ TurboModule on the shared engine, for the New
+// Architecture and bridgeless mode. Arguments are copied out on the JS
+// thread, the engine call runs on its worker and the promise is settled
+// through the CallInvoker, so nothing is marshalled through the bridge.
+//
+//   setItem(key, type, value, encrypted)  -> Promise<boolean>
+//   getItem(key)                          -> Promise<{type, value, parsed?} | null>
+//   removeItem(key), hasKey(key), clear() -> Promise<boolean>
+//   getAllKeys()                          -> Promise<string[]>
+//   multiSet([[key, type, value]], encrypted), multiRemove(keys) -> Promise<boolean>
+//   multiGet(keys)                        -> Promise<{[key]: {type, value, parsed?} | null}>
+//   install()                             -> boolean
+//
+// Large object values come back parsed, as in JSIPureStorage.getItemAsync.
+//
+// install() puts global.JSIPureStorage into the runtime that calls it, which
+// is how the sync API is installed where there's no bridge to reach the
+// runtime through.
+class PureStorageTurboModule : public facebook::react::TurboModule {
+public:
+    static constexpr const char* kModuleName = "PureStorageTurboModule";
+
+    PureStorageTurboModule(std::shared_ptr<PureStorageEngine> engine,
+                           std::shared_ptr<facebook::react::CallInvoker> jsInvoker);
+
+    const std::shared_ptr<PureStorageEngine>& engine() const { return engine_; }
+
+private:
+    std::shared_ptr<PureStorageEngine> engine_;
+};
+
+} // namespace pure_storage
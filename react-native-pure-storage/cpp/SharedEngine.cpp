@@ -0,0 +1,53 @@
+#include "SharedEngine.h"
+
+#include <mutex>
+#include <utility>
+
+namespace pure_storage {
+
+namespace {
+
+// Function statics, so platform code running from static initializers
+// doesn't see them before they're constructed
+struct Registry {
+    std::mutex mutex;
+    BackendOpener opener;
+    std::weak_ptr<PureStorageEngine> engine;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+} // namespace
+
+void setSharedBackendOpener(BackendOpener opener) {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    if (!shared.opener) {
+        shared.opener = std::move(opener);
+    }
+}
+
+std::shared_ptr<PureStorageEngine> sharedEngine() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    std::shared_ptr<PureStorageEngine> engine = shared.engine.lock();
+    if (engine || !shared.opener) {
+        return engine;
+    }
+
+    // Returns right away; the backend is opened on the engine's worker
+    engine = std::make_shared<PureStorageEngine>(shared.opener);
+    shared.engine = engine;
+    return engine;
+}
+
+std::shared_ptr<PureStorageEngine> findSharedEngine() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    return shared.engine.lock();
+}
+
+} // namespace pure_storage
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <memory>
+
+#include "PureStorageEngine.h"
+
+namespace pure_storage {
+
+// The process's engine, shared by the JSI bindings, the TurboModule and the
+// C API so they all see one cache and one set of buffered writes. It lives
+// as long as something holds it and is created again on the next use.
+
+// How the platform opens its backend. Registered once by the platform glue;
+// later registrations are ignored while an opener is set.
+void setSharedBackendOpener(BackendOpener opener);
+
+// The shared engine, created with the registered opener if there isn't one.
+// Null if no opener has been registered.
+std::shared_ptr<PureStorageEngine> sharedEngine();
+
+// The shared engine if something is holding it, without creating one
+std::shared_ptr<PureStorageEngine> findSharedEngine();
+
+} // namespace pure_storage
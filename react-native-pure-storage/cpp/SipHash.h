@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace pure_storage {
+
+// SipHash-2-4: a keyed 64-bit hash that can't be inverted or predicted
+// without the 128-bit key. Used to name records without revealing their keys.
+uint64_t sipHash24(const uint8_t key[16], std::string_view data);
+
+} // namespace pure_storage
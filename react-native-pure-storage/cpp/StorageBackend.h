@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pure_storage {
+
+// A stored value in its serialized form, as produced by serializeValue() in JS
+struct StoredItem {
+    std::string type;
+    std::string value;
+    // Milliseconds since the Unix epoch after which the item reads as missing; 0 never expires
+    int64_t expiresAt = 0;
+    // Set by the engine on every write and kept in the record's header, so
+    // statItem() can answer without the value. Times are milliseconds since
+    // the Unix epoch, 0 for records written before they were kept; size is
+    // valueSize() of the value, -1 for those records.
+    int64_t createdAt = 0;
+    int64_t modifiedAt = 0;
+    int64_t size = -1;
+    // Caller-defined attributes as a JSON object, empty if there are none.
+    // Written in the same record as the value, so the two never disagree,
+    // and returned by statItem() along with the header.
+    std::string attributes;
+};
+
+// Longest attributes a write may carry; they're read with every statItem(),
+// so they're meant for a few small fields, not a second value
+constexpr size_t kMaxAttributesBytes = 4096;
+
+// A record's header: everything about it but the value
+struct ItemStat {
+    std::string type;
+    int64_t size = -1;
+    int64_t createdAt = 0;
+    int64_t modifiedAt = 0;
+    int64_t expiresAt = 0;
+    std::string attributes;
+};
+
+// The size JS sees: decoded bytes for binary values, which are stored as
+// Base64, and the serialized UTF-8 bytes of everything else
+inline int64_t valueSize(const std::string& type, const std::string& value) {
+    if (type != "binary") {
+        return static_cast<int64_t>(value.size());
+    }
+
+    size_t padding = 0;
+    while (padding < 2 && padding < value.size() && value[value.size() - 1 - padding] == '=') {
+        padding++;
+    }
+    return static_cast<int64_t>(value.size() / 4 * 3 + (value.size() % 4) * 3 / 4 - padding);
+}
+
+// A stored item whose strings are owned elsewhere, e.g. by the call's Arena
+struct ItemView {
+    std::string_view type;
+    std::string_view value;
+    std::string_view attributes;
+};
+
+// The bytes of a stored value, owned by whoever produced them and valid for
+// as long as the buffer is held. Writable so it can back a JS ArrayBuffer;
+// writes never reach storage.
+class ValueBuffer {
+public:
+    virtual ~ValueBuffer() = default;
+
+    virtual uint8_t* data() = 0;
+    virtual size_t size() const = 0;
+};
+
+// Passed to the platform modules as an int, so keep the values in sync with them
+enum class Durability {
+    // Whatever the platform does for a plain write: Android commits,
+    // iOS leaves flushing to NSUserDefaults
+    Default,
+    // Written to disk before setItem() returns
+    Sync,
+    // May be flushed after setItem() returns; the engine buffers these
+    // writes itself and group-commits them
+    Async,
+};
+
+struct WriteOptions {
+    bool encrypted = false;
+    // Namespace whose data key encrypts the value; empty uses the legacy global key
+    std::string keyNamespace;
+    // Store the value deflated when that makes it smaller
+    bool compressed = false;
+    Durability durability = Durability::Default;
+};
+
+// Platform storage the engine reads from and writes through to.
+// Android implements this on top of SharedPreferences, iOS on NSUserDefaults.
+// Keys are passed without the RNPureStorage_ prefix.
+class StorageBackend {
+public:
+    virtual ~StorageBackend() = default;
+
+    virtual bool setItem(const std::string& key, const StoredItem& item, const WriteOptions& options) = 0;
+    // Returns the decrypted, decompressed item, including expired ones
+    virtual bool getItem(const std::string& key, StoredItem& item) = 0;
+    virtual bool removeItem(const std::string& key) = 0;
+    virtual bool clear() = 0;
+    virtual std::vector<std::string> getAllKeys() = 0;
+    virtual bool hasKey(const std::string& key) = 0;
+
+    // Keys starting with `prefix`, in no particular order. The default
+    // filters getAllKeys(); backends that index keys by namespace override it.
+    virtual std::vector<std::string> keysWithPrefix(const std::string& prefix) {
+        std::vector<std::string> keys = getAllKeys();
+        keys.erase(
+            std::remove_if(keys.begin(), keys.end(), [&prefix](const std::string& key) {
+                return key.compare(0, prefix.size(), prefix) != 0;
+            }),
+            keys.end()
+        );
+        return keys;
+    }
+
+    // Destroy a namespace's data key, leaving the values encrypted with it
+    // unreadable. Records that can't be decrypted read as missing.
+    virtual bool shredNamespace(const std::string& name) = 0;
+
+    // 16 secret bytes for hashing the namespace's key names, derived from its
+    // data key (so shredding changes them too). Empty if unavailable.
+    virtual std::string getKeyHashSecret(const std::string& name) = 0;
+
+    // The stored bytes of an unencrypted, uncompressed value, without copying
+    // them; `item` gets the type and expiry but no value. Null when the
+    // backend can't hand out its storage, in which case callers read a copy.
+    virtual std::shared_ptr<ValueBuffer> mapItem(const std::string& /*key*/, StoredItem& /*item*/) { return nullptr; }
+
+    // The record's header without its value. The default reads the whole
+    // item; backends that can read just the header override it.
+    virtual bool statItem(const std::string& key, ItemStat& stat) {
+        StoredItem item;
+        if (!getItem(key, item)) {
+            return false;
+        }
+        stat.type = std::move(item.type);
+        stat.size = item.size;
+        stat.createdAt = item.createdAt;
+        stat.modifiedAt = item.modifiedAt;
+        stat.expiresAt = item.expiresAt;
+        stat.attributes = std::move(item.attributes);
+        return true;
+    }
+
+    // The keys are about to be read; a backend may start loading them
+    virtual void willNeed(const std::vector<std::string>& /*keys*/) {}
+
+    // Writes made between beginBatch() and commitBatch() on the same thread
+    // may be held back and persisted together by commitBatch()
+    virtual void beginBatch() {}
+    virtual bool commitBatch() { return true; }
+
+    // Keys read shortly after the previous launch, kept outside the user's
+    // keyspace so they never show up in getAllKeys() or get cleared with it
+    virtual std::vector<std::string> getStartupKeys() { return {}; }
+    virtual void setStartupKeys(const std::vector<std::string>& /*keys*/) {}
+};
+
+} // namespace pure_storage
@@ -0,0 +1,100 @@
+#include "WorkQueue.h"
+
+namespace pure_storage {
+
+WorkQueue::WorkQueue() : state_(std::make_shared<State>()) {}
+
+WorkQueue::~WorkQueue() {
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->stopping = true;
+    }
+    state_->condition.notify_all();
+
+    if (!thread_.joinable()) {
+        return;
+    }
+
+    if (thread_.get_id() == std::this_thread::get_id()) {
+        thread_.detach();
+    } else {
+        thread_.join();
+    }
+}
+
+void WorkQueue::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->stopping) {
+            return;
+        }
+
+        state_->tasks.push_back(std::move(task));
+        start();
+    }
+    state_->condition.notify_one();
+}
+
+void WorkQueue::enqueueAfter(std::chrono::milliseconds delay, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->stopping) {
+            return;
+        }
+
+        state_->delayed.emplace(std::chrono::steady_clock::now() + delay, std::move(task));
+        start();
+    }
+    state_->condition.notify_one();
+}
+
+bool WorkQueue::isCurrentThread() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return thread_.joinable() && thread_.get_id() == std::this_thread::get_id();
+}
+
+// Called with the state mutex held
+void WorkQueue::start() {
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&WorkQueue::run, state_);
+    }
+}
+
+void WorkQueue::run(std::shared_ptr<State> state) {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            for (;;) {
+                // Pending tasks are dropped on shutdown
+                if (state->stopping) {
+                    return;
+                }
+
+                // Move due delayed tasks behind the ones already queued
+                auto now = std::chrono::steady_clock::now();
+                while (!state->delayed.empty() && state->delayed.begin()->first <= now) {
+                    state->tasks.push_back(std::move(state->delayed.begin()->second));
+                    state->delayed.erase(state->delayed.begin());
+                }
+
+                if (!state->tasks.empty()) {
+                    break;
+                }
+
+                if (state->delayed.empty()) {
+                    state->condition.wait(lock);
+                } else {
+                    state->condition.wait_until(lock, state->delayed.begin()->first);
+                }
+            }
+
+            task = std::move(state->tasks.front());
+            state->tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+} // namespace pure_storage
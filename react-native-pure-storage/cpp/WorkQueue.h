@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace pure_storage {
+
+// A single background thread running tasks in the order they were queued.
+// The thread is started on the first enqueue() so idle engines don't own one.
+class WorkQueue {
+public:
+    WorkQueue();
+    ~WorkQueue();
+
+    WorkQueue(const WorkQueue&) = delete;
+    WorkQueue& operator=(const WorkQueue&) = delete;
+
+    void enqueue(std::function<void()> task);
+
+    // Run a task once the delay has passed. Queued tasks that are due run in
+    // deadline order; a delayed task never runs ahead of earlier enqueue() calls.
+    void enqueueAfter(std::chrono::milliseconds delay, std::function<void()> task);
+
+    // Whether the caller is one of this queue's tasks
+    bool isCurrentThread();
+
+private:
+    // Owned jointly with the thread, which may outlive the queue when one of
+    // its own tasks drops the last reference to the queue's owner
+    struct State {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::function<void()>> tasks;
+        std::multimap<std::chrono::steady_clock::time_point, std::function<void()>> delayed;
+        bool stopping = false;
+    };
+
+    void start();
+    static void run(std::shared_ptr<State> state);
+
+    std::shared_ptr<State> state_;
+    std::thread thread_;
+};
+
+} // namespace pure_storage
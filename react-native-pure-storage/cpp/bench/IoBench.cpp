@@ -0,0 +1,395 @@
+// Throughput of the I/O backends LogStorageBackend can run on: pread/pwrite
+// driven from several threads against io_uring batches from one thread, the
+// latency of synced writes, the page faults of a mapped scan with and
+// without access hints, and compaction's write amplification with and
+// without hot/cold separation.
+// Build and run with scripts/bench-io.sh.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "IoBackend.h"
+#include "LogStorageBackend.h"
+
+using namespace pure_storage;
+
+namespace {
+
+constexpr size_t kBlockSize = 4096;
+constexpr size_t kFileBytes = 64 * 1024 * 1024;
+constexpr size_t kBatchSize = 32;
+
+double seconds(const std::function<void()>& run) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* test, const std::string& backend, size_t operations, double elapsed,
+            size_t bytesPerOperation = kBlockSize) {
+    std::printf("%-28s %-18s %10.0f ops/s %9.1f MB/s\n", test, backend.c_str(),
+        operations / elapsed, operations * bytesPerOperation / elapsed / (1024 * 1024));
+}
+
+// Drop the file from the page cache so reads reach the device
+void dropCache(int fd) {
+    fdatasync(fd);
+#ifdef POSIX_FADV_DONTNEED
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+}
+
+std::vector<uint64_t> randomOffsets(size_t count) {
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<uint64_t> block(0, kFileBytes / kBlockSize - 1);
+    std::vector<uint64_t> offsets(count);
+    for (auto& offset : offsets) {
+        offset = block(random) * kBlockSize;
+    }
+    return offsets;
+}
+
+// Random block reads: `threads` callers each reading `batch` blocks per call
+void benchReads(IoBackend& io, int fd, size_t reads, int threads, size_t batch) {
+    std::vector<uint64_t> offsets = randomOffsets(reads);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failed{0};
+    dropCache(fd);
+
+    double elapsed = seconds([&] {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&] {
+                std::vector<char> buffers(batch * kBlockSize);
+                std::vector<IoRequest> requests;
+                for (;;) {
+                    size_t start = next.fetch_add(batch);
+                    if (start >= reads) {
+                        return;
+                    }
+
+                    requests.assign(std::min(batch, reads - start), IoRequest());
+                    for (size_t i = 0; i < requests.size(); i++) {
+                        requests[i].fd = fd;
+                        requests[i].data = &buffers[i * kBlockSize];
+                        requests[i].size = kBlockSize;
+                        requests[i].offset = offsets[start + i];
+                    }
+                    io.read(requests);
+                    for (const auto& request : requests) {
+                        failed += request.result != static_cast<ssize_t>(kBlockSize);
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    });
+
+    std::string label = std::string(io.name()) + " x" + std::to_string(threads) + " b" + std::to_string(batch);
+    report("random 4K reads", label, reads - failed, elapsed);
+}
+
+// Appends to several segment files, each round made durable: one fdatasync
+// per file, issued one by one on posix and together on io_uring
+void benchSyncedAppends(IoBackend& io, const std::string& directory, size_t files, size_t rounds) {
+    std::vector<int> fds;
+    for (size_t i = 0; i < files; i++) {
+        std::string path = directory + "/append-" + std::to_string(i) + ".bench";
+        fds.push_back(open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600));
+        unlink(path.c_str());
+    }
+
+    std::vector<char> block(kBlockSize, 'a');
+    double elapsed = seconds([&] {
+        std::vector<IoRequest> requests(files * 4);
+        for (size_t round = 0; round < rounds; round++) {
+            for (size_t i = 0; i < requests.size(); i++) {
+                requests[i].fd = fds[i % files];
+                requests[i].data = block.data();
+                requests[i].size = kBlockSize;
+                requests[i].offset = (round * 4 + i / files) * kBlockSize;
+            }
+            io.write(requests, true);
+        }
+    });
+    report("synced appends", std::string(io.name()) + " " + std::to_string(files) + " files",
+        rounds * files * 4, elapsed);
+
+    for (int fd : fds) {
+        close(fd);
+    }
+}
+
+// Engine-shaped load: group-committed batches of small records, then point reads
+void benchLog(IoBackendKind kind, const std::string& directory, size_t records) {
+    std::string path = directory + "/log.bench";
+    std::string command = "rm -rf '" + path + "'";
+    if (std::system(command.c_str()) != 0) {
+        return;
+    }
+
+    LogStorageOptions options;
+    options.io = kind;
+    std::unique_ptr<LogStorageBackend> log;
+    try {
+        log.reset(new LogStorageBackend(path, options));
+    } catch (const std::exception& error) {
+        std::printf("%-28s %s\n", "log", error.what());
+        return;
+    }
+
+    StoredItem item;
+    item.type = "string";
+    item.value = std::string(200, 'v');
+    WriteOptions writeOptions;
+    double writeTime = seconds([&] {
+        for (size_t i = 0; i < records; i += 100) {
+            log->beginBatch();
+            for (size_t j = i; j < i + 100 && j < records; j++) {
+                log->setItem("bench:" + std::to_string(j), item, writeOptions);
+            }
+            log->commitBatch();
+        }
+    });
+    report("log batched setItem", log->ioBackendName(), records, writeTime, item.value.size());
+
+    StoredItem read;
+    double readTime = seconds([&] {
+        for (size_t i = 0; i < records; i++) {
+            log->getItem("bench:" + std::to_string((i * 7919) % records), read);
+        }
+    });
+    report("log getItem", log->ioBackendName(), records, readTime, item.value.size());
+
+    log.reset();
+    if (std::system(command.c_str()) != 0) {
+        std::printf("couldn't remove %s\n", path.c_str());
+    }
+}
+
+// Durability cost: one Sync-mode setItem at a time, each waiting for its
+// data sync, into segments that are preallocated or grown by every write
+void benchSyncedSetItem(const std::string& directory, size_t records, uint64_t preallocateBytes) {
+    std::string path = directory + "/sync.bench";
+    std::string command = "rm -rf '" + path + "'";
+    if (std::system(command.c_str()) != 0) {
+        return;
+    }
+
+    LogStorageOptions options;
+    options.io = IoBackendKind::Posix;
+    options.preallocateBytes = preallocateBytes;
+    std::unique_ptr<LogStorageBackend> log(new LogStorageBackend(path, options));
+
+    StoredItem item;
+    item.type = "string";
+    item.value = std::string(200, 'v');
+    WriteOptions writeOptions;
+    writeOptions.durability = Durability::Sync;
+    double elapsed = seconds([&] {
+        for (size_t i = 0; i < records; i++) {
+            log->setItem("sync:" + std::to_string(i), item, writeOptions);
+        }
+    });
+
+    report("log synced setItem", preallocateBytes > 0 ? "preallocated" : "growing", records, elapsed, item.value.size());
+    std::printf("%-28s %-18s %10.1f us per write\n", "", "", elapsed / records * 1e6);
+
+    log.reset();
+    if (std::system(command.c_str()) != 0) {
+        std::printf("couldn't remove %s\n", path.c_str());
+    }
+}
+
+// Drop a log's segment files from the page cache by name, so the next scan
+// has to fault its pages in from the device
+void dropLogCache(const std::string& path) {
+    for (unsigned id = 1;; id++) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/%08u.seg", id);
+        int fd = open((path + name).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        dropCache(fd);
+        close(fd);
+    }
+}
+
+// Reads every value through mapItem() from a cold page cache, with the
+// madvise/fadvise hints on and off, reporting the faults the scan took
+void benchMappedScan(const std::string& directory, size_t records, bool advise) {
+    std::string path = directory + "/scan.bench";
+    std::string command = "rm -rf '" + path + "'";
+    if (std::system(command.c_str()) != 0) {
+        return;
+    }
+
+    LogStorageOptions options;
+    options.io = IoBackendKind::Posix;
+    options.adviseRandom = advise;
+    options.adviseSequential = advise;
+    options.adviseWillNeed = advise;
+    options.adviseDontNeed = advise;
+
+    std::vector<std::string> keys;
+    {
+        LogStorageBackend log(path, options);
+        StoredItem item;
+        item.type = "string";
+        item.value = std::string(kBlockSize, 'v');
+        WriteOptions writeOptions;
+        log.beginBatch();
+        for (size_t i = 0; i < records; i++) {
+            keys.push_back("scan:" + std::to_string(i));
+            log.setItem(keys.back(), item, writeOptions);
+        }
+        log.commitBatch();
+    }
+
+    // Opening replays the segments, which caches them again
+    LogStorageBackend log(path, options);
+    dropLogCache(path);
+
+    LogStorageStats before = log.stats();
+    size_t bytes = 0;
+    double elapsed = seconds([&] {
+        log.willNeed(keys);
+        StoredItem item;
+        for (const auto& key : keys) {
+            if (std::shared_ptr<ValueBuffer> value = log.mapItem(key, item)) {
+                // Touch every page, as a scan handing values to JS would
+                for (size_t offset = 0; offset < value->size(); offset += 512) {
+                    bytes += value->data()[offset];
+                }
+            }
+        }
+    });
+    LogStorageStats after = log.stats();
+
+    report("log mapped scan", advise ? "hints" : "no hints", records, elapsed);
+    std::printf("%-28s %-18s %10llu minor %8llu major faults\n", "", "",
+        static_cast<unsigned long long>(after.minorFaults - before.minorFaults),
+        static_cast<unsigned long long>(after.majorFaults - before.majorFaults));
+
+    if (bytes == 0 || std::system(command.c_str()) != 0) {
+        std::printf("couldn't scan or remove %s\n", path.c_str());
+    }
+}
+
+// A skewed workload: most keys written once, a few rewritten all the time,
+// compacting as it goes. Reports bytes written per byte of record written
+// by the caller, with hot/cold separation on or off (hotUpdates 0).
+void benchCompaction(const std::string& directory, size_t records, uint32_t hotUpdates) {
+    std::string path = directory + "/compact.bench";
+    std::string command = "rm -rf '" + path + "'";
+    if (std::system(command.c_str()) != 0) {
+        return;
+    }
+
+    LogStorageOptions options;
+    options.io = IoBackendKind::Posix;
+    options.segmentBytes = 256 * 1024;
+    options.hotUpdates = hotUpdates;
+    std::unique_ptr<LogStorageBackend> log(new LogStorageBackend(path, options));
+
+    StoredItem item;
+    item.type = "string";
+    item.value = std::string(200, 'v');
+    WriteOptions writeOptions;
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<size_t> hotKey(0, 99);
+    size_t compacted = 0;
+    double elapsed = seconds([&] {
+        for (size_t i = 0; i < records; i += 100) {
+            log->beginBatch();
+            for (size_t j = i; j < i + 100 && j < records; j++) {
+                // One write in ten adds a key; the rest rewrite one of 100
+                std::string key = j % 10 == 0 ? "cold:" + std::to_string(j) : "hot:" + std::to_string(hotKey(random));
+                log->setItem(key, item, writeOptions);
+            }
+            log->commitBatch();
+            if (i % 5000 == 0) {
+                compacted += log->compact();
+            }
+        }
+    });
+
+    LogStorageStats stats = log->stats();
+    report("log compacting setItem", hotUpdates > 0 ? "hot/cold" : "one stream", records, elapsed, item.value.size());
+    std::printf("%-28s %-18s %10.2f write amplification, %zu segments compacted\n", "", "",
+        static_cast<double>(stats.appendedBytes + stats.compactedBytes) / stats.appendedBytes, compacted);
+
+    log.reset();
+    if (std::system(command.c_str()) != 0) {
+        std::printf("couldn't remove %s\n", path.c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string directory = argc > 1 ? argv[1] : "/tmp";
+    size_t reads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+
+    std::unique_ptr<IoBackend> posix = makePosixIoBackend();
+    std::unique_ptr<IoBackend> uring = makeIoUringBackend(256);
+    if (!uring) {
+        std::printf("io_uring is not available here; only the posix backend is measured\n");
+    }
+
+    std::string path = directory + "/reads.bench";
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::perror(path.c_str());
+        return 1;
+    }
+    unlink(path.c_str());
+
+    std::vector<char> chunk(1024 * 1024, 'x');
+    for (size_t offset = 0; offset < kFileBytes; offset += chunk.size()) {
+        posix->writeAt(fd, chunk.data(), chunk.size(), offset, false);
+    }
+
+    benchReads(*posix, fd, reads, 1, 1);
+    benchReads(*posix, fd, reads, 4, 1);
+    if (uring) {
+        benchReads(*uring, fd, reads, 1, kBatchSize);
+        benchReads(*uring, fd, reads, 4, kBatchSize);
+    }
+    close(fd);
+
+    benchSyncedAppends(*posix, directory, 4, 200);
+    if (uring) {
+        benchSyncedAppends(*uring, directory, 4, 200);
+    }
+
+    benchLog(IoBackendKind::Posix, directory, 20000);
+    if (uring) {
+        benchLog(IoBackendKind::IoUring, directory, 20000);
+    }
+
+    benchSyncedSetItem(directory, 2000, 0);
+    benchSyncedSetItem(directory, 2000, LogStorageOptions().preallocateBytes);
+
+    benchMappedScan(directory, 20000, false);
+    benchMappedScan(directory, 20000, true);
+
+    benchCompaction(directory, 200000, 0);
+    benchCompaction(directory, 200000, LogStorageOptions().hotUpdates);
+    return 0;
+}
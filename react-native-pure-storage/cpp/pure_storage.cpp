@@ -0,0 +1,315 @@
+#include "pure_storage.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "PureStorageEngine.h"
+#include "SharedEngine.h"
+
+struct pure_storage_db {
+    std::shared_ptr<pure_storage::PureStorageEngine> engine;
+};
+
+struct pure_storage_txn {
+    struct Write {
+        std::string key;
+        bool remove = false;
+        std::string type;
+        std::string data;
+        bool encrypted = false;
+    };
+
+    std::shared_ptr<pure_storage::PureStorageEngine> engine;
+    std::vector<Write> writes;
+};
+
+namespace {
+
+using pure_storage::ItemStat;
+using pure_storage::StoredItem;
+
+// Returned values own their strings: one allocation holding the struct and
+// each string, NUL-terminated for callers that want C strings
+pure_storage_value* allocateValue(const std::string& type, const std::string* data, const std::string& attributes) {
+    size_t dataLen = data ? data->size() : 0;
+    size_t bytes = sizeof(pure_storage_value) + type.size() + 1 + (data ? dataLen + 1 : 0) + attributes.size() + 1;
+    auto* value = static_cast<pure_storage_value*>(std::calloc(1, bytes));
+    if (!value) {
+        return nullptr;
+    }
+
+    char* cursor = reinterpret_cast<char*>(value + 1);
+    auto place = [&cursor](const std::string& text) {
+        char* start = cursor;
+        std::memcpy(cursor, text.data(), text.size());
+        cursor += text.size() + 1;
+        return start;
+    };
+
+    value->type = place(type);
+    value->type_len = type.size();
+    if (data) {
+        value->data = place(*data);
+        value->data_len = dataLen;
+    }
+    if (!attributes.empty()) {
+        value->attributes = place(attributes);
+        value->attributes_len = attributes.size();
+    }
+    value->size = -1;
+    return value;
+}
+
+pure_storage_value* makeValue(const StoredItem& item) {
+    pure_storage_value* value = allocateValue(item.type, &item.value, item.attributes);
+    if (value) {
+        value->size = item.size >= 0 ? item.size : pure_storage::valueSize(item.type, item.value);
+        value->created_at = item.createdAt;
+        value->modified_at = item.modifiedAt;
+        value->expires_at = item.expiresAt;
+    }
+    return value;
+}
+
+// Header-only values live on the stack for the length of the callback
+pure_storage_value headerValue(const ItemStat& stat) {
+    pure_storage_value value = {};
+    value.type = stat.type.c_str();
+    value.type_len = stat.type.size();
+    if (!stat.attributes.empty()) {
+        value.attributes = stat.attributes.c_str();
+        value.attributes_len = stat.attributes.size();
+    }
+    value.size = stat.size;
+    value.created_at = stat.createdAt;
+    value.modified_at = stat.modifiedAt;
+    value.expires_at = stat.expiresAt;
+    return value;
+}
+
+bool validText(const char* text, size_t length) {
+    return text != nullptr || length == 0;
+}
+
+// Engine calls may throw (e.g. a hideKeys namespace without its secret); none of that crosses the C boundary
+template <typename Body>
+pure_storage_status guarded(Body body) {
+    try {
+        return body();
+    } catch (const std::exception&) {
+        return PURE_STORAGE_FAILED;
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+pure_storage_status pure_storage_open(pure_storage_db** out) {
+    if (!out) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+    *out = nullptr;
+
+    return guarded([out] {
+        std::shared_ptr<pure_storage::PureStorageEngine> engine = pure_storage::sharedEngine();
+        if (!engine) {
+            return PURE_STORAGE_UNAVAILABLE;
+        }
+        *out = new pure_storage_db{std::move(engine)};
+        return PURE_STORAGE_OK;
+    });
+}
+
+void pure_storage_close(pure_storage_db* storage) {
+    delete storage;
+}
+
+pure_storage_status pure_storage_get(pure_storage_db* storage, const char* key, size_t key_len, pure_storage_value** out) {
+    if (!storage || !out || !validText(key, key_len)) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+    *out = nullptr;
+
+    return guarded([&] {
+        StoredItem item;
+        if (!storage->engine->getItem(std::string(key, key_len), item)) {
+            return PURE_STORAGE_NOT_FOUND;
+        }
+        *out = makeValue(item);
+        return *out ? PURE_STORAGE_OK : PURE_STORAGE_FAILED;
+    });
+}
+
+void pure_storage_value_free(pure_storage_value* value) {
+    std::free(value);
+}
+
+pure_storage_status pure_storage_put(pure_storage_db* storage, const char* key, size_t key_len,
+                                     const char* type, const char* data, size_t data_len, int flags) {
+    if (!storage || !validText(key, key_len) || !type || !validText(data, data_len)) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+
+    return guarded([&] {
+        bool written = storage->engine->setItem(std::string(key, key_len), type, std::string(data, data_len),
+                                                (flags & PURE_STORAGE_ENCRYPTED) != 0);
+        return written ? PURE_STORAGE_OK : PURE_STORAGE_FAILED;
+    });
+}
+
+pure_storage_status pure_storage_remove(pure_storage_db* storage, const char* key, size_t key_len) {
+    if (!storage || !validText(key, key_len)) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+
+    return guarded([&] {
+        return storage->engine->removeItem(std::string(key, key_len)) ? PURE_STORAGE_OK : PURE_STORAGE_FAILED;
+    });
+}
+
+pure_storage_status pure_storage_scan(pure_storage_db* storage, const char* prefix, size_t prefix_len,
+                                      int flags, pure_storage_scan_fn fn, void* context) {
+    if (!storage || !fn || !validText(prefix, prefix_len)) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+
+    return guarded([&] {
+        auto& engine = *storage->engine;
+        std::vector<std::string> keys = engine.keysWithPrefix(std::string(prefix, prefix_len));
+        bool headersOnly = (flags & PURE_STORAGE_SCAN_HEADERS_ONLY) != 0;
+        if (!headersOnly) {
+            // One batch load instead of a backend read per key
+            engine.prefetch(keys);
+        }
+
+        for (const auto& key : keys) {
+            // Keys removed since they were listed are skipped
+            if (headersOnly) {
+                ItemStat stat;
+                if (!engine.stat(key, stat)) {
+                    continue;
+                }
+                pure_storage_value value = headerValue(stat);
+                if (fn(context, key.data(), key.size(), &value)) {
+                    break;
+                }
+                continue;
+            }
+
+            StoredItem item;
+            if (!engine.getItem(key, item)) {
+                continue;
+            }
+            std::unique_ptr<pure_storage_value, void (*)(pure_storage_value*)> value(makeValue(item), pure_storage_value_free);
+            if (!value) {
+                return PURE_STORAGE_FAILED;
+            }
+            if (fn(context, key.data(), key.size(), value.get())) {
+                break;
+            }
+        }
+        return PURE_STORAGE_OK;
+    });
+}
+
+pure_storage_status pure_storage_txn_begin(pure_storage_db* storage, pure_storage_txn** out) {
+    if (!storage || !out) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+    *out = new pure_storage_txn{storage->engine, {}};
+    return PURE_STORAGE_OK;
+}
+
+pure_storage_status pure_storage_txn_put(pure_storage_txn* txn, const char* key, size_t key_len,
+                                         const char* type, const char* data, size_t data_len, int flags) {
+    if (!txn || !validText(key, key_len) || !type || !validText(data, data_len)) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+
+    pure_storage_txn::Write write;
+    write.key.assign(key, key_len);
+    write.type = type;
+    write.data.assign(data, data_len);
+    write.encrypted = (flags & PURE_STORAGE_ENCRYPTED) != 0;
+    txn->writes.push_back(std::move(write));
+    return PURE_STORAGE_OK;
+}
+
+pure_storage_status pure_storage_txn_remove(pure_storage_txn* txn, const char* key, size_t key_len) {
+    if (!txn || !validText(key, key_len)) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+
+    pure_storage_txn::Write write;
+    write.key.assign(key, key_len);
+    write.remove = true;
+    txn->writes.push_back(std::move(write));
+    return PURE_STORAGE_OK;
+}
+
+pure_storage_status pure_storage_txn_commit(pure_storage_txn* txn) {
+    if (!txn) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+    std::unique_ptr<pure_storage_txn> owned(txn);
+    auto& engine = *txn->engine;
+
+    return guarded([&] {
+        // Storage batches this thread's writes into one commit; a JS task
+        // batching its own writes meanwhile is left alone
+        bool success = true;
+        engine.beginBatch();
+        try {
+            for (const auto& write : txn->writes) {
+                bool applied = write.remove
+                    ? engine.removeItem(write.key)
+                    : engine.setItem(write.key, write.type, write.data, write.encrypted);
+                success = applied && success;
+            }
+        } catch (...) {
+            engine.commitBatch();
+            throw;
+        }
+
+        bool committed = engine.commitBatch();
+        bool buffered = false;
+        for (const auto& write : txn->writes) {
+            // The cache took values storage never got; reads go back to storage
+            if (!committed && !engine.isBuffered(write.key)) {
+                engine.invalidate(write.key);
+            }
+            buffered = buffered || engine.isBuffered(write.key);
+        }
+
+        // Writes to async namespaces were buffered by the engine instead
+        if (buffered) {
+            engine.flush();
+            for (const auto& write : txn->writes) {
+                success = success && !engine.isBuffered(write.key);
+            }
+        }
+        return success && committed ? PURE_STORAGE_OK : PURE_STORAGE_FAILED;
+    });
+}
+
+void pure_storage_txn_abort(pure_storage_txn* txn) {
+    delete txn;
+}
+
+pure_storage_status pure_storage_flush(pure_storage_db* storage) {
+    if (!storage) {
+        return PURE_STORAGE_INVALID_ARGUMENT;
+    }
+
+    return guarded([storage] {
+        return storage->engine->flush() == 0 ? PURE_STORAGE_OK : PURE_STORAGE_FAILED;
+    });
+}
+
+} // extern "C"
@@ -0,0 +1,127 @@
+/*
+ * pure_storage.h - C API to the PureStorage native engine
+ *
+ * For native code that needs the store without JS: other native modules,
+ * Android WorkManager jobs, iOS background tasks. Every handle works on the
+ * same engine as the JS API when both are in one process, so writes made
+ * here are seen by JS right away (and fire its change listeners), and the
+ * other way round.
+ *
+ * Values are stored the way the JS API stores them: a type ("string",
+ * "number", "boolean", "object", "binary" or "null") and its serialized
+ * text (JSON for objects, Base64 for binary).
+ *
+ * Android: call JSIPureStorageModule.prepareNativeAccess(context) once
+ * before pure_storage_open() in processes where React hasn't started, and
+ * link against libJSIPureStorage.so. iOS needs no setup.
+ *
+ * All functions are thread-safe. Keys and values are UTF-8 and passed with
+ * their length, so they needn't be NUL-terminated.
+ */
+
+#ifndef PURE_STORAGE_H
+#define PURE_STORAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PURE_STORAGE_EXPORT __attribute__((visibility("default")))
+#else
+#define PURE_STORAGE_EXPORT
+#endif
+
+/* Bumped when a function is added; existing ones keep their signatures */
+#define PURE_STORAGE_API_VERSION 1
+
+typedef enum pure_storage_status {
+    PURE_STORAGE_OK = 0,
+    PURE_STORAGE_NOT_FOUND = 1,
+    /* No engine and nothing registered to open one (see above) */
+    PURE_STORAGE_UNAVAILABLE = 2,
+    PURE_STORAGE_INVALID_ARGUMENT = 3,
+    /* Storage failed, or the write broke a namespace quota or size limit */
+    PURE_STORAGE_FAILED = 4
+} pure_storage_status;
+
+/* Flags for pure_storage_put() and pure_storage_txn_put() */
+#define PURE_STORAGE_ENCRYPTED 0x1
+
+/* Flags for pure_storage_scan() */
+/* Only read record headers: values have data == NULL */
+#define PURE_STORAGE_SCAN_HEADERS_ONLY 0x1
+
+typedef struct pure_storage_db pure_storage_db;
+typedef struct pure_storage_txn pure_storage_txn;
+
+typedef struct pure_storage_value {
+    const char *type;
+    size_t type_len;
+    /* The serialized value; NULL for header-only scans */
+    const char *data;
+    size_t data_len;
+    /* JSON object stored with the value, or NULL */
+    const char *attributes;
+    size_t attributes_len;
+    /* Decoded size, e.g. bytes of a binary value; -1 if unknown */
+    int64_t size;
+    /* Milliseconds since the epoch; 0 if unknown or never */
+    int64_t created_at;
+    int64_t modified_at;
+    int64_t expires_at;
+} pure_storage_value;
+
+/* Returns nonzero to stop the scan */
+typedef int (*pure_storage_scan_fn)(void *context, const char *key, size_t key_len,
+                                    const pure_storage_value *value);
+
+/*
+ * A handle on the process's engine, opening it if nothing has. The engine
+ * stays open until the last handle (or JS) lets go of it, which writes out
+ * anything still buffered.
+ */
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_open(pure_storage_db **out);
+PURE_STORAGE_EXPORT void pure_storage_close(pure_storage_db *storage);
+
+/* *out is freed with pure_storage_value_free() */
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_get(pure_storage_db *storage, const char *key, size_t key_len,
+                                                         pure_storage_value **out);
+PURE_STORAGE_EXPORT void pure_storage_value_free(pure_storage_value *value);
+
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_put(pure_storage_db *storage, const char *key, size_t key_len,
+                                                         const char *type, const char *data, size_t data_len,
+                                                         int flags);
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_remove(pure_storage_db *storage, const char *key, size_t key_len);
+
+/* Calls fn for every key starting with the prefix, in key order */
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_scan(pure_storage_db *storage, const char *prefix, size_t prefix_len,
+                                                          int flags, pure_storage_scan_fn fn, void *context);
+
+/*
+ * Writes collected on the caller's side and applied together on commit,
+ * as one group commit. Not isolated, and not atomic: a write rejected by a
+ * quota fails the commit without undoing the others. The commit only
+ * returns PURE_STORAGE_OK once every write is in storage, including writes
+ * to namespaces that buffer them.
+ */
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_txn_begin(pure_storage_db *storage, pure_storage_txn **out);
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_txn_put(pure_storage_txn *txn, const char *key, size_t key_len,
+                                                             const char *type, const char *data, size_t data_len,
+                                                             int flags);
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_txn_remove(pure_storage_txn *txn, const char *key, size_t key_len);
+/* Both free the transaction */
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_txn_commit(pure_storage_txn *txn);
+PURE_STORAGE_EXPORT void pure_storage_txn_abort(pure_storage_txn *txn);
+
+/* Write out writes the engine is buffering, e.g. before a job finishes */
+PURE_STORAGE_EXPORT pure_storage_status pure_storage_flush(pure_storage_db *storage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PURE_STORAGE_H */
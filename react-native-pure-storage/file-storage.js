@@ -24,32 +24,14 @@ export default class FileStorage {
    */
   static async storeFile(key, uri, options = {}) {
     try {
-      // Import RNFS on-demand to avoid dependency if not used
-      const RNFS = require('react-native-fs');
-      
-      // Read the file as a base64 string
-      const base64 = await RNFS.readFile(uri, 'base64');
-      
-      // Convert base64 to binary
-      const binary = this._base64ToBinary(base64);
-      
-      // Default to using compression for files
-      const compressionOption = options.compression !== undefined ? options.compression : true;
+      const binary = await this._readBinary(uri);
       
-      // Store metadata if provided
-      if (options.metadata) {
-        await PureStorage.setItem(`${key}:metadata`, {
-          uri,
-          dateStored: new Date().toISOString(),
-          ...options.metadata
-        });
-      }
+      // With JSI the metadata is stored in the file's own record, so every file has some
+      const metadata = (options.metadata || PureStorage.jsi.isAvailable)
+        ? { uri, dateStored: new Date().toISOString(), ...options.metadata }
+        : null;
       
-      // Store the actual file data
-      return await PureStorage.setBinaryItem(key, binary, {
-        ...options,
-        compression: compressionOption
-      });
+      return await this._storeBinary(key, binary, metadata, options);
     } catch (error) {
       console.error('Error storing file:', error);
       return false;
@@ -64,6 +46,20 @@ export default class FileStorage {
    */
   static async getFile(key, options = {}) {
     try {
+      if (PureStorage.jsi.isAvailable) {
+        // The data and its metadata in one native call
+        const result = PureStorage.jsi.getWithAttributesSync(key);
+        if (!result) {
+          return { data: null, metadata: null };
+        }
+        
+        const data = result.value instanceof Uint8Array
+          ? result.value
+          : PureStorage.getBinaryItemSync(key, options);
+        const metadata = result.attributes || await this._getLegacyMetadata(key);
+        return { data, metadata };
+      }
+      
       // Get the file data
       const data = await PureStorage.getBinaryItem(key, options);
       
@@ -71,15 +67,7 @@ export default class FileStorage {
         return { data: null, metadata: null };
       }
       
-      // Try to get metadata if it exists
-      let metadata = null;
-      try {
-        metadata = await PureStorage.getItem(`${key}:metadata`);
-      } catch (e) {
-        // Metadata doesn't exist or couldn't be retrieved
-      }
-      
-      return { data, metadata };
+      return { data, metadata: await this._getLegacyMetadata(key) };
     } catch (error) {
       console.error('Error retrieving file:', error);
       return { data: null, metadata: null };
@@ -127,13 +115,9 @@ export default class FileStorage {
         ...options.metadata
       };
       
-      await PureStorage.setItem(`${key}:metadata`, imageInfo);
-      
-      // Store the actual image using file storage
-      return await this.storeFile(key, manipResult.uri, {
-        ...options,
-        metadata: undefined // Metadata already stored separately
-      });
+      // Store the actual image along with its metadata
+      const binary = await this._readBinary(manipResult.uri);
+      return await this._storeBinary(key, binary, imageInfo, options);
     } catch (error) {
       console.error('Error storing image:', error);
       return false;
@@ -200,10 +184,24 @@ export default class FileStorage {
   /**
    * List all stored files
    * @param {string} [prefix] - Optional prefix to filter by
-   * @returns {Promise<Array<{key: string, metadata: object|null}>>} - List of files
+   * @returns {Promise<Array<{key: string, metadata: object|null, size?: number, modifiedAt?: number|null}>>} - List of files,
+   *   with their size and modification time when JSI is available
    */
   static async listFiles(prefix = '') {
     try {
+      if (PureStorage.jsi.isAvailable) {
+        // Sizes, times and metadata all come from the record headers, without reading any file
+        const entries = PureStorage.jsi.listWithStatSync(prefix)
+          .filter(({ key }) => !key.endsWith(':metadata'));
+        
+        return await Promise.all(entries.map(async ({ key, size, modifiedAt, attributes }) => ({
+          key,
+          size,
+          modifiedAt,
+          metadata: attributes || await this._getLegacyMetadata(key)
+        })));
+      }
+      
       const allKeys = await PureStorage.getAllKeys();
       
       // Filter out metadata keys and keys that don't match prefix
@@ -213,16 +211,10 @@ export default class FileStorage {
       );
       
       // Get metadata for each file
-      const files = await Promise.all(fileKeys.map(async (key) => {
-        try {
-          const metadata = await PureStorage.getItem(`${key}:metadata`);
-          return { key, metadata };
-        } catch (e) {
-          return { key, metadata: null };
-        }
-      }));
-      
-      return files;
+      return await Promise.all(fileKeys.map(async (key) => ({
+        key,
+        metadata: await this._getLegacyMetadata(key)
+      })));
     } catch (error) {
       console.error('Error listing files:', error);
       return [];
@@ -236,8 +228,17 @@ export default class FileStorage {
    */
   static async deleteFile(key) {
     try {
-      // Delete the file data
-      await PureStorage.removeItem(key);
+      if (PureStorage.jsi.isAvailable) {
+        // Files with attributes never had a separate metadata key
+        const stat = PureStorage.jsi.statSync(key);
+        PureStorage.jsi.removeItemSync(key);
+        if (stat && stat.attributes) {
+          return true;
+        }
+      } else {
+        // Delete the file data
+        await PureStorage.removeItem(key);
+      }
       
       // Try to delete metadata if it exists
       try {
@@ -260,6 +261,18 @@ export default class FileStorage {
    */
   static async getFileSize(key) {
     try {
+      // Binary records know their decoded size; files stored before they
+      // went through the engine have to be read
+      if (PureStorage.jsi.isAvailable) {
+        const stat = PureStorage.jsi.statSync(key);
+        if (!stat) {
+          return null;
+        }
+        if (stat.type === 'binary') {
+          return stat.size;
+        }
+      }
+      
       const { data } = await this.getFile(key);
       return data ? data.byteLength : null;
     } catch (error) {
@@ -268,6 +281,81 @@ export default class FileStorage {
     }
   }
   
+  /**
+   * Read a file from a URI
+   * @param {string} uri - The URI of the file
+   * @returns {Promise<Uint8Array>} - The file contents
+   * @private
+   */
+  static async _readBinary(uri) {
+    // Import RNFS on-demand to avoid dependency if not used
+    const RNFS = require('react-native-fs');
+    
+    // Read the file as a base64 string
+    const base64 = await RNFS.readFile(uri, 'base64');
+    
+    // Convert base64 to binary
+    return this._base64ToBinary(base64);
+  }
+  
+  /**
+   * Store file data and its metadata
+   * @param {string} key - The key to store the file under
+   * @param {Uint8Array} binary - The file contents
+   * @param {object|null} metadata - Metadata to store with the file
+   * @param {object} options - Storage options
+   * @returns {Promise<boolean>} - Whether the operation succeeded
+   * @private
+   */
+  static async _storeBinary(key, binary, metadata, options) {
+    // Default to using compression for files
+    const compressionOption = options.compression !== undefined ? options.compression : true;
+    
+    if (PureStorage.jsi.isAvailable) {
+      // The metadata is written in the same record as the data, so neither
+      // can be left behind without the other
+      const success = PureStorage.setBinaryItemSync(key, binary, {
+        encrypted: options.encrypted,
+        compression: compressionOption,
+        attributes: metadata || undefined
+      });
+      
+      // A file first stored without JSI keeps its metadata under a separate
+      // key, which would otherwise shadow or outlive the new attributes
+      if (success && PureStorage.jsi.hasKeySync(`${key}:metadata`)) {
+        PureStorage.jsi.removeItemSync(`${key}:metadata`);
+      }
+      
+      return success;
+    }
+    
+    // Store metadata if provided
+    if (metadata) {
+      await PureStorage.setItem(`${key}:metadata`, metadata);
+    }
+    
+    // Store the actual file data
+    return await PureStorage.setBinaryItem(key, binary, {
+      ...options,
+      compression: compressionOption
+    });
+  }
+  
+  /**
+   * Get metadata stored under a separate key, as files stored without JSI have it
+   * @param {string} key - The key of the file
+   * @returns {Promise<object|null>} - The metadata, or null if there is none
+   * @private
+   */
+  static async _getLegacyMetadata(key) {
+    try {
+      return await PureStorage.getItem(`${key}:metadata`);
+    } catch (e) {
+      // Metadata doesn't exist or couldn't be retrieved
+      return null;
+    }
+  }
+  
   /**
    * Convert a base64 string to a Uint8Array
    * @param {string} base64 - Base64 string
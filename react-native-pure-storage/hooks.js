@@ -0,0 +1,65 @@
+/**
+ * React hooks for PureStorage
+ *
+ * Components read through the native engine's per-key versions, so checking
+ * a key on re-render costs a single version compare when nothing changed.
+ */
+
+import { useCallback, useEffect, useReducer, useRef, useSyncExternalStore } from 'react';
+import JSIStorage from './jsi-storage';
+import { KeyError, SyncOperationError } from './errors';
+
+// useSyncExternalStore is only available from React 18
+const useExternalStore = useSyncExternalStore || ((subscribe, getSnapshot) => {
+  const [, forceRender] = useReducer((count) => count + 1, 0);
+  
+  useEffect(() => subscribe(forceRender), [subscribe]);
+  
+  return getSnapshot();
+});
+
+/**
+ * Read a stored value and re-render when it changes
+ * @param {string} key - The key to read
+ * @param {object} [options] - Optional configuration
+ * @param {any} [options.default] - Value to return if the key doesn't exist
+ * @returns {any} - The stored value, or the default/null if not found
+ */
+export const useStorageValue = (key, options = {}) => {
+  if (typeof key !== 'string') {
+    throw new KeyError('Key must be a string');
+  }
+  
+  if (!JSIStorage.isAvailable) {
+    throw new SyncOperationError('useStorageValue requires JSI synchronous storage');
+  }
+  
+  const fallback = options.default !== undefined ? options.default : null;
+  const snapshot = useRef({ key, version: -1, value: fallback });
+  
+  if (snapshot.current.key !== key) {
+    snapshot.current = { key, version: -1, value: fallback };
+  }
+  
+  const subscribe = useCallback((onChange) => {
+    return JSIStorage.key(key).subscribe(onChange);
+  }, [key]);
+  
+  const getSnapshot = () => {
+    const current = snapshot.current;
+    const changed = JSIStorage.getIfChangedSync(key, current.version);
+    
+    // Keep the same snapshot object while the version is unchanged
+    if (changed !== undefined) {
+      snapshot.current = {
+        key,
+        version: changed.version,
+        value: changed.value !== null ? changed.value : fallback
+      };
+    }
+    
+    return snapshot.current.value;
+  };
+  
+  return useExternalStore(subscribe, getSnapshot);
+};
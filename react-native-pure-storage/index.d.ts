@@ -24,6 +24,12 @@ declare module 'react-native-pure-storage' {
      * The type of binary data to return: 'ArrayBuffer', 'Uint8Array', etc.
      */
     returnType?: 'ArrayBuffer' | 'Uint8Array' | 'Int8Array' | 'Uint16Array' | 'Int16Array' | 'Uint32Array' | 'Int32Array' | 'Float32Array' | 'Float64Array';
+    
+    /**
+     * Small JSON-serializable object written in the same record as the value,
+     * replacing any attributes it had (synchronous writes through JSI only)
+     */
+    attributes?: Record<string, any>;
   }
   
   export interface CacheOptions {
@@ -87,6 +93,137 @@ declare module 'react-native-pure-storage' {
     hitRate: number;
   }
   
+  /**
+ * Metrics reported by the native storage engine
+ */
+export interface EngineMetrics {
+  /** Time spent opening platform storage in the background, or -1 while still opening */
+  openMs: number;
+  /** Calls that had to wait for storage to finish opening */
+  openWaits: number;
+  /** Total time those calls waited */
+  openWaitMs: number;
+  /** Temporaries served from the per-thread call arenas, and their total size */
+  arenaAllocations: number;
+  arenaBytes: number;
+  /** Heap blocks taken to back the arenas; stays flat when hot paths don't allocate */
+  arenaBlockAllocations: number;
+  /** Arena resets, one per host-function call that used an arena */
+  arenaResets: number;
+  /** Writes to 'async' namespaces buffered in memory and not yet in storage */
+  pendingWrites: number;
+  /** Group commits of buffered writes, and the writes they stored */
+  flushes: number;
+  flushedWrites: number;
+  /** Reads of small values served from the engine's index without touching the value cache or storage */
+  inlineReads: number;
+}
+
+/**
+ * How the native engine stores the keys of a namespace
+ */
+export interface NamespaceConfig {
+  /** 'sync' writes reach disk before returning, 'async' writes are buffered in memory and group-committed later */
+  durability?: 'default' | 'sync' | 'async';
+  /** Store values deflated when that makes them smaller */
+  compression?: boolean;
+  /** Encrypt every write to the namespace with its own data key */
+  encryption?: boolean;
+  /** Budget for the namespace's cached values in bytes; 0 is unlimited */
+  cacheBytes?: number;
+  /** Expiry in milliseconds applied to every write; 0 never expires */
+  ttlDefault?: number;
+  /** Store keys as keyed hashes, with the key inside the encrypted value; implies encryption */
+  hideKeys?: boolean;
+  /** Reject writes that would take the namespace past this many bytes; 0 is unlimited */
+  quotaBytes?: number;
+  /** Reject values longer than this many bytes; 0 is unlimited */
+  maxValueBytes?: number;
+}
+
+/**
+ * Storage used by a namespace, as known to the native engine
+ */
+export interface NamespaceStats {
+  /** Size of the namespace's records (key, type and value, before compression) */
+  usedBytes: number;
+  keys: number;
+  /** Whether every record was counted, rather than only the ones the engine has seen */
+  measured: boolean;
+  /** Writes rejected by quotaBytes or maxValueBytes */
+  rejectedWrites: number;
+  /** The biggest known record */
+  largestKey?: string;
+  largestBytes?: number;
+}
+
+/**
+ * A stored value's header, read without the value
+ */
+export interface ItemStat {
+  /** Serialized type: 'string', 'number', 'boolean', 'object' or 'binary' */
+  type: string;
+  /** Bytes of the value: decoded bytes for binary data, UTF-8 bytes of the serialized value otherwise */
+  size: number;
+  /** Milliseconds since the epoch; null for values stored before times were kept */
+  createdAt: number | null;
+  modifiedAt: number | null;
+  /** Milliseconds since the epoch, or null if the value doesn't expire */
+  expiresAt: number | null;
+  /** Attributes the value was written with, or null if it has none */
+  attributes: Record<string, any> | null;
+}
+
+/** A batch read as parallel arrays; missing keys have the type 'null' and the value null */
+export interface ColumnsResult {
+  keys: string[];
+  types: string[];
+  values: any[];
+}
+
+/**
+ * A batch read with every value in one buffer. Entry i is
+ * data.subarray(ranges[2 * i], ranges[2 * i + 1]): a little-endian float64
+ * for numbers, the bytes of binary values, the serialized UTF-8 of anything
+ * else, and empty for missing keys. Numbers start at multiples of 8, so when
+ * every entry is a number, new Float64Array(data.buffer, data.byteOffset, keys.length)
+ * reads them all.
+ */
+export interface PackedColumnsResult {
+  keys: string[];
+  types: string[];
+  ranges: Uint32Array;
+  data: Uint8Array;
+}
+
+export interface KeyHandle<T = any> {
+    /**
+     * The key this handle is bound to
+     */
+    readonly key: string;
+    
+    /**
+     * Get the current value. Unchanged values are returned from the handle's cache.
+     */
+    get(options?: StorageOptions): T | null;
+    
+    /**
+     * Store a new value for the key
+     */
+    set(value: T, options?: StorageOptions): boolean;
+    
+    /**
+     * Remove the key
+     */
+    remove(): boolean;
+    
+    /**
+     * Listen for changes to the key, including writes made through the async API
+     * @returns A function to remove the listener
+     */
+    subscribe(callback: (value: T | null) => void): () => void;
+  }
+  
   export interface StorageInstanceOptions {
     /**
      * Namespace for the storage instance
@@ -214,7 +351,9 @@ declare module 'react-native-pure-storage' {
      * @returns An object of key-value pairs
      * @throws If JSI is not available and the platform doesn't support synchronous operations
      */
-    multiGetSync<T = Record<string, any>>(keys: string[], options?: StorageOptions): T;
+    multiGetSync<T = Record<string, any>>(keys: string[], options?: StorageOptions & { format?: 'object' }): T;
+    multiGetSync(keys: string[], options: StorageOptions & { format: 'columns' }): ColumnsResult;
+    multiGetSync(keys: string[], options: StorageOptions & { format: 'packed' }): PackedColumnsResult;
 
     /**
      * Remove multiple keys and their values
@@ -376,6 +515,120 @@ declare module 'react-native-pure-storage' {
        */
       hasKeySync(key: string): boolean;
       
+      /**
+       * Get a handle bound to a key for fast repeated access (JSI only)
+       * @param key Key to bind
+       * @returns {KeyHandle} Handle with get(), set(), remove() and subscribe()
+       * @throws {Error} If JSI is not available
+       */
+      key<T = any>(key: string): KeyHandle<T>;
+      
+      /**
+       * Get an item only if it changed since the given version (JSI only)
+       * @param key Key to get
+       * @param lastVersion Version returned by a previous call, or -1
+       * @returns The value and its version, or undefined if the key is unchanged
+       * @throws {Error} If JSI is not available
+       */
+      getIfChangedSync<T = any>(key: string, lastVersion?: number): { value: T | null; version: number } | undefined;
+      
+      /**
+       * Get the stored bytes of a value, e.g. a string's UTF-8, as an ArrayBuffer (JSI only)
+       * @param key Key to get
+       * @returns The bytes, or null if the key doesn't exist
+       * @throws {Error} If JSI is not available
+       */
+      getBufferSync(key: string): ArrayBuffer | null;
+      
+      /**
+       * Get the attributes a value was written with, without reading the value (JSI only)
+       * @param key Key to look up
+       * @returns The attributes, or null if the key doesn't exist or has none
+       * @throws {Error} If JSI is not available
+       */
+      getAttributesSync<A = Record<string, any>>(key: string): A | null;
+      
+      /**
+       * Get a value and its attributes in one native call (JSI only)
+       * @param key Key to get
+       * @returns null if the key doesn't exist
+       * @throws {Error} If JSI is not available
+       */
+      getWithAttributesSync<T = any, A = Record<string, any>>(key: string): { value: T; attributes: A | null } | null;
+      
+      /**
+       * Get a value's type, size, times and attributes without reading the value (JSI only)
+       * @param key Key to look up
+       * @returns The value's header, or null if the key doesn't exist
+       * @throws {Error} If JSI is not available
+       */
+      statSync(key: string): ItemStat | null;
+      
+      /**
+       * List the keys starting with a prefix along with their headers (JSI only)
+       * @param prefix Key prefix; all keys if omitted
+       * @returns One entry per key
+       * @throws {Error} If JSI is not available
+       */
+      listWithStatSync(prefix?: string): Array<ItemStat & { key: string }>;
+      
+      /**
+       * Get a value with the read, decryption and, for large objects, JSON parsing done off the JS thread (JSI only)
+       * @param key The key to get
+       * @param options Storage options
+       * @returns Promise resolving to the stored value, or null if not found
+       */
+      getItemAsync<T = any>(key: string, options?: StorageOptions): Promise<T | null>;
+      
+      /**
+       * Load keys into the native cache on a background thread (JSI only)
+       * @param keysOrPrefix Keys to load, or a key prefix
+       * @returns Promise resolving to the number of the keys that exist
+       */
+      prefetchAsync(keysOrPrefix: string[] | string): Promise<number>;
+      
+      /**
+       * Configure how the native engine stores a namespace (JSI only)
+       * @param name Namespace, i.e. the part of keys before the first ':'
+       * @param config Namespace options
+       * @throws {Error} If JSI is not available
+       */
+      configureNamespace(name: string, config: NamespaceConfig): void;
+      
+      /**
+       * Crypto-shred a namespace by destroying its data key (JSI only)
+       * @param name Namespace, i.e. the part of keys before the first ':'
+       * @returns {boolean} Success
+       * @throws {Error} If JSI is not available
+       */
+      shredNamespace(name: string): boolean;
+      
+      /**
+       * Get per-namespace storage usage (JSI only)
+       * @throws {Error} If JSI is not available
+       */
+      getNamespaceStats(): Record<string, NamespaceStats>;
+      
+      /**
+       * Write out buffered writes of 'async' namespaces in one group commit (JSI only)
+       * @returns {boolean} True once nothing is left buffered
+       * @throws {Error} If JSI is not available
+       */
+      flushSync(): boolean;
+      
+      /**
+       * Batch the sync writes made during each JS task into one commit (JSI only)
+       * @returns {boolean} Whether batching is on
+       * @throws {Error} If JSI is not available
+       */
+      setWriteBatching(enabled: boolean): boolean;
+      
+      /**
+       * Get native engine metrics (JSI only)
+       * @throws {Error} If JSI is not available
+       */
+      getMetrics(): EngineMetrics;
+      
       /**
        * Set multiple items synchronously (JSI only)
        * @param keyValuePairs Object of key-value pairs
@@ -392,7 +645,19 @@ declare module 'react-native-pure-storage' {
        * @returns {Object} Object of key-value pairs
        * @throws {Error} If JSI is not available
        */
-      multiGetSync<T = Record<string, any>>(keys: string[], options?: StorageOptions): T;
+      multiGetSync<T = Record<string, any>>(keys: string[], options?: StorageOptions & { format?: 'object' }): T;
+      multiGetSync(keys: string[], options: StorageOptions & { format: 'columns' }): ColumnsResult;
+      multiGetSync(keys: string[], options: StorageOptions & { format: 'packed' }): PackedColumnsResult;
+      
+      /**
+       * Read every key starting with a prefix, in key order (JSI only)
+       * @param prefix Key prefix; all keys if omitted
+       * @param options `format`: 'columns' (default), 'packed' or 'object'
+       * @throws {Error} If JSI is not available
+       */
+      scanSync(prefix?: string, options?: { format?: 'columns' }): ColumnsResult;
+      scanSync(prefix: string, options: { format: 'packed' }): PackedColumnsResult;
+      scanSync<T = Record<string, any>>(prefix: string, options: { format: 'object' }): T;
       
       /**
        * Remove multiple items synchronously (JSI only)
@@ -438,6 +703,14 @@ declare module 'react-native-pure-storage' {
     constructor(message?: string);
   }
 
+  /**
+   * Read a stored value and re-render when it changes (requires JSI)
+   * @param key - The key to read
+   * @param options - Optional default value
+   * @returns The stored value, or the default/null if not found
+   */
+  export function useStorageValue<T = any>(key: string, options?: { default?: T }): T | null;
+
   const PureStorage: PureStorageInterface;
   export default PureStorage;
 
@@ -4,10 +4,12 @@ import { StorageInstance } from './storage-instance';
 import { StorageError, KeyError, EncryptionError, SerializationError, SyncOperationError } from './errors';
 import JSIStorage from './jsi-storage';
 import FileStorage from './file-storage';
+import { useStorageValue } from './hooks';
+import { getAsyncModule } from './native-modules';
 
-const { RNPureStorage, RNJSIPureStorage } = NativeModules;
+const { RNJSIPureStorage } = NativeModules;
 
-if (!RNPureStorage) {
+if (!getAsyncModule()) {
   throw new Error(`RNPureStorage module is not linked. Please check the installation instructions.`);
 }
 
@@ -228,6 +230,10 @@ export const deserializeValue = (item) => {
       }
     }
     case 'object':
+      // Large documents may already have been parsed natively, off the JS thread
+      if (item.parsed) {
+        return item.value;
+      }
       try {
         return JSON.parse(item.value);
       } catch (e) {
@@ -298,6 +304,7 @@ const PureStorage = {
    * @param {object} [options] - Optional configuration
    * @param {boolean} [options.encrypted=false] - Whether to encrypt the data
    * @param {boolean} [options.skipCache=false] - Whether to skip the cache
+   * @param {object} [options.attributes] - Small object stored in the same record as the value (JSI only)
    * @returns {boolean} - Returns true if successful
    * @throws {Error} - If JSI is not available and the platform doesn't support synchronous operations
    */
@@ -677,7 +684,8 @@ const PureStorage = {
    * @param {Array<string>} keys - Array of keys to retrieve
    * @param {object} [options] - Optional configuration
    * @param {boolean} [options.skipCache=false] - Whether to skip the cache
-   * @returns {Object} - An object of key-value pairs
+   * @param {string} [options.format='object'] - 'object', or 'columns'/'packed' for parallel arrays (see jsi.scanSync)
+   * @returns {Object} - An object of key-value pairs, or the columns of the batch
    * @throws {Error} - If JSI is not available and the platform doesn't support synchronous operations
    */
   multiGetSync: (keys, options = {}) => {
@@ -942,7 +950,7 @@ const PureStorage = {
    * @param {object} [options] - Optional configuration
    * @param {boolean} [options.encrypted=false] - Whether to encrypt the data
    * @param {boolean} [options.skipCache=false] - Whether to skip the cache
-   * @param {boolean} [options.compression=false] - Whether to compress the data using RLE
+   * @param {boolean} [options.compression=false] - Whether to compress the data; with JSI the native backend deflates it
    * @returns {boolean} - Returns true if successful
    * @throws {Error} - If JSI is not available or if data is not binary
    */
@@ -1111,6 +1119,191 @@ const PureStorage = {
       return JSIStorage.hasKeySync(key);
     },
     
+    /**
+     * Get an item only if it changed since the given version (JSI only)
+     * @param {string} key Key to get
+     * @param {number} lastVersion Version returned by a previous call, or -1
+     * @returns {{value: any, version: number}|undefined} undefined if the key is unchanged
+     * @throws {Error} If JSI is not available
+     */
+    getIfChangedSync: (key, lastVersion = -1) => {
+      return JSIStorage.getIfChangedSync(key, lastVersion);
+    },
+    
+    /**
+     * Get the stored bytes of a value, e.g. a string's UTF-8, as an ArrayBuffer (JSI only).
+     * Storage that can be mapped is handed to JS in place instead of being copied.
+     * @param {string} key Key to get
+     * @returns {ArrayBuffer|null} The bytes, or null if the key doesn't exist
+     * @throws {Error} If JSI is not available
+     */
+    getBufferSync: (key) => {
+      if (typeof key !== 'string') {
+        throw new KeyError('Key must be a string');
+      }
+      
+      return JSIStorage.getBufferSync(key);
+    },
+    
+    /**
+     * Get a value's type, size, times and attributes without reading the value (JSI only).
+     * Sizes are in bytes: decoded bytes for binary data.
+     * @param {string} key Key to look up
+     * @returns {object|null} {type, size, createdAt, modifiedAt, expiresAt, attributes}, or null if the key doesn't exist
+     * @throws {Error} If JSI is not available
+     */
+    statSync: (key) => {
+      if (typeof key !== 'string') {
+        throw new KeyError('Key must be a string');
+      }
+      
+      return JSIStorage.statSync(key);
+    },
+    
+    /**
+     * Get the attributes a value was written with, without reading the value (JSI only)
+     * @param {string} key Key to look up
+     * @returns {object|null} The attributes, or null if the key doesn't exist or has none
+     * @throws {Error} If JSI is not available
+     */
+    getAttributesSync: (key) => {
+      if (typeof key !== 'string') {
+        throw new KeyError('Key must be a string');
+      }
+      
+      return JSIStorage.getAttributesSync(key);
+    },
+    
+    /**
+     * Get a value and its attributes in one native call (JSI only)
+     * @param {string} key Key to get
+     * @returns {{value: any, attributes: object|null}|null} null if the key doesn't exist
+     * @throws {Error} If JSI is not available
+     */
+    getWithAttributesSync: (key) => {
+      if (typeof key !== 'string') {
+        throw new KeyError('Key must be a string');
+      }
+      
+      return JSIStorage.getWithAttributesSync(key);
+    },
+    
+    /**
+     * List keys starting with a prefix, each with its statSync() header (JSI only)
+     * @param {string} [prefix] Key prefix; all keys if omitted
+     * @returns {Array<object>} Headers with a `key` property
+     * @throws {Error} If JSI is not available
+     */
+    listWithStatSync: (prefix = '') => {
+      return JSIStorage.listWithStatSync(prefix);
+    },
+    
+    /**
+     * Get a value with the read, decryption and, for large objects, JSON
+     * parsing done off the JS thread (JSI only)
+     * @param {string} key The key to get
+     * @param {Object} options Storage options
+     * @returns {Promise<any>} The stored value, or null if not found
+     */
+    getItemAsync: (key, options = {}) => {
+      if (typeof key !== 'string') {
+        return Promise.reject(new KeyError('Key must be a string'));
+      }
+      return JSIStorage.getItemAsync(key, options);
+    },
+    
+    /**
+     * Warm keys into the native cache off the JS thread (JSI only)
+     * @param {Array<string>|string} keysOrPrefix Keys to load, or a key prefix
+     * @returns {Promise<number>} Number of the keys that exist
+     */
+    prefetchAsync: (keysOrPrefix) => {
+      return JSIStorage.prefetchAsync(keysOrPrefix);
+    },
+    
+    /**
+     * Configure how the native engine stores a namespace (JSI only)
+     * @param {string} name Namespace, i.e. the part of keys before the first ':'
+     * @param {Object} config Durability, compression, encryption, cacheBytes and ttlDefault
+     * @throws {Error} If JSI is not available
+     */
+    configureNamespace: (name, config = {}) => {
+      if (typeof name !== 'string') {
+        throw new KeyError('Namespace must be a string');
+      }
+      
+      JSIStorage.configureNamespace(name, config);
+    },
+    
+    /**
+     * Crypto-shred a namespace (JSI only). Its data key is destroyed, so every
+     * value the engine encrypted for it reads as missing from then on.
+     * @param {string} name Namespace, i.e. the part of keys before the first ':'
+     * @returns {boolean} Success
+     * @throws {Error} If JSI is not available
+     */
+    shredNamespace: (name) => {
+      if (typeof name !== 'string') {
+        throw new KeyError('Namespace must be a string');
+      }
+      
+      return JSIStorage.shredNamespace(name);
+    },
+    
+    /**
+     * Get per-namespace storage usage (JSI only)
+     * @returns {Object} Bytes, keys, rejected writes and largest record, keyed by namespace
+     * @throws {Error} If JSI is not available
+     */
+    getNamespaceStats: () => {
+      return JSIStorage.getNamespaceStats();
+    },
+    
+    /**
+     * Write out buffered writes of 'async' namespaces in one group commit (JSI only).
+     * The engine also does this shortly after writes and when the app is backgrounded.
+     * @returns {boolean} True once nothing is left buffered
+     * @throws {Error} If JSI is not available
+     */
+    flushSync: () => {
+      return JSIStorage.flushSync();
+    },
+    
+    /**
+     * Batch the sync writes made during each JS task into one commit (JSI only).
+     * Writes are staged natively and read back immediately; the commit runs when
+     * the task and its microtasks are done. Off by default.
+     * @param {boolean} enabled Whether to batch writes
+     * @returns {boolean} Whether batching is on; it needs a JS CallInvoker
+     * @throws {Error} If JSI is not available
+     */
+    setWriteBatching: (enabled) => {
+      return JSIStorage.setWriteBatching(enabled);
+    },
+    
+    /**
+     * Get native engine metrics (JSI only)
+     * @returns {Object} Storage open timings and call arena allocation counts
+     * @throws {Error} If JSI is not available
+     */
+    getMetrics: () => {
+      return JSIStorage.getMetrics();
+    },
+    
+    /**
+     * Get a handle bound to a key for fast repeated access (JSI only)
+     * @param {string} key Key to bind
+     * @returns {Object} Handle with get(), set(), remove() and subscribe()
+     * @throws {Error} If JSI is not available
+     */
+    key: (key) => {
+      if (typeof key !== 'string') {
+        throw new KeyError('Key must be a string');
+      }
+      
+      return JSIStorage.key(key);
+    },
+    
     /**
      * Set multiple items synchronously (JSI only)
      * @param {Object} keyValuePairs Object of key-value pairs
@@ -1153,14 +1346,30 @@ const PureStorage = {
     /**
      * Get multiple items synchronously (JSI only)
      * @param {Array<string>} keys Array of keys to retrieve
-     * @param {Object} options Storage options
-     * @returns {Object} Object of key-value pairs
+     * @param {Object} options Storage options; `format` is 'object' (default), 'columns' or 'packed'
+     * @returns {Object} Object of key-value pairs, or the columns of the batch
      * @throws {Error} If JSI is not available
      */
     multiGetSync: (keys, options = {}) => {
       return JSIStorage.multiGetSync(keys, options);
     },
     
+    /**
+     * Read every key starting with a prefix, in key order (JSI only).
+     * 'columns' returns {keys, types, values}: parallel arrays rather than an
+     * object per entry. 'packed' returns {keys, types, ranges, data}, with all
+     * values in one buffer: entry i is data.subarray(ranges[2 * i], ranges[2 * i + 1]),
+     * a little-endian float64 for numbers, the bytes of binary values, and
+     * the serialized UTF-8 of anything else.
+     * @param {string} [prefix] Key prefix; all keys if omitted
+     * @param {Object} [options] `format` is 'columns' (default), 'packed' or 'object'
+     * @returns {Object} The columns of the scan
+     * @throws {Error} If JSI is not available
+     */
+    scanSync: (prefix = '', options = {}) => {
+      return JSIStorage.scanSync(prefix, options);
+    },
+    
     /**
      * Remove multiple items synchronously (JSI only)
      * @param {Array<string>} keys Array of keys to remove
@@ -1205,6 +1414,8 @@ const PureStorage = {
   decompressBinary,
   // Export file storage utility
   FileStorage,
+  // Export React hooks
+  useStorageValue,
 };
 
 // Export the main API
@@ -1220,6 +1431,7 @@ PureStorageAPI.SyncOperationError = SyncOperationError;
 module.exports = PureStorageAPI;
 export { 
   StorageInstance,
+  useStorageValue,
   StorageError,
   KeyError,
   EncryptionError,
@@ -1,196 +1,307 @@
 #import <jsi/jsi.h>
 #import <React/RCTBridge+Private.h>
 #import <React/RCTUtils.h>
+#import <UIKit/UIKit.h>
+#import <ReactCommon/CallInvoker.h>
+#ifdef RCT_NEW_ARCH_ENABLED
+#import <ReactCommon/RCTTurboModule.h>
+#endif
 #import "RNPureStorage.h"
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JSIPureStorageHostObject.h"
+#include "PureStorageEngine.h"
+#include "PureStorageTurboModule.h"
+#include "SharedEngine.h"
+#include "StorageBackend.h"
+
 // Namespace to avoid collisions
 namespace pure_storage {
-  
-using namespace facebook::jsi;
-  
-// Host object implementation
-class JSIPureStorageHostObject : public jsi::HostObject {
+
+static NSString *toNSString(const std::string &string) {
+  return [[NSString alloc] initWithBytes:string.data() length:string.size() encoding:NSUTF8StringEncoding] ?: @"";
+}
+
+// Stored outside the RNPureStorage_ prefix so it isn't part of the user's keys
+static NSString *const kStartupKeysName = @"RNPureStorageStartupKeys";
+
+static std::string toStdString(id string) {
+  if (![string isKindOfClass:[NSString class]]) {
+    return std::string();
+  }
+  const char *utf8 = [(NSString *)string UTF8String];
+  return utf8 ? std::string(utf8) : std::string();
+}
+
+// A whole number field of a stored record, or `absent` if it doesn't have one
+static int64_t numberField(NSDictionary *dictionary, NSString *field, int64_t absent) {
+  NSNumber *number = dictionary[field];
+  return [number isKindOfClass:[NSNumber class]] ? number.longLongValue : absent;
+}
+
+// Storage backend that calls into RNPureStorage (NSUserDefaults)
+class IOSStorageBackend : public StorageBackend {
 private:
   id<RNPureStorageInterface> pureStorage;
 
 public:
-  JSIPureStorageHostObject(id<RNPureStorageInterface> storage) : pureStorage(storage) {}
-  
-  jsi::Value get(jsi::Runtime& runtime, const jsi::PropNameID& name) override {
-    auto methodName = name.utf8(runtime);
-    
-    // setItemSync
-    if (methodName == "setItemSync") {
-      return jsi::Function::createFromHostFunction(
-        runtime,
-        name,
-        4, // key, type, value, encrypted
-        [this](jsi::Runtime& runtime, 
-              const jsi::Value& thisValue, 
-              const jsi::Value* arguments, 
-              size_t count) -> jsi::Value {
-          if (count < 4) {
-            return jsi::Value(false);
-          }
-          
-          NSString *key = [NSString stringWithUTF8String:arguments[0].getString(runtime).utf8(runtime).c_str()];
-          NSString *type = [NSString stringWithUTF8String:arguments[1].getString(runtime).utf8(runtime).c_str()];
-          NSString *value = [NSString stringWithUTF8String:arguments[2].getString(runtime).utf8(runtime).c_str()];
-          BOOL encrypted = arguments[3].getBool();
-          
-          BOOL result = [pureStorage setItemSync:key type:type value:value encrypted:encrypted];
-          return jsi::Value(result);
-      });
+  IOSStorageBackend(id<RNPureStorageInterface> storage) : pureStorage(storage) {}
+
+  bool setItem(const std::string &key, const StoredItem &item, const WriteOptions &options) override {
+    @autoreleasepool {
+      return [pureStorage writeItemSync:toNSString(key)
+                                   type:toNSString(item.type)
+                                  value:toNSString(item.value)
+                              encrypted:options.encrypted
+                           keyNamespace:options.encrypted ? toNSString(options.keyNamespace) : nil
+                             compressed:options.compressed
+                             durability:static_cast<NSInteger>(options.durability)
+                              expiresAt:static_cast<double>(item.expiresAt)
+                              createdAt:static_cast<double>(item.createdAt)
+                             modifiedAt:static_cast<double>(item.modifiedAt)
+                                   size:static_cast<double>(item.size)
+                             attributes:item.attributes.empty() ? nil : toNSString(item.attributes)];
+    }
+  }
+
+  bool getItem(const std::string &key, StoredItem &item) override {
+    @autoreleasepool {
+      NSDictionary *dictionary = [pureStorage readItemSync:toNSString(key)];
+      if (!dictionary) {
+        return false;
+      }
+
+      item.type = toStdString(dictionary[@"type"]);
+      item.value = toStdString(dictionary[@"value"]);
+      item.expiresAt = numberField(dictionary, @"expiresAt", 0);
+      item.createdAt = numberField(dictionary, @"createdAt", 0);
+      item.modifiedAt = numberField(dictionary, @"modifiedAt", 0);
+      item.size = numberField(dictionary, @"size", -1);
+      item.attributes = toStdString(dictionary[@"attributes"]);
+      return true;
+    }
+  }
+
+  bool statItem(const std::string &key, ItemStat &stat) override {
+    @autoreleasepool {
+      NSDictionary *dictionary = [pureStorage statItemSync:toNSString(key)];
+      if (!dictionary) {
+        return false;
+      }
+
+      stat.type = toStdString(dictionary[@"type"]);
+      stat.expiresAt = numberField(dictionary, @"expiresAt", 0);
+      stat.createdAt = numberField(dictionary, @"createdAt", 0);
+      stat.modifiedAt = numberField(dictionary, @"modifiedAt", 0);
+      stat.size = numberField(dictionary, @"size", -1);
+      stat.attributes = toStdString(dictionary[@"attributes"]);
+      return true;
+    }
+  }
+
+  bool removeItem(const std::string &key) override {
+    @autoreleasepool {
+      return [pureStorage removeItemSync:toNSString(key)];
     }
-    
-    // getItemSync
-    else if (methodName == "getItemSync") {
-      return jsi::Function::createFromHostFunction(
-        runtime,
-        name,
-        1, // key
-        [this](jsi::Runtime& runtime, 
-              const jsi::Value& thisValue, 
-              const jsi::Value* arguments, 
-              size_t count) -> jsi::Value {
-          if (count < 1) {
-            return jsi::Value::null();
-          }
-          
-          NSString *key = [NSString stringWithUTF8String:arguments[0].getString(runtime).utf8(runtime).c_str()];
-          NSDictionary *result = [pureStorage getItemSync:key];
-          
-          if (!result) {
-            return jsi::Value::null();
-          }
-          
-          jsi::Object jsResult(runtime);
-          NSString *type = result[@"type"];
-          NSString *value = result[@"value"];
-          
-          jsResult.setProperty(runtime, "type", jsi::String::createFromUtf8(runtime, [type UTF8String]));
-          jsResult.setProperty(runtime, "value", jsi::String::createFromUtf8(runtime, [value UTF8String]));
-          
-          return jsResult;
-      });
+  }
+
+  bool commitBatch() override {
+    @autoreleasepool {
+      return [pureStorage commitBatchSync];
     }
-    
-    // removeItemSync
-    else if (methodName == "removeItemSync") {
-      return jsi::Function::createFromHostFunction(
-        runtime,
-        name,
-        1, // key
-        [this](jsi::Runtime& runtime, 
-              const jsi::Value& thisValue, 
-              const jsi::Value* arguments, 
-              size_t count) -> jsi::Value {
-          if (count < 1) {
-            return jsi::Value(false);
-          }
-          
-          NSString *key = [NSString stringWithUTF8String:arguments[0].getString(runtime).utf8(runtime).c_str()];
-          BOOL result = [pureStorage removeItemSync:key];
-          
-          return jsi::Value(result);
-      });
+  }
+
+  bool shredNamespace(const std::string &name) override {
+    @autoreleasepool {
+      return [pureStorage shredNamespaceSync:toNSString(name)];
     }
-    
-    // clearSync
-    else if (methodName == "clearSync") {
-      return jsi::Function::createFromHostFunction(
-        runtime,
-        name,
-        0,
-        [this](jsi::Runtime& runtime, 
-              const jsi::Value& thisValue, 
-              const jsi::Value* arguments, 
-              size_t count) -> jsi::Value {
-          BOOL result = [pureStorage clearSync];
-          return jsi::Value(result);
-      });
+  }
+
+  std::string getKeyHashSecret(const std::string &name) override {
+    @autoreleasepool {
+      NSData *secret = [pureStorage keyHashSecretSync:toNSString(name)];
+      return secret ? std::string(static_cast<const char *>(secret.bytes), secret.length) : std::string();
     }
-    
-    // getAllKeysSync
-    else if (methodName == "getAllKeysSync") {
-      return jsi::Function::createFromHostFunction(
-        runtime,
-        name,
-        0,
-        [this](jsi::Runtime& runtime, 
-              const jsi::Value& thisValue, 
-              const jsi::Value* arguments, 
-              size_t count) -> jsi::Value {
-          NSArray<NSString *> *keys = [pureStorage getAllKeysSync];
-          
-          jsi::Array result(runtime, keys.count);
-          
-          for (NSUInteger i = 0; i < keys.count; i++) {
-            NSString *key = keys[i];
-            result.setValueAtIndex(runtime, i, jsi::String::createFromUtf8(runtime, [key UTF8String]));
-          }
-          
-          return result;
-      });
+  }
+
+  bool clear() override {
+    @autoreleasepool {
+      return [pureStorage clearSync];
     }
-    
-    // hasKeySync
-    else if (methodName == "hasKeySync") {
-      return jsi::Function::createFromHostFunction(
-        runtime,
-        name,
-        1, // key
-        [this](jsi::Runtime& runtime, 
-              const jsi::Value& thisValue, 
-              const jsi::Value* arguments, 
-              size_t count) -> jsi::Value {
-          if (count < 1) {
-            return jsi::Value(false);
-          }
-          
-          NSString *key = [NSString stringWithUTF8String:arguments[0].getString(runtime).utf8(runtime).c_str()];
-          BOOL result = [pureStorage hasKeySync:key];
-          
-          return jsi::Value(result);
-      });
+  }
+
+  std::vector<std::string> getAllKeys() override {
+    @autoreleasepool {
+      NSArray<NSString *> *keys = [pureStorage getAllKeysSync];
+      std::vector<std::string> result;
+      result.reserve(keys.count);
+
+      for (NSString *key in keys) {
+        result.push_back(toStdString(key));
+      }
+
+      return result;
+    }
+  }
+
+  bool hasKey(const std::string &key) override {
+    @autoreleasepool {
+      return [pureStorage hasKeySync:toNSString(key)];
+    }
+  }
+
+  std::vector<std::string> getStartupKeys() override {
+    @autoreleasepool {
+      id keys = [[NSUserDefaults standardUserDefaults] arrayForKey:kStartupKeysName];
+      std::vector<std::string> result;
+
+      for (id key in keys) {
+        result.push_back(toStdString(key));
+      }
+
+      return result;
+    }
+  }
+
+  void setStartupKeys(const std::vector<std::string> &keys) override {
+    @autoreleasepool {
+      NSMutableArray<NSString *> *array = [NSMutableArray arrayWithCapacity:keys.size()];
+      for (const auto &key : keys) {
+        [array addObject:toNSString(key)];
+      }
+
+      [[NSUserDefaults standardUserDefaults] setObject:array forKey:kStartupKeysName];
     }
-    
-    return jsi::Value::undefined();
   }
 };
 
-} // namespace pure_storage
+// The shared engine opens NSUserDefaults through its own RNPureStorage, which
+// keeps no state beyond NSUserDefaults, so it works the same from the bridge,
+// bridgeless apps and native code using pure_storage.h. Opened on the engine
+// worker like on Android, so the first NSUserDefaults access doesn't happen
+// on the install path. Registered at load so pure_storage_open() needs no setup.
+__attribute__((constructor)) static void registerBackendOpener() {
+  setSharedBackendOpener([]() -> std::shared_ptr<StorageBackend> {
+    return std::make_shared<IOSStorageBackend>([RNPureStorage new]);
+  });
+}
 
-@protocol RNPureStorageInterface
-- (BOOL)setItemSync:(NSString *)key type:(NSString *)type value:(NSString *)value encrypted:(BOOL)encrypted;
-- (NSDictionary *)getItemSync:(NSString *)key;
-- (BOOL)removeItemSync:(NSString *)key;
-- (BOOL)clearSync;
-- (NSArray<NSString *> *)getAllKeysSync;
-- (BOOL)hasKeySync:(NSString *)key;
-@end
+// Write out buffered writes once the app is backgrounded, inside a background
+// task so the app isn't suspended halfway through
+static void flushOnBackground() {
+  auto engine = findSharedEngine();
+  if (!engine) {
+    return;
+  }
+
+  UIApplication *application = RCTSharedApplication();
+  __block UIBackgroundTaskIdentifier task = UIBackgroundTaskInvalid;
+  void (^endTask)(void) = ^{
+    if (task != UIBackgroundTaskInvalid) {
+      [application endBackgroundTask:task];
+      task = UIBackgroundTaskInvalid;
+    }
+  };
+  task = [application beginBackgroundTaskWithName:@"RNPureStorageFlush" expirationHandler:endTask];
+
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+    engine->onAppBackground();
+    dispatch_async(dispatch_get_main_queue(), endTask);
+  });
+}
+
+static void observeAppLifecycle() {
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    [center addObserverForName:UIApplicationDidEnterBackgroundNotification
+                        object:nil
+                         queue:[NSOperationQueue mainQueue]
+                    usingBlock:^(NSNotification *notification) {
+                      flushOnBackground();
+                    }];
+
+    // The process exits once this returns, so this flush can't be handed off
+    [center addObserverForName:UIApplicationWillTerminateNotification
+                        object:nil
+                         queue:[NSOperationQueue mainQueue]
+                    usingBlock:^(NSNotification *notification) {
+                      if (auto engine = findSharedEngine()) {
+                        engine->flush();
+                      }
+                    }];
+  });
+}
+
+// The shared engine, with the work JS startup wants done once it exists
+static std::shared_ptr<PureStorageEngine> openEngine() {
+  auto engine = sharedEngine();
+
+  // Start loading last launch's startup keys before JS asks for them
+  engine->prewarmStartupKeys();
+
+  observeAppLifecycle();
+  return engine;
+}
+
+} // namespace pure_storage
 
 // C-style function to install the JSI bindings
 RCT_EXTERN void installPureStorageJSIBindings(RCTBridge *bridge) {
   RCTCxxBridge *cxxBridge = (RCTCxxBridge *)bridge;
-  
+
   if (!cxxBridge.runtime) {
     return;
   }
-  
-  // Get the RNPureStorage module
-  RNPureStorage *pureStorage = [bridge moduleForClass:[RNPureStorage class]];
-  if (!pureStorage) {
-    return;
-  }
-  
-  // Install the bindings
+
+  auto engine = pure_storage::openEngine();
   auto jsiRuntime = (facebook::jsi::Runtime *)cxxBridge.runtime;
-  auto hostObject = std::make_shared<pure_storage::JSIPureStorageHostObject>(pureStorage);
-  
+  pure_storage::installJSIPureStorage(*jsiRuntime, engine, bridge.jsCallInvoker);
+
+  // The async API on the same engine, for apps still on the bridge
+  auto turboModule = std::make_shared<pure_storage::PureStorageTurboModule>(engine, bridge.jsCallInvoker);
   jsiRuntime->global().setProperty(
     *jsiRuntime,
-    facebook::jsi::PropNameID::forAscii(*jsiRuntime, "JSIPureStorage"),
-    facebook::jsi::Object::createFromHostObject(*jsiRuntime, hostObject)
+    facebook::jsi::PropNameID::forAscii(*jsiRuntime, pure_storage::PureStorageTurboModule::kModuleName),
+    facebook::jsi::Object::createFromHostObject(*jsiRuntime, turboModule)
   );
-} 
\ No newline at end of file
+}
+
+// Called by the async methods after they write a key outside of JSI
+RCT_EXTERN void RNPureStorageNotifyItemChanged(NSString *key) {
+  auto engine = pure_storage::findSharedEngine();
+  if (engine && key) {
+    engine->invalidate(pure_storage::toStdString(key));
+  }
+}
+
+// Registers PureStorageTurboModule with the New Architecture, whose
+// TurboModule manager asks for it with the JS CallInvoker. There's no
+// RCTCxxBridge runtime to install through there, so JS calls install() on
+// the module to get the sync bindings.
+@interface RNPureStorageTurboModule : NSObject <RCTBridgeModule>
+@end
+
+#ifdef RCT_NEW_ARCH_ENABLED
+@interface RNPureStorageTurboModule () <RCTTurboModule>
+@end
+#endif
+
+@implementation RNPureStorageTurboModule
+
+RCT_EXPORT_MODULE(PureStorageTurboModule)
+
++ (BOOL)requiresMainQueueSetup {
+  return NO;
+}
+
+#ifdef RCT_NEW_ARCH_ENABLED
+- (std::shared_ptr<facebook::react::TurboModule>)getTurboModule:(const facebook::react::ObjCTurboModule::InitParams &)params {
+  return std::make_shared<pure_storage::PureStorageTurboModule>(pure_storage::openEngine(), params.jsInvoker);
+}
+#endif
+
+@end
@@ -4,6 +4,23 @@
 @protocol RNPureStorageInterface
 - (BOOL)setItemSync:(NSString *)key type:(NSString *)type value:(NSString *)value encrypted:(BOOL)encrypted;
 - (NSDictionary *)getItemSync:(NSString *)key;
+- (BOOL)writeItemSync:(NSString *)key
+                 type:(NSString *)type
+                value:(NSString *)value
+            encrypted:(BOOL)encrypted
+         keyNamespace:(NSString *)keyNamespace
+           compressed:(BOOL)compressed
+           durability:(NSInteger)durability
+            expiresAt:(double)expiresAt
+            createdAt:(double)createdAt
+           modifiedAt:(double)modifiedAt
+                 size:(double)size
+           attributes:(NSString *)attributes;
+- (NSDictionary *)readItemSync:(NSString *)key;
+- (NSDictionary *)statItemSync:(NSString *)key;
+- (BOOL)commitBatchSync;
+- (BOOL)shredNamespaceSync:(NSString *)name;
+- (NSData *)keyHashSecretSync:(NSString *)name;
 - (BOOL)removeItemSync:(NSString *)key;
 - (BOOL)clearSync;
 - (NSArray<NSString *> *)getAllKeysSync;
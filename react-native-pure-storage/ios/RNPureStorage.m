@@ -1,15 +1,88 @@
 #import "RNPureStorage.h"
+#import "RNPureStorageKeyring.h"
 #import <React/RCTUtils.h>
 #import <CommonCrypto/CommonCrypto.h>
+#import <zlib.h>
 
 // Constants
 static NSString *const RNPureStoragePrefix = @"RNPureStorage_";
 static NSString *const RNPureStorageEncryptionKeyName = @"RNPureStorage_EncryptionKey";
 
+// Optional record fields written by the native engine
+static NSString *const RNPureStorageEncodingDeflate = @"deflate";
+static NSString *const RNPureStorageKeyNamespace = @"keyNamespace";
+
+// Durability values passed by the native engine, matching pure_storage::Durability
+typedef NS_ENUM(NSInteger, RNPureStorageDurability) {
+  RNPureStorageDurabilityDefault = 0,
+  RNPureStorageDurabilitySync = 1,
+  RNPureStorageDurabilityAsync = 2,
+};
+
+// Shorter values rarely get smaller once Base64 encoded
+static const NSUInteger RNPureStorageMinCompressLength = 256;
+
+// Returns the Base64 zlib-compressed value, or nil if compressing doesn't make it smaller
+static NSString *RNPureStorageDeflate(NSString *string) {
+  NSData *input = [string dataUsingEncoding:NSUTF8StringEncoding];
+  if (input.length < RNPureStorageMinCompressLength) {
+    return nil;
+  }
+
+  uLongf outputLength = compressBound((uLong)input.length);
+  NSMutableData *output = [NSMutableData dataWithLength:outputLength];
+  if (compress2(output.mutableBytes, &outputLength, input.bytes, (uLong)input.length, Z_BEST_SPEED) != Z_OK) {
+    return nil;
+  }
+  output.length = outputLength;
+
+  NSString *encoded = [output base64EncodedStringWithOptions:0];
+  return encoded.length < string.length ? encoded : nil;
+}
+
+static NSString *RNPureStorageInflate(NSString *encoded) {
+  NSData *input = [[NSData alloc] initWithBase64EncodedString:encoded options:0];
+  if (!input) {
+    return nil;
+  }
+
+  z_stream stream = {0};
+  stream.next_in = (Bytef *)input.bytes;
+  stream.avail_in = (uInt)input.length;
+  if (inflateInit(&stream) != Z_OK) {
+    return nil;
+  }
+
+  NSMutableData *output = [NSMutableData dataWithLength:input.length * 4];
+  int status = Z_OK;
+  while (status == Z_OK) {
+    if (stream.total_out >= output.length) {
+      output.length *= 2;
+    }
+    stream.next_out = (Bytef *)output.mutableBytes + stream.total_out;
+    stream.avail_out = (uInt)(output.length - stream.total_out);
+    status = inflate(&stream, Z_NO_FLUSH);
+  }
+  output.length = stream.total_out;
+  inflateEnd(&stream);
+
+  if (status != Z_STREAM_END) {
+    return nil;
+  }
+  return [[NSString alloc] initWithData:output encoding:NSUTF8StringEncoding];
+}
+
+// Implemented in JSIPureStorage.mm - invalidates the JSI engine's cached state for a key
+RCT_EXTERN void RNPureStorageNotifyItemChanged(NSString *key);
+
 @implementation RNPureStorage {
   dispatch_queue_t _storageQueue;
   NSUserDefaults *_defaults;
   NSString *_encryptionKey;
+  // Derived from _encryptionKey once rather than on every call
+  unsigned char _key[kCCKeySizeAES256];
+  unsigned char _iv[kCCBlockSizeAES128];
+  RNPureStorageKeyring *_keyring;
 }
 
 RCT_EXPORT_MODULE();
@@ -18,6 +91,7 @@ RCT_EXPORT_MODULE();
   if (self = [super init]) {
     _storageQueue = dispatch_queue_create("com.purestorage.queue", DISPATCH_QUEUE_SERIAL);
     _defaults = [NSUserDefaults standardUserDefaults];
+    _keyring = [RNPureStorageKeyring sharedKeyring];
     [self setupEncryptionKey];
   }
   return self;
@@ -37,6 +111,10 @@ RCT_EXPORT_MODULE();
     [_defaults setObject:_encryptionKey forKey:RNPureStorageEncryptionKeyName];
     [_defaults synchronize];
   }
+  
+  NSData *keyData = [[NSData alloc] initWithBase64EncodedString:_encryptionKey options:0];
+  CC_SHA256(keyData.bytes, (CC_LONG)keyData.length, _key);
+  CC_MD5(keyData.bytes, (CC_LONG)keyData.length, _iv);
 }
 
 // Helper method that decides whether to run on the main thread or custom queue
@@ -52,14 +130,6 @@ RCT_EXPORT_MODULE();
   NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
   if (!data) return nil;
   
-  // Use the encryption key to derive a key and IV for AES encryption
-  NSData *keyData = [[NSData alloc] initWithBase64EncodedString:_encryptionKey options:0];
-  unsigned char key[kCCKeySizeAES256];
-  unsigned char iv[kCCBlockSizeAES128];
-  
-  CC_SHA256(keyData.bytes, (CC_LONG)keyData.length, key);
-  CC_MD5(keyData.bytes, (CC_LONG)keyData.length, iv);
-  
   // Encrypt the data
   size_t outLength;
   NSMutableData *cipherData = [NSMutableData dataWithLength:data.length + kCCBlockSizeAES128];
@@ -67,8 +137,8 @@ RCT_EXPORT_MODULE();
   CCCryptorStatus result = CCCrypt(kCCEncrypt,
                                    kCCAlgorithmAES,
                                    kCCOptionPKCS7Padding,
-                                   key, kCCKeySizeAES256,
-                                   iv,
+                                   _key, kCCKeySizeAES256,
+                                   _iv,
                                    data.bytes, data.length,
                                    cipherData.mutableBytes, cipherData.length,
                                    &outLength);
@@ -87,14 +157,6 @@ RCT_EXPORT_MODULE();
   NSData *cipherData = [[NSData alloc] initWithBase64EncodedString:encryptedString options:0];
   if (!cipherData) return nil;
   
-  // Use the encryption key to derive the same key and IV used for encryption
-  NSData *keyData = [[NSData alloc] initWithBase64EncodedString:_encryptionKey options:0];
-  unsigned char key[kCCKeySizeAES256];
-  unsigned char iv[kCCBlockSizeAES128];
-  
-  CC_SHA256(keyData.bytes, (CC_LONG)keyData.length, key);
-  CC_MD5(keyData.bytes, (CC_LONG)keyData.length, iv);
-  
   // Decrypt the data
   size_t outLength;
   NSMutableData *decryptedData = [NSMutableData dataWithLength:cipherData.length + kCCBlockSizeAES128];
@@ -102,8 +164,8 @@ RCT_EXPORT_MODULE();
   CCCryptorStatus result = CCCrypt(kCCDecrypt,
                                   kCCAlgorithmAES,
                                   kCCOptionPKCS7Padding,
-                                  key, kCCKeySizeAES256,
-                                  iv,
+                                  _key, kCCKeySizeAES256,
+                                  _iv,
                                   cipherData.bytes, cipherData.length,
                                   decryptedData.mutableBytes, decryptedData.length,
                                   &outLength);
@@ -126,6 +188,40 @@ RCT_EXPORT_MODULE();
   return @{@"type": type, @"value": value ?: [NSNull null]};
 }
 
+// Whether a record has passed its expiry time and should read as missing
+- (BOOL)isExpiredItem:(NSDictionary *)item {
+  NSNumber *expiresAt = item[@"expiresAt"];
+  return [expiresAt isKindOfClass:[NSNumber class]] &&
+         expiresAt.doubleValue <= [[NSDate date] timeIntervalSince1970] * 1000;
+}
+
+// Undo compression of an (already decrypted) value if the record says it was compressed
+- (NSDictionary *)decodedItem:(NSDictionary *)item value:(id)value {
+  NSMutableDictionary *decoded = [item mutableCopy];
+  if ([item[@"encoding"] isEqual:RNPureStorageEncodingDeflate] && [value isKindOfClass:[NSString class]]) {
+    value = RNPureStorageInflate(value);
+    [decoded removeObjectForKey:@"encoding"];
+  }
+  decoded[@"value"] = value ?: [NSNull null];
+  decoded[@"attributes"] = [self decryptedAttributes:item];
+  return decoded;
+}
+
+// A record's attributes, decrypted the way its value was encrypted; nil if it has none
+- (NSString *)decryptedAttributes:(NSDictionary *)item {
+  NSString *attributes = item[@"attributes"];
+  if (![attributes isKindOfClass:[NSString class]]) {
+    return nil;
+  }
+  
+  NSString *keyNamespace = item[RNPureStorageKeyNamespace];
+  if (keyNamespace) {
+    return [_keyring decryptString:attributes namespace:keyNamespace];
+  }
+  // Plain attributes are a JSON object, so anything else used the global key
+  return [attributes hasPrefix:@"{"] ? attributes : [self decryptString:attributes];
+}
+
 #pragma mark - Exposed Methods
 
 // Set Item
@@ -155,6 +251,7 @@ RCT_EXPORT_METHOD(setItem:(NSString *)key
       }
       
       // No need to synchronize after every call - iOS does this automatically at appropriate times
+      RNPureStorageNotifyItemChanged(key);
       resolve(@YES);
     } @catch (NSException *exception) {
       reject(@"ERR_UNEXPECTED_EXCEPTION", exception.reason, nil);
@@ -167,26 +264,96 @@ RCT_EXPORT_SYNCHRONOUS_METHOD(setItemSync:(NSString *)key
                             type:(NSString *)type
                             value:(NSString *)value
                             encrypted:(BOOL)encrypted) {
+  return @([self writeItemSync:key
+                          type:type
+                         value:value
+                     encrypted:encrypted
+                  keyNamespace:nil
+                    compressed:NO
+                    durability:RNPureStorageDurabilityDefault
+                     expiresAt:0
+                     createdAt:0
+                    modifiedAt:[[NSDate date] timeIntervalSince1970] * 1000
+                          size:-1
+                    attributes:nil]);
+}
+
+// Set an item with the options of its namespace (used by the native engine).
+// Encrypted values use the data key of keyNamespace, or the global key if it's nil.
+// The header (creation and modification times, the size the value reads as
+// in JS) is kept with the record for statItemSync:, and so are the
+// attributes, a JSON object encrypted along with the value.
+- (BOOL)writeItemSync:(NSString *)key
+                 type:(NSString *)type
+                value:(NSString *)value
+            encrypted:(BOOL)encrypted
+         keyNamespace:(NSString *)keyNamespace
+           compressed:(BOOL)compressed
+           durability:(NSInteger)durability
+            expiresAt:(double)expiresAt
+            createdAt:(double)createdAt
+           modifiedAt:(double)modifiedAt
+                 size:(double)size
+           attributes:(NSString *)attributes {
   if (!key) {
-    return @NO;
+    return NO;
   }
   
   @try {
     NSString *storageKey = [self keyWithPrefix:key];
-    NSDictionary *item = [self serializeItem:type value:value];
+    NSMutableDictionary *item = [[self serializeItem:type value:value] mutableCopy];
+    
+    // Compress before encrypting; ciphertext doesn't compress
+    NSString *compressedValue = compressed && value ? RNPureStorageDeflate(value) : nil;
+    if (compressedValue) {
+      item[@"value"] = compressedValue;
+      item[@"encoding"] = RNPureStorageEncodingDeflate;
+    }
+    
+    if (encrypted && keyNamespace && value) {
+      // Never fall back to storing plaintext for an encrypted namespace
+      NSString *encryptedValue = [_keyring encryptString:item[@"value"] namespace:keyNamespace];
+      if (!encryptedValue) {
+        return NO;
+      }
+      item[@"value"] = encryptedValue;
+      item[RNPureStorageKeyNamespace] = keyNamespace;
+    } else if (encrypted) {
+      item[@"value"] = [self encryptString:item[@"value"]];
+    }
     
-    if (encrypted) {
-      NSString *valueToStore = item[@"value"];
-      NSMutableDictionary *encryptedItem = [item mutableCopy];
-      encryptedItem[@"value"] = [self encryptString:valueToStore];
-      [_defaults setObject:encryptedItem forKey:storageKey];
-    } else {
-      [_defaults setObject:item forKey:storageKey];
+    if (attributes && item[RNPureStorageKeyNamespace]) {
+      NSString *encryptedAttributes = [_keyring encryptString:attributes namespace:keyNamespace];
+      if (!encryptedAttributes) {
+        return NO;
+      }
+      item[@"attributes"] = encryptedAttributes;
+    } else if (attributes) {
+      item[@"attributes"] = encrypted ? ([self encryptString:attributes] ?: attributes) : attributes;
     }
     
-    return @YES;
+    if (expiresAt > 0) {
+      item[@"expiresAt"] = @(expiresAt);
+    }
+    if (createdAt > 0) {
+      item[@"createdAt"] = @(createdAt);
+    }
+    if (modifiedAt > 0) {
+      item[@"modifiedAt"] = @(modifiedAt);
+    }
+    if (size >= 0) {
+      item[@"size"] = @(size);
+    }
+    
+    [_defaults setObject:item forKey:storageKey];
+    
+    if (durability == RNPureStorageDurabilitySync) {
+      [_defaults synchronize];
+    }
+    
+    return YES;
   } @catch (NSException *exception) {
-    return @NO;
+    return NO;
   }
 }
 
@@ -204,24 +371,30 @@ RCT_EXPORT_METHOD(getItem:(NSString *)key
       NSString *storageKey = [self keyWithPrefix:key];
       NSDictionary *item = [self->_defaults objectForKey:storageKey];
       
-      if (item) {
+      if (item && ![self isExpiredItem:item]) {
         NSString *type = item[@"type"];
         id value = item[@"value"];
         
+        NSString *keyNamespace = item[RNPureStorageKeyNamespace];
+        if (keyNamespace) {
+          // Encrypted with a namespace data key; nil once the namespace is shredded
+          NSString *decryptedValue = [self->_keyring decryptString:value namespace:keyNamespace];
+          resolve(decryptedValue ? [self decodedItem:item value:decryptedValue] : [NSNull null]);
+          return;
+        }
+        
         // Check if the value is encrypted
         if ([type isEqualToString:@"string"] && [value isKindOfClass:[NSString class]] && ![value hasPrefix:@"{"]) {
           NSString *decryptedValue = [self decryptString:value];
           
           if (decryptedValue) {
             // The value was successfully decrypted
-            NSMutableDictionary *decryptedItem = [item mutableCopy];
-            decryptedItem[@"value"] = decryptedValue;
-            resolve(decryptedItem);
+            resolve([self decodedItem:item value:decryptedValue]);
             return;
           }
         }
         
-        resolve(item);
+        resolve([self decodedItem:item value:value]);
       } else {
         resolve([NSNull null]);
       }
@@ -233,9 +406,19 @@ RCT_EXPORT_METHOD(getItem:(NSString *)key
 
 // Synchronous version of getItem
 RCT_EXPORT_SYNCHRONOUS_METHOD(getItemSync:(NSString *)key) {
-  if (!key) {
+  NSDictionary *item = [self readItemSync:key];
+  if (!item || [self isExpiredItem:item]) {
     return [NSNull null];
   }
+  return item;
+}
+
+// Read, decrypt and decompress a stored record, including expired ones.
+// Used by the native engine, which removes expired records itself.
+- (NSDictionary *)readItemSync:(NSString *)key {
+  if (!key) {
+    return nil;
+  }
   
   @try {
     NSString *storageKey = [self keyWithPrefix:key];
@@ -245,27 +428,72 @@ RCT_EXPORT_SYNCHRONOUS_METHOD(getItemSync:(NSString *)key) {
       NSString *type = item[@"type"];
       id value = item[@"value"];
       
+      NSString *keyNamespace = item[RNPureStorageKeyNamespace];
+      if (keyNamespace) {
+        // Encrypted with a namespace data key; nil once the namespace is shredded
+        NSString *decryptedValue = [_keyring decryptString:value namespace:keyNamespace];
+        return decryptedValue ? [self decodedItem:item value:decryptedValue] : nil;
+      }
+      
       // Check if the value is encrypted
       if ([type isEqualToString:@"string"] && [value isKindOfClass:[NSString class]] && ![value hasPrefix:@"{"]) {
         NSString *decryptedValue = [self decryptString:value];
         
         if (decryptedValue) {
           // The value was successfully decrypted
-          NSMutableDictionary *decryptedItem = [item mutableCopy];
-          decryptedItem[@"value"] = decryptedValue;
-          return decryptedItem;
+          return [self decodedItem:item value:decryptedValue];
         }
       }
       
-      return item;
+      return [self decodedItem:item value:value];
     }
     
-    return [NSNull null];
+    return nil;
   } @catch (NSException *exception) {
-    return [NSNull null];
+    return nil;
   }
 }
 
+// A record's fields without its value, which is neither decrypted nor decoded;
+// only the attributes are decrypted (used by the native engine)
+- (NSDictionary *)statItemSync:(NSString *)key {
+  if (!key) {
+    return nil;
+  }
+  
+  NSDictionary *item = [_defaults objectForKey:[self keyWithPrefix:key]];
+  if (![item isKindOfClass:[NSDictionary class]]) {
+    return nil;
+  }
+  
+  // Values of a shredded namespace read as missing
+  NSString *keyNamespace = item[RNPureStorageKeyNamespace];
+  if (keyNamespace && ![_keyring hasKeyForNamespace:keyNamespace]) {
+    return nil;
+  }
+  
+  NSMutableDictionary *stat = [item mutableCopy];
+  [stat removeObjectForKey:@"value"];
+  stat[@"attributes"] = [self decryptedAttributes:item];
+  return stat;
+}
+
+// Persist a group of engine writes at once; NSUserDefaults has no per-batch editor,
+// so this is one synchronize for the whole batch (used by the native engine)
+- (BOOL)commitBatchSync {
+  return [_defaults synchronize];
+}
+
+// Destroy a namespace's data key (used by the native engine)
+- (BOOL)shredNamespaceSync:(NSString *)name {
+  return name && [_keyring shredNamespace:name];
+}
+
+// Secret for hashing a namespace's key names (used by the native engine)
+- (NSData *)keyHashSecretSync:(NSString *)name {
+  return name ? [_keyring keyHashSecretForNamespace:name] : nil;
+}
+
 // Remove Item
 RCT_EXPORT_METHOD(removeItem:(NSString *)key
                   resolver:(RCTPromiseResolveBlock)resolve
@@ -279,6 +507,7 @@ RCT_EXPORT_METHOD(removeItem:(NSString *)key
     @try {
       NSString *storageKey = [self keyWithPrefix:key];
       [self->_defaults removeObjectForKey:storageKey];
+      RNPureStorageNotifyItemChanged(key);
       resolve(@YES);
     } @catch (NSException *exception) {
       reject(@"ERR_UNEXPECTED_EXCEPTION", exception.reason, nil);
@@ -297,6 +526,7 @@ RCT_EXPORT_METHOD(clear:(RCTPromiseResolveBlock)resolve
       for (NSString *key in dictionary) {
         if ([key hasPrefix:RNPureStoragePrefix]) {
           [defaults removeObjectForKey:key];
+          RNPureStorageNotifyItemChanged([key substringFromIndex:RNPureStoragePrefix.length]);
         }
       }
       
@@ -391,6 +621,8 @@ RCT_EXPORT_METHOD(multiSet:(NSArray *)keyValueArray
         } else {
           [defaults setObject:item forKey:storageKey];
         }
+        
+        RNPureStorageNotifyItemChanged(key);
       }
       
       resolve(@YES);
@@ -423,24 +655,30 @@ RCT_EXPORT_METHOD(multiGet:(NSArray *)keys
         NSString *storageKey = [self keyWithPrefix:key];
         NSDictionary *item = [defaults objectForKey:storageKey];
         
-        if (item) {
+        if (item && ![self isExpiredItem:item]) {
           NSString *type = item[@"type"];
           id value = item[@"value"];
           
+          NSString *keyNamespace = item[RNPureStorageKeyNamespace];
+          if (keyNamespace) {
+            // Encrypted with a namespace data key; nil once the namespace is shredded
+            NSString *decryptedValue = [self->_keyring decryptString:value namespace:keyNamespace];
+            result[key] = decryptedValue ? [self decodedItem:item value:decryptedValue] : [NSNull null];
+            continue;
+          }
+          
           // Check if the value is encrypted
           if ([type isEqualToString:@"string"] && [value isKindOfClass:[NSString class]] && ![value hasPrefix:@"{"]) {
             NSString *decryptedValue = [self decryptString:value];
             
             if (decryptedValue) {
               // The value was successfully decrypted
-              NSMutableDictionary *decryptedItem = [item mutableCopy];
-              decryptedItem[@"value"] = decryptedValue;
-              result[key] = decryptedItem;
+              result[key] = [self decodedItem:item value:decryptedValue];
               continue;
             }
           }
           
-          result[key] = item;
+          result[key] = [self decodedItem:item value:value];
         } else {
           result[key] = [NSNull null];
         }
@@ -474,6 +712,7 @@ RCT_EXPORT_METHOD(multiRemove:(NSArray *)keys
         
         NSString *storageKey = [self keyWithPrefix:key];
         [defaults removeObjectForKey:storageKey];
+        RNPureStorageNotifyItemChanged(key);
       }
       
       resolve(@YES);
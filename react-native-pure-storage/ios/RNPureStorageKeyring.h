@@ -0,0 +1,28 @@
+#import <Foundation/Foundation.h>
+
+// Per-namespace data keys for values encrypted by the native engine.
+//
+// Each namespace gets a random AES-256 data key, stored in NSUserDefaults
+// wrapped by a master key kept in the Keychain. Unwrapped keys are kept as
+// ready-to-use CommonCrypto contexts for the life of the process, and
+// removing a namespace's wrapped key crypto-shreds its values.
+@interface RNPureStorageKeyring : NSObject
+
++ (instancetype)sharedKeyring;
+
+// Encrypt with the namespace's data key, creating it on first use
+- (NSString *)encryptString:(NSString *)string namespace:(NSString *)name;
+
+// Returns nil if the namespace has no key (it was shredded) or the value doesn't decrypt
+- (NSString *)decryptString:(NSString *)string namespace:(NSString *)name;
+
+// 16 bytes for hashing the namespace's key names, derived from its data key
+- (NSData *)keyHashSecretForNamespace:(NSString *)name;
+
+// Whether the namespace has a data key, i.e. hasn't been shredded since its last encrypted write
+- (BOOL)hasKeyForNamespace:(NSString *)name;
+
+// Destroy the namespace's data key; a new one is created on the next encrypted write
+- (BOOL)shredNamespace:(NSString *)name;
+
+@end
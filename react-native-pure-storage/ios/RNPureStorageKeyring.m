@@ -0,0 +1,259 @@
+#import "RNPureStorageKeyring.h"
+#import <CommonCrypto/CommonCrypto.h>
+#import <Security/Security.h>
+
+static NSString *const RNPureStorageNamespaceKeysName = @"RNPureStorageNamespaceKeys";
+static NSString *const RNPureStorageKeychainService = @"com.purestorage.keyring";
+static NSString *const RNPureStorageKeychainMasterKey = @"MasterKey";
+static NSString *const RNPureStorageKeyHashLabel = @"RNPureStorage key names";
+static const NSUInteger RNPureStorageKeyHashSecretLength = 16;
+
+static NSData *RNPureStorageRandomBytes(size_t length) {
+  NSMutableData *data = [NSMutableData dataWithLength:length];
+  if (SecRandomCopyBytes(kSecRandomDefault, length, data.mutableBytes) != errSecSuccess) {
+    return nil;
+  }
+  return data;
+}
+
+// AES-256-CBC with a fresh random IV, stored in front of the ciphertext
+static NSData *RNPureStorageCrypt(CCOperation operation, CCCryptorRef cryptor, NSData *input) {
+  NSData *iv;
+  const uint8_t *bytes = input.bytes;
+  size_t length = input.length;
+
+  if (operation == kCCEncrypt) {
+    iv = RNPureStorageRandomBytes(kCCBlockSizeAES128);
+  } else {
+    if (length < kCCBlockSizeAES128) {
+      return nil;
+    }
+    iv = [NSData dataWithBytes:bytes length:kCCBlockSizeAES128];
+    bytes += kCCBlockSizeAES128;
+    length -= kCCBlockSizeAES128;
+  }
+  if (!iv) {
+    return nil;
+  }
+
+  NSMutableData *output = [NSMutableData dataWithCapacity:length + 2 * kCCBlockSizeAES128];
+  if (operation == kCCEncrypt) {
+    [output appendData:iv];
+  }
+  size_t offset = output.length;
+  output.length = offset + CCCryptorGetOutputLength(cryptor, length, true);
+
+  size_t updated = 0;
+  size_t finished = 0;
+  if (CCCryptorReset(cryptor, iv.bytes) != kCCSuccess ||
+      CCCryptorUpdate(cryptor, bytes, length, (uint8_t *)output.mutableBytes + offset,
+                      output.length - offset, &updated) != kCCSuccess ||
+      CCCryptorFinal(cryptor, (uint8_t *)output.mutableBytes + offset + updated,
+                     output.length - offset - updated, &finished) != kCCSuccess) {
+    return nil;
+  }
+
+  output.length = offset + updated + finished;
+  return output;
+}
+
+// A data key with its key schedule expanded once, reused for every value.
+// CCCryptor objects aren't thread-safe, so use is serialized per context.
+@interface RNPureStorageCipherContext : NSObject
+@property (nonatomic, readonly) NSData *keyHashSecret;
+- (instancetype)initWithKey:(NSData *)key;
+- (NSData *)crypt:(CCOperation)operation data:(NSData *)data;
+@end
+
+@implementation RNPureStorageCipherContext {
+  CCCryptorRef _encryptor;
+  CCCryptorRef _decryptor;
+}
+
+- (instancetype)initWithKey:(NSData *)key {
+  if (self = [super init]) {
+    if (CCCryptorCreate(kCCEncrypt, kCCAlgorithmAES, kCCOptionPKCS7Padding, key.bytes, kCCKeySizeAES256,
+                        NULL, &_encryptor) != kCCSuccess ||
+        CCCryptorCreate(kCCDecrypt, kCCAlgorithmAES, kCCOptionPKCS7Padding, key.bytes, kCCKeySizeAES256,
+                        NULL, &_decryptor) != kCCSuccess) {
+      return nil;
+    }
+
+    // Derived rather than stored, so it goes when the data key is shredded
+    NSMutableData *material = [[RNPureStorageKeyHashLabel dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+    [material appendData:key];
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(material.bytes, (CC_LONG)material.length, digest);
+    _keyHashSecret = [NSData dataWithBytes:digest length:RNPureStorageKeyHashSecretLength];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  if (_encryptor) {
+    CCCryptorRelease(_encryptor);
+  }
+  if (_decryptor) {
+    CCCryptorRelease(_decryptor);
+  }
+}
+
+- (NSData *)crypt:(CCOperation)operation data:(NSData *)data {
+  @synchronized(self) {
+    return RNPureStorageCrypt(operation, operation == kCCEncrypt ? _encryptor : _decryptor, data);
+  }
+}
+
+@end
+
+@implementation RNPureStorageKeyring {
+  NSUserDefaults *_defaults;
+  NSMutableDictionary<NSString *, RNPureStorageCipherContext *> *_contexts;
+  RNPureStorageCipherContext *_master;
+}
+
++ (instancetype)sharedKeyring {
+  static RNPureStorageKeyring *keyring;
+  static dispatch_once_t once;
+  dispatch_once(&once, ^{
+    keyring = [[RNPureStorageKeyring alloc] init];
+  });
+  return keyring;
+}
+
+- (instancetype)init {
+  if (self = [super init]) {
+    _defaults = [NSUserDefaults standardUserDefaults];
+    _contexts = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (NSString *)encryptString:(NSString *)string namespace:(NSString *)name {
+  RNPureStorageCipherContext *context = [self contextForNamespace:name create:YES];
+  NSData *encrypted = [context crypt:kCCEncrypt data:[string dataUsingEncoding:NSUTF8StringEncoding]];
+  return [encrypted base64EncodedStringWithOptions:0];
+}
+
+- (NSString *)decryptString:(NSString *)string namespace:(NSString *)name {
+  RNPureStorageCipherContext *context = [self contextForNamespace:name create:NO];
+  NSData *data = [[NSData alloc] initWithBase64EncodedString:string options:0];
+  if (!context || !data) {
+    return nil;
+  }
+
+  NSData *decrypted = [context crypt:kCCDecrypt data:data];
+  return decrypted ? [[NSString alloc] initWithData:decrypted encoding:NSUTF8StringEncoding] : nil;
+}
+
+- (NSData *)keyHashSecretForNamespace:(NSString *)name {
+  return [self contextForNamespace:name create:YES].keyHashSecret;
+}
+
+- (BOOL)hasKeyForNamespace:(NSString *)name {
+  @synchronized(self) {
+    return _contexts[name] != nil || [_defaults dictionaryForKey:RNPureStorageNamespaceKeysName][name] != nil;
+  }
+}
+
+- (BOOL)shredNamespace:(NSString *)name {
+  @synchronized(self) {
+    [_contexts removeObjectForKey:name];
+
+    NSMutableDictionary *keys = [[_defaults dictionaryForKey:RNPureStorageNamespaceKeysName] mutableCopy];
+    if (keys[name]) {
+      [keys removeObjectForKey:name];
+      [_defaults setObject:keys forKey:RNPureStorageNamespaceKeysName];
+      return [_defaults synchronize];
+    }
+    return YES;
+  }
+}
+
+#pragma mark - Keys
+
+- (RNPureStorageCipherContext *)contextForNamespace:(NSString *)name create:(BOOL)create {
+  @synchronized(self) {
+    RNPureStorageCipherContext *context = _contexts[name];
+    if (context) {
+      return context;
+    }
+
+    RNPureStorageCipherContext *master = [self masterContext];
+    if (!master) {
+      return nil;
+    }
+
+    NSDictionary *keys = [_defaults dictionaryForKey:RNPureStorageNamespaceKeysName];
+    NSString *wrapped = keys[name];
+    NSData *key;
+    if (wrapped) {
+      NSData *data = [[NSData alloc] initWithBase64EncodedString:wrapped options:0];
+      key = data ? [master crypt:kCCDecrypt data:data] : nil;
+    } else if (create) {
+      key = RNPureStorageRandomBytes(kCCKeySizeAES256);
+      NSData *wrappedKey = key ? [master crypt:kCCEncrypt data:key] : nil;
+      if (!wrappedKey) {
+        return nil;
+      }
+
+      // The key must be on disk before any value encrypted with it
+      NSMutableDictionary *updated = keys ? [keys mutableCopy] : [NSMutableDictionary dictionary];
+      updated[name] = [wrappedKey base64EncodedStringWithOptions:0];
+      [_defaults setObject:updated forKey:RNPureStorageNamespaceKeysName];
+      if (![_defaults synchronize]) {
+        return nil;
+      }
+    }
+
+    if (key.length != kCCKeySizeAES256) {
+      return nil;
+    }
+
+    context = [[RNPureStorageCipherContext alloc] initWithKey:key];
+    _contexts[name] = context;
+    return context;
+  }
+}
+
+// Called with the keyring locked
+- (RNPureStorageCipherContext *)masterContext {
+  if (_master) {
+    return _master;
+  }
+
+  NSDictionary *query = @{
+    (__bridge id)kSecClass: (__bridge id)kSecClassGenericPassword,
+    (__bridge id)kSecAttrService: RNPureStorageKeychainService,
+    (__bridge id)kSecAttrAccount: RNPureStorageKeychainMasterKey,
+    (__bridge id)kSecReturnData: @YES,
+  };
+
+  CFTypeRef result = NULL;
+  OSStatus status = SecItemCopyMatching((__bridge CFDictionaryRef)query, &result);
+  NSData *key = status == errSecSuccess ? (__bridge_transfer NSData *)result : nil;
+
+  if (status == errSecItemNotFound) {
+    key = RNPureStorageRandomBytes(kCCKeySizeAES256);
+    NSDictionary *item = @{
+      (__bridge id)kSecClass: (__bridge id)kSecClassGenericPassword,
+      (__bridge id)kSecAttrService: RNPureStorageKeychainService,
+      (__bridge id)kSecAttrAccount: RNPureStorageKeychainMasterKey,
+      // Readable by the engine in the background, never leaves the device
+      (__bridge id)kSecAttrAccessible: (__bridge id)kSecAttrAccessibleAfterFirstUnlockThisDeviceOnly,
+      (__bridge id)kSecValueData: key ?: [NSData data],
+    };
+    if (!key || SecItemAdd((__bridge CFDictionaryRef)item, NULL) != errSecSuccess) {
+      return nil;
+    }
+  }
+
+  if (key.length != kCCKeySizeAES256) {
+    return nil;
+  }
+
+  _master = [[RNPureStorageCipherContext alloc] initWithKey:key];
+  return _master;
+}
+
+@end
@@ -7,11 +7,94 @@
 
 import { NativeModules, Platform } from 'react-native';
 import { serializeValue, deserializeValue } from './index';
+import { installJSIBindings } from './native-modules';
 
-// Check if JSI is available
+// Check if JSI is available, installing it where the bridge didn't
+installJSIBindings();
 const JSIPureStorage = global.JSIPureStorage;
 const isJSIAvailable = !!JSIPureStorage;
 
+// Attributes cross to native as the text of a JSON object
+const serializeAttributes = (attributes) => {
+  if (attributes === undefined || attributes === null) {
+    return undefined;
+  }
+  if (typeof attributes !== 'object' || Array.isArray(attributes)) {
+    throw new Error('Attributes must be an object');
+  }
+  return JSON.stringify(attributes);
+};
+
+const parseAttributes = (text) => (text ? JSON.parse(text) : null);
+
+// statSync() headers with their attributes parsed
+const parseStat = (stat) => (stat ? { ...stat, attributes: parseAttributes(stat.attributes) } : null);
+
+// A copy of a cached value for a caller that may change it. Objects are
+// stored as JSON, so a JSON round trip copies them exactly.
+const copyValue = (value) => {
+  if (value === null || typeof value !== 'object') {
+    return value;
+  }
+  if (value instanceof ArrayBuffer) {
+    return value.slice(0);
+  }
+  if (ArrayBuffer.isView(value)) {
+    return value.slice();
+  }
+  return JSON.parse(JSON.stringify(value));
+};
+
+// Deserialize a values column in place, without a {type, value} object per entry
+const decodeColumn = (types, values) => {
+  for (let i = 0; i < values.length; i++) {
+    switch (types[i]) {
+      case 'string':
+        break;
+      case 'number':
+        values[i] = Number(values[i]);
+        break;
+      case 'boolean':
+        values[i] = values[i] === 'true';
+        break;
+      case 'null':
+        values[i] = null;
+        break;
+      default:
+        values[i] = deserializeValue({ type: types[i], value: values[i] });
+    }
+  }
+  return values;
+};
+
+// A native columns result in the requested format: 'columns' gives
+// {keys, types, values}; 'packed' gives {keys, types, ranges, data}, where
+// entry i is data.subarray(ranges[2 * i], ranges[2 * i + 1]); 'object'
+// maps each key to its value
+const formatColumns = (keys, columns, format, options) => {
+  if (format === 'packed') {
+    const count = keys.length;
+    return {
+      keys,
+      types: columns.types,
+      ranges: new Uint32Array(columns.buffer, 0, count * 2),
+      data: new Uint8Array(columns.buffer, count * 8)
+    };
+  }
+  
+  const values = decodeColumn(columns.types, columns.values);
+  if (format === 'columns') {
+    return { keys, types: columns.types, values };
+  }
+  
+  const result = {};
+  for (let i = 0; i < keys.length; i++) {
+    const missing = columns.types[i] === 'null' && options.default !== undefined;
+    result[keys[i]] = missing ? options.default : values[i];
+  }
+  return result;
+};
+
 /**
  * A pure JavaScript wrapper for the JSI implementation
  */
@@ -25,7 +108,8 @@ const JSIStorage = {
    * Set an item synchronously using JSI
    * @param {string} key - The key to store
    * @param {any} value - The value to store
-   * @param {object} options - Storage options
+   * @param {object} options - Storage options; `attributes` is an object written in the same record,
+   *   and `compression` has the native backend deflate the record
    * @returns {boolean} - Whether the operation was successful
    */
   setItemSync: (key, value, options = {}) => {
@@ -39,7 +123,9 @@ const JSIStorage = {
         key,
         serialized.type,
         serialized.value,
-        !!options.encrypted
+        !!options.encrypted,
+        serializeAttributes(options.attributes),
+        !!options.compression
       );
     } catch (error) {
       return false;
@@ -69,6 +155,121 @@ const JSIStorage = {
     }
   },
   
+  /**
+   * Get an item off the JS thread: the native engine reads, decrypts and
+   * decompresses it on its worker, and parses large objects there too, so
+   * the JS thread only builds the result
+   * @param {string} key - The key to get
+   * @param {object} options - Storage options
+   * @returns {Promise<any>} - The stored value or null if not found
+   */
+  getItemAsync: (key, options = {}) => {
+    if (!isJSIAvailable) {
+      return Promise.reject(new Error('JSI synchronous storage is not available'));
+    }
+    
+    try {
+      return JSIPureStorage.getItemAsync(key).then((result) => {
+        if (!result) {
+          return options.default !== undefined ? options.default : null;
+        }
+        return deserializeValue(result);
+      });
+    } catch (error) {
+      return Promise.reject(error);
+    }
+  },
+  
+  /**
+   * Get an item together with the attributes it was written with, in one native call
+   * @param {string} key - The key to get
+   * @returns {{value: any, attributes: object|null}|null} - null if the key doesn't exist
+   */
+  getWithAttributesSync: (key) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    const result = JSIPureStorage.getItemSync(key);
+    if (!result) {
+      return null;
+    }
+    
+    return { value: deserializeValue(result), attributes: parseAttributes(result.attributes) };
+  },
+  
+  /**
+   * Get the attributes an item was written with, without reading its value
+   * @param {string} key - The key to look up
+   * @returns {object|null} - null if the key doesn't exist or has no attributes
+   */
+  getAttributesSync: (key) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    const stat = JSIPureStorage.statSync(key);
+    return stat ? parseAttributes(stat.attributes) : null;
+  },
+  
+  /**
+   * Get an item only if it changed since the given version
+   * @param {string} key - The key to get
+   * @param {number} lastVersion - The version returned by a previous call, or -1
+   * @returns {{value: any, version: number}|undefined} - undefined if the key is unchanged
+   */
+  getIfChangedSync: (key, lastVersion = -1) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    const result = JSIPureStorage.getIfChangedSync(key, lastVersion);
+    if (result === undefined) {
+      return undefined;
+    }
+    
+    return { value: deserializeValue(result), version: result.version };
+  },
+  
+  /**
+   * Get the stored bytes of a value as an ArrayBuffer, without copying them where the backend allows
+   * @param {string} key - The key to get
+   * @returns {ArrayBuffer|null} - The bytes, or null if the key doesn't exist
+   */
+  getBufferSync: (key) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    return JSIPureStorage.getBufferSync(key);
+  },
+  
+  /**
+   * Get a value's type, size, times and attributes without reading the value
+   * @param {string} key - The key to look up
+   * @returns {{type: string, size: number, createdAt: number|null, modifiedAt: number|null, expiresAt: number|null, attributes: object|null}|null}
+   */
+  statSync: (key) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    return parseStat(JSIPureStorage.statSync(key));
+  },
+  
+  /**
+   * List keys starting with a prefix along with their statSync() headers
+   * @param {string} [prefix] - Key prefix; all keys if omitted
+   * @returns {Array<object>} - Headers with a `key` property
+   */
+  listWithStatSync: (prefix = '') => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    return JSIPureStorage.listWithStatSync(prefix).map(parseStat);
+  },
+  
   /**
    * Remove an item synchronously using JSI
    * @param {string} key - The key to remove
@@ -136,27 +337,201 @@ const JSIStorage = {
   },
   
   /**
-   * Multi-get synchronously (not directly supported by JSI, composed from getItemSync)
+   * Get a handle bound to a single key for fast repeated access.
+   * The native handle keeps the resolved index slot, and the last value read
+   * is cached here, so reading an unchanged key costs a version check instead
+   * of a lookup. Objects and binary values are returned as copies.
+   * @param {string} key - The key to bind
+   * @returns {object} - Handle with get(), set(), remove() and subscribe()
+   */
+  key: (key) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    const handle = JSIPureStorage.key(key);
+    let cachedVersion = -1;
+    let cachedValue = null;
+    
+    const keyHandle = {
+      key,
+      
+      get: (options = {}) => {
+        try {
+          const version = handle.version;
+          if (version !== cachedVersion) {
+            const result = handle.get();
+            cachedValue = result ? deserializeValue(result) : null;
+            cachedVersion = version;
+          }
+          
+          if (cachedValue === null && options.default !== undefined) {
+            return options.default;
+          }
+          return copyValue(cachedValue);
+        } catch (error) {
+          return options.default !== undefined ? options.default : null;
+        }
+      },
+      
+      set: (value, options = {}) => {
+        try {
+          const serialized = serializeValue(value);
+          return handle.set(serialized.type, serialized.value, !!options.encrypted);
+        } catch (error) {
+          return false;
+        }
+      },
+      
+      remove: () => {
+        try {
+          return handle.remove();
+        } catch (error) {
+          return false;
+        }
+      },
+      
+      subscribe: (callback) => {
+        return handle.subscribe(() => callback(keyHandle.get()));
+      }
+    };
+    
+    return keyHandle;
+  },
+  
+  /**
+   * Load keys into the native cache on a background thread, so later
+   * synchronous reads of them don't have to reach platform storage
+   * @param {string[]|string} keysOrPrefix - Keys to load, or a key prefix
+   * @returns {Promise<number>} - Number of the keys that exist
+   */
+  prefetchAsync: (keysOrPrefix) => {
+    if (!isJSIAvailable) {
+      return Promise.reject(new Error('JSI synchronous storage is not available'));
+    }
+    
+    try {
+      return JSIPureStorage.prefetchAsync(keysOrPrefix);
+    } catch (error) {
+      return Promise.reject(error);
+    }
+  },
+  
+  /**
+   * Configure how the native engine stores a namespace
+   * @param {string} name - Namespace, i.e. the part of keys before the first ':'
+   * @param {object} config - durability, compression, encryption, cacheBytes, ttlDefault, hideKeys, quotaBytes, maxValueBytes
+   */
+  configureNamespace: (name, config = {}) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    JSIPureStorage.configureNamespace(name, config);
+  },
+  
+  /**
+   * Crypto-shred a namespace by destroying its data key
+   * @param {string} name - Namespace, i.e. the part of keys before the first ':'
+   * @returns {boolean} - Success
+   */
+  shredNamespace: (name) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    return JSIPureStorage.shredNamespace(name);
+  },
+  
+  /**
+   * Get per-namespace storage usage
+   * @returns {object} - Usage keyed by namespace
+   */
+  getNamespaceStats: () => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    return JSIPureStorage.getNamespaceStats();
+  },
+  
+  /**
+   * Write out writes the engine is still buffering for 'async' namespaces
+   * @returns {boolean} - True once nothing is left buffered
+   */
+  flushSync: () => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    return JSIPureStorage.flushSync();
+  },
+  
+  /**
+   * Stage the sync writes of each JS task and commit them together once it ends
+   * @param {boolean} enabled - Whether to batch writes
+   * @returns {boolean} - Whether batching is on
+   */
+  setWriteBatching: (enabled) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    return JSIPureStorage.setWriteBatching(!!enabled);
+  },
+  
+  /**
+   * Get native engine metrics
+   * @returns {object} - Engine metrics, e.g. how long opening storage took
+   */
+  getMetrics: () => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    return JSIPureStorage.getMetrics();
+  },
+  
+  /**
+   * Multi-get synchronously in one native call
    * @param {string[]} keys - Array of keys to get
-   * @param {object} options - Storage options
-   * @returns {object} - Object mapping keys to values
+   * @param {object} options - Storage options; `format` is 'object' (default), 'columns' or 'packed'
+   * @returns {object} - Object mapping keys to values, or the columns of the batch
    */
   multiGetSync: (keys, options = {}) => {
     if (!isJSIAvailable) {
       throw new Error('JSI synchronous storage is not available');
     }
     
+    const format = options.format || 'object';
     try {
-      const result = {};
-      for (const key of keys) {
-        result[key] = JSIStorage.getItemSync(key, options);
-      }
-      return result;
+      const columns = JSIPureStorage.multiGetColumnsSync(keys, format === 'packed');
+      return formatColumns(keys, columns, format, options);
     } catch (error) {
+      // Rather than returning columns that don't line up with `keys`
+      if (format !== 'object') {
+        throw error;
+      }
       return {};
     }
   },
   
+  /**
+   * Read every key starting with a prefix, in key order, in one native call
+   * @param {string} [prefix] - Key prefix; all keys if omitted
+   * @param {object} options - `format` is 'columns' (default), 'packed' or 'object'
+   * @returns {object} - The columns of the batch, or an object mapping keys to values
+   */
+  scanSync: (prefix = '', options = {}) => {
+    if (!isJSIAvailable) {
+      throw new Error('JSI synchronous storage is not available');
+    }
+    
+    const format = options.format || 'columns';
+    const columns = JSIPureStorage.scanColumnsSync(prefix, format === 'packed');
+    return formatColumns(columns.keys, columns, format, options);
+  },
+  
   /**
    * Multi-set synchronously (not directly supported by JSI, composed from setItemSync)
    * @param {object} items - Object mapping keys to values
@@ -0,0 +1,71 @@
+/**
+ * Native module lookup for PureStorage
+ *
+ * Installs the JSI bindings where nothing has yet (bridgeless apps have no
+ * bridge to install them through) and picks the module behind the async API.
+ */
+
+import { NativeModules, TurboModuleRegistry } from 'react-native';
+
+const { RNPureStorage, RNJSIPureStorage } = NativeModules;
+
+const TURBO_MODULE_NAME = 'PureStorageTurboModule';
+
+// The C++ TurboModule: registered with the TurboModule manager on iOS under
+// the New Architecture, installed as a global by the JSI install otherwise
+const findTurboModule = () => {
+  const registered = TurboModuleRegistry && TurboModuleRegistry.get
+    ? TurboModuleRegistry.get(TURBO_MODULE_NAME)
+    : null;
+  if (registered && typeof registered.setItem === 'function') {
+    return registered;
+  }
+
+  const installed = global[TURBO_MODULE_NAME];
+  return installed && typeof installed.setItem === 'function' ? installed : null;
+};
+
+/**
+ * Install global.JSIPureStorage if it isn't there yet
+ * @returns {boolean} - Whether the JSI bindings are installed
+ */
+export const installJSIBindings = () => {
+  if (global.JSIPureStorage) {
+    return true;
+  }
+
+  try {
+    const turboModule = findTurboModule();
+    if (turboModule && typeof turboModule.install === 'function') {
+      turboModule.install();
+    } else if (RNJSIPureStorage && typeof RNJSIPureStorage.install === 'function') {
+      RNJSIPureStorage.install();
+    }
+  } catch (error) {
+    console.warn('PureStorage: Failed to install JSI bindings', error);
+  }
+
+  return !!global.JSIPureStorage;
+};
+
+// Only the TurboModule is remembered, since it can be installed after the first call
+let asyncModule = null;
+
+/**
+ * The module behind the async API: the C++ TurboModule on the native engine
+ * when there is one, so calls skip bridge serialization and share the engine's
+ * cache with the sync API; the legacy bridge module otherwise
+ * @returns {object|undefined} - The module
+ */
+export const getAsyncModule = () => {
+  if (!asyncModule) {
+    asyncModule = findTurboModule();
+  }
+  return asyncModule || RNPureStorage;
+};
+
+/**
+ * Whether the async API runs on the C++ TurboModule
+ * @returns {boolean}
+ */
+export const isTurboModuleAvailable = () => !!findTurboModule();
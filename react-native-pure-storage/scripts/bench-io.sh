@@ -0,0 +1,20 @@
+#!/bin/bash
+
+# Build and run the I/O backend benchmark (Linux)
+# Usage: scripts/bench-io.sh [directory] [reads]
+# The directory should be on the device being measured; it defaults to /tmp.
+
+# Ensure we're in the right directory
+cd "$(dirname "$0")/.."
+
+BUILD_DIR="./build/bench"
+mkdir -p $BUILD_DIR
+
+${CXX:-c++} -std=c++17 -O2 -pthread \
+  -Icpp \
+  cpp/bench/IoBench.cpp \
+  cpp/IoBackend.cpp \
+  cpp/LogStorageBackend.cpp \
+  -o $BUILD_DIR/io-bench || exit 1
+
+$BUILD_DIR/io-bench "$@"
@@ -1,6 +1,7 @@
 import { NativeModules } from 'react-native';
 import { createCache, createNullCache } from './cache';
 import { StorageError, KeyError, SyncOperationError } from './errors';
+import { getAsyncModule } from './native-modules';
 
 const { RNPureStorage } = NativeModules;
 
@@ -44,6 +45,10 @@ const deserializeValue = (item) => {
     case 'boolean':
       return item.value === 'true';
     case 'object':
+      // Parsed natively when the TurboModule read a large document
+      if (item.parsed) {
+        return item.value;
+      }
       try {
         return JSON.parse(item.value);
       } catch (e) {
@@ -159,7 +164,7 @@ export class StorageInstance {
         this.cache.set(key, value);
       }
       
-      const success = await RNPureStorage.setItem(
+      const success = await getAsyncModule().setItem(
         namespacedKey,
         serialized.type,
         serialized.value,
@@ -192,7 +197,7 @@ export class StorageInstance {
       throw new KeyError('Key must be a string');
     }
     
-    if (!RNPureStorage.setItemSync) {
+    if (!RNPureStorage || !RNPureStorage.setItemSync) {
       throw new SyncOperationError();
     }
     
@@ -248,7 +253,7 @@ export class StorageInstance {
     
     try {
       const namespacedKey = this._getNamespacedKey(key);
-      const result = await RNPureStorage.getItem(namespacedKey);
+      const result = await getAsyncModule().getItem(namespacedKey);
       
       // Return default value if the key doesn't exist and a default is provided
       if (!result && options.default !== undefined) {
@@ -294,7 +299,7 @@ export class StorageInstance {
       }
     }
     
-    if (!RNPureStorage.getItemSync) {
+    if (!RNPureStorage || !RNPureStorage.getItemSync) {
       // Return default if available
       if (options.default !== undefined) {
         return options.default;
@@ -343,7 +348,7 @@ export class StorageInstance {
     
     try {
       const namespacedKey = this._getNamespacedKey(key);
-      const success = await RNPureStorage.removeItem(namespacedKey);
+      const success = await getAsyncModule().removeItem(namespacedKey);
       
       // Emit change event if successful
       if (success) {
@@ -387,7 +392,7 @@ export class StorageInstance {
         return [namespacedKey, serializedValue.type, serializedValue.value];
       });
       
-      const success = await RNPureStorage.multiSet(serialized, encrypted);
+      const success = await getAsyncModule().multiSet(serialized, encrypted);
       
       // Emit change events if successful
       if (success) {
@@ -457,7 +462,7 @@ export class StorageInstance {
       const namespacedKeys = keysToFetch.map(key => this._getNamespacedKey(key));
       
       // Fetch from storage
-      const fetchedResults = await RNPureStorage.multiGet(namespacedKeys);
+      const fetchedResults = await getAsyncModule().multiGet(namespacedKeys);
       
       // Process results
       for (const [namespacedKey, value] of Object.entries(fetchedResults)) {
@@ -502,7 +507,7 @@ export class StorageInstance {
       const namespacedKeys = keys.map(key => this._getNamespacedKey(key));
       
       // Remove from storage
-      const success = await RNPureStorage.multiRemove(namespacedKeys);
+      const success = await getAsyncModule().multiRemove(namespacedKeys);
       
       // Emit change events if successful
       if (success) {
@@ -537,7 +542,7 @@ export class StorageInstance {
       const namespacedKeys = allKeys.map(key => this._getNamespacedKey(key));
       
       // Remove all keys
-      const success = await RNPureStorage.multiRemove(namespacedKeys);
+      const success = await getAsyncModule().multiRemove(namespacedKeys);
       
       // Emit change event if successful
       if (success) {
@@ -556,7 +561,7 @@ export class StorageInstance {
    */
   async getAllKeys() {
     try {
-      const allKeys = await RNPureStorage.getAllKeys();
+      const allKeys = await getAsyncModule().getAllKeys();
       const namespacePrefix = `${this.namespace}:`;
       
       // Filter keys for this namespace and remove the prefix
@@ -590,7 +595,7 @@ export class StorageInstance {
     
     try {
       const namespacedKey = this._getNamespacedKey(key);
-      return await RNPureStorage.hasKey(namespacedKey);
+      return await getAsyncModule().hasKey(namespacedKey);
     } catch (error) {
       throw new StorageError(`Failed to check if key exists: ${error.message}`, 'HAS_KEY_ERROR');
     }